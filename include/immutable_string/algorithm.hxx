@@ -0,0 +1,217 @@
+#pragma once
+
+
+#include <immutable_string/string.hxx>
+
+#include <ranges>
+#include <string_view>
+#include <type_traits>
+
+namespace ims
+{
+
+namespace detail
+{
+
+template <class... Ts>
+struct first_immutable_string
+{
+    using type = void;
+};
+
+template <class T, class... Ts>
+struct first_immutable_string<T, Ts...>
+{
+    using type = std::conditional_t<IsImmutableString<T>, std::remove_cvref_t<T>, typename first_immutable_string<Ts...>::type>;
+};
+
+
+template <class CharT, IsStringViewish<CharT> StringT>
+[[nodiscard]] constexpr std::basic_string_view<CharT> as_view(const StringT& str) noexcept
+{
+    return std::basic_string_view<CharT>(str.data(), str.size());
+}
+
+template <class CharT>
+[[nodiscard]] constexpr std::basic_string_view<CharT> as_view(const CharT* str) noexcept
+{
+    return std::basic_string_view<CharT>(str);
+}
+
+template <class CharT>
+[[nodiscard]] constexpr std::basic_string_view<CharT> as_view(const CharT& ch) noexcept
+{
+    return std::basic_string_view<CharT>(&ch, 1);
+}
+
+template <class StringT, class T>
+[[nodiscard]] typename StringT::allocator_type allocator_of(const T& str)
+{
+    if constexpr (std::is_same_v<std::remove_cvref_t<T>, StringT>)
+        return str.get_allocator();
+    else
+        return typename StringT::allocator_type();
+}
+
+} // namespace detail {}
+
+
+// Joins 'strings' putting 'separator' (a string, a C string or a single character) in between.
+// The output size is computed first, so there is exactly one allocation (none if the result fits into SSO).
+// A single-element range of immutable strings yields that very string, sharing its buffer.
+// The result type is the element type unless specified explicitly, e.g. join<immutable_string>(string_views, ", ").
+template <class StringT = void, std::ranges::forward_range RangeT, class SeparatorT>
+[[nodiscard]] auto join(const RangeT& strings, const SeparatorT& separator)
+{
+    using element_type = std::ranges::range_value_t<RangeT>;
+    using result_type = std::conditional_t<std::is_void_v<StringT>, element_type, StringT>;
+    static_assert(detail::IsImmutableString<result_type>, "Cannot deduce the result type, specify it explicitly");
+
+    using char_type = typename result_type::value_type;
+    using size_type = typename result_type::size_type;
+    using traits_type = typename result_type::traits_type;
+
+    auto const sep = detail::as_view<char_type>(separator);
+
+    size_type total = 0;
+    size_type count = 0;
+    for (auto& s : strings)
+    {
+        total += size_type(s.size());
+        ++count;
+    }
+
+    if (!count)
+        return result_type();
+
+    auto first = std::ranges::begin(strings);
+    if constexpr (std::is_same_v<element_type, result_type>)
+    {
+        if (count == 1)
+            return result_type(*first);
+    }
+
+    total += sep.size() * (count - 1);
+
+    return result_type::create(total, [&strings, sep](char_type* dest)
+    {
+        bool first = true;
+        for (auto& s : strings)
+        {
+            if (!first && !sep.empty())
+            {
+                traits_type::copy(dest, sep.data(), sep.size());
+                dest += sep.size();
+            }
+
+            first = false;
+            traits_type::copy(dest, s.data(), s.size());
+            dest += s.size();
+        }
+    }, detail::allocator_of<result_type>(*first));
+}
+
+// Concatenates any mix of strings, C strings and characters with exactly one allocation (none if the result fits into SSO).
+// If all but one part are empty and that one is an immutable string, it is returned as is, sharing its buffer.
+// The result type is the type of the first immutable string argument unless specified explicitly.
+template <class StringT = void, class... PartsT>
+[[nodiscard]] auto concat(const PartsT&... parts)
+{
+    using result_type = std::conditional_t<std::is_void_v<StringT>, typename detail::first_immutable_string<PartsT...>::type, StringT>;
+    static_assert(detail::IsImmutableString<result_type>, "Cannot deduce the result type, specify it explicitly");
+
+    using char_type = typename result_type::value_type;
+    using size_type = typename result_type::size_type;
+    using traits_type = typename result_type::traits_type;
+
+    std::basic_string_view<char_type> const views[] = { detail::as_view<char_type>(parts)... };
+
+    size_type total = 0;
+    size_type non_empty = 0;
+    for (auto& v : views)
+    {
+        total += v.size();
+        if (!v.empty())
+            ++non_empty;
+    }
+
+    const result_type* single = nullptr;
+    typename result_type::allocator_type allocator{};
+    bool have_allocator = false;
+    auto inspect = [&](const auto& part)
+    {
+        if constexpr (std::is_same_v<std::remove_cvref_t<decltype(part)>, result_type>)
+        {
+            if (!have_allocator)
+            {
+                allocator = part.get_allocator();
+                have_allocator = true;
+            }
+
+            if (non_empty == 1 && !part.empty())
+                single = &part;
+        }
+    };
+
+    (inspect(parts), ...);
+
+    if (single)
+        return *single;
+
+    return result_type::create(total, [&views](char_type* dest)
+    {
+        for (auto& v : views)
+        {
+            if (!v.empty())
+            {
+                traits_type::copy(dest, v.data(), v.size());
+                dest += v.size();
+            }
+        }
+    }, allocator);
+}
+
+// Replaces all non-overlapping occurrences of 'from' with 'to', scanning left to right.
+// The output size is computed first, so there is exactly one allocation (none if the result fits into SSO).
+// If there is nothing to replace, 'str' itself is returned, sharing its buffer.
+template <detail::IsImmutableString StringT, class FromT, class ToT>
+[[nodiscard]] StringT replace_all(const StringT& str, const FromT& from, const ToT& to)
+{
+    using char_type = typename StringT::value_type;
+    using size_type = typename StringT::size_type;
+    using traits_type = typename StringT::traits_type;
+    using view_type = std::basic_string_view<char_type>;
+
+    auto const src = detail::as_view<char_type>(str);
+    auto const f = detail::as_view<char_type>(from);
+    auto const t = detail::as_view<char_type>(to);
+
+    if (f.empty())
+        return str;
+
+    size_type count = 0;
+    for (auto pos = src.find(f); pos != view_type::npos; pos = src.find(f, pos + f.size()))
+        ++count;
+
+    if (!count)
+        return str;
+
+    auto const total = src.size() - count * f.size() + count * t.size();
+
+    return StringT::create(total, [src, f, t](char_type* dest)
+    {
+        size_type prev = 0;
+        for (auto pos = src.find(f); pos != view_type::npos; pos = src.find(f, prev))
+        {
+            traits_type::copy(dest, src.data() + prev, pos - prev);
+            dest += pos - prev;
+            traits_type::copy(dest, t.data(), t.size());
+            dest += t.size();
+            prev = pos + f.size();
+        }
+
+        traits_type::copy(dest, src.data() + prev, src.size() - prev);
+    }, str.get_allocator());
+}
+
+} // namespace ims {}
@@ -0,0 +1,291 @@
+#pragma once
+
+
+#include <immutable_string/string.hxx>
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+namespace ims
+{
+
+// Atomically replaceable immutable string for values that are read far more often than written
+// (configuration values, routing keys etc.).
+// Strings are published in heap nodes referenced by a single 64-bit word: [tickets:16][node pointer:48].
+// A reader takes a ticket with one fetch_add on the word, copies the string out of the node (that is one
+// more atomic increment of its buffer refcount) and returns the ticket to the node's own counter.
+// A writer swaps the word and credits the node with the tickets taken meanwhile, so a node is freed
+// only after the last reader that could have seen it is done with it; no locks, hazard pointers or epochs.
+// Nodes are pre-charged with tickets that are topped up once in a while; only this rare top-up
+// is a CAS loop, everything else on the read path is wait-free.
+// Strings of up to InlineCapacity characters are packed right into the word, with no node at all.
+// Pointers are assumed to fit into 48 bits, which holds for x86-64 and AArch64 user space.
+template <class StringT = immutable_string>
+class basic_atomic_immutable_string final
+{
+public:
+    using string_type = StringT;
+    using value_type = typename StringT::value_type;
+    using size_type = typename StringT::size_type;
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+    // 5 chars, 2 char16_t's or 1 char32_t
+    static constexpr size_type InlineCapacity = 40 / (8 * sizeof(value_type));
+
+    ~basic_atomic_immutable_string()
+    {
+        _retire(m_word.load(std::memory_order_acquire));
+    }
+
+    basic_atomic_immutable_string()
+        : m_word(_make_word(string_type()))
+    {
+    }
+
+    explicit basic_atomic_immutable_string(string_type value)
+        : m_word(_make_word(std::move(value)))
+    {
+    }
+
+    basic_atomic_immutable_string(const basic_atomic_immutable_string&) = delete;
+    basic_atomic_immutable_string& operator=(const basic_atomic_immutable_string&) = delete;
+
+    [[nodiscard]] static constexpr bool is_lock_free() noexcept
+    {
+        return true;
+    }
+
+    [[nodiscard]] string_type load() const
+    {
+        auto w = _acquire();
+        if (_is_inline(w))
+            return _unpack(w);
+
+        auto n = _node_of(w);
+        string_type result(n->value);
+        _release(n);
+        return result;
+    }
+
+    operator string_type() const
+    {
+        return load();
+    }
+
+    void store(string_type value)
+    {
+        _retire(m_word.exchange(_make_word(std::move(value)), std::memory_order_acq_rel));
+    }
+
+    basic_atomic_immutable_string& operator=(string_type value)
+    {
+        store(std::move(value));
+        return *this;
+    }
+
+    [[nodiscard]] string_type exchange(string_type value)
+    {
+        auto desired = _make_word(std::move(value));
+
+        // hold a ticket, so that the old node survives until we copy its value out
+        auto w = _acquire();
+        for (;;)
+        {
+            auto cur = m_word.load(std::memory_order_relaxed);
+            while (_same_value(cur, w))
+            {
+                if (m_word.compare_exchange_weak(cur, desired, std::memory_order_acq_rel, std::memory_order_relaxed))
+                {
+                    string_type result = _is_inline(w) ? _unpack(w) : _node_of(w)->value;
+                    _retire(cur);
+                    if (!_is_inline(w))
+                        _release(_node_of(w));
+
+                    return result;
+                }
+            }
+
+            // replaced by somebody else before we could swap it
+            if (!_is_inline(w))
+                _release(_node_of(w));
+
+            w = _acquire();
+        }
+    }
+
+    // replaces the value with 'desired' if it is equal to 'expected' (by contents);
+    // otherwise loads the current value into 'expected'
+    bool compare_exchange(string_type& expected, string_type desired)
+    {
+        std::uint64_t desired_word = 0;
+        for (;;)
+        {
+            auto w = _acquire();
+            auto const inline_value = _is_inline(w);
+            auto const n = inline_value ? nullptr : _node_of(w);
+
+            auto const equal = inline_value ? (_unpack(w) == expected) : (n->value == expected);
+            if (!equal)
+            {
+                expected = inline_value ? _unpack(w) : n->value;
+                if (n)
+                    _release(n);
+
+                if (desired_word)
+                    _retire(desired_word);
+
+                return false;
+            }
+
+            if (!desired_word)
+                desired_word = _make_word(std::move(desired));
+
+            auto cur = m_word.load(std::memory_order_relaxed);
+            while (_same_value(cur, w))
+            {
+                if (m_word.compare_exchange_weak(cur, desired_word, std::memory_order_acq_rel, std::memory_order_relaxed))
+                {
+                    _retire(cur);
+                    if (n)
+                        _release(n);
+
+                    return true;
+                }
+            }
+
+            // the value has changed in between, it might still be equal though
+            if (n)
+                _release(n);
+        }
+    }
+
+private:
+    static constexpr unsigned PointerBits = 48;
+    static constexpr std::uint64_t PointerMask = (std::uint64_t(1) << PointerBits) - 1;
+    static constexpr std::uint64_t OneTicket = std::uint64_t(1) << PointerBits;
+
+    // every node is published with this many tickets paid for in advance;
+    // the word is topped up once half of them are taken, long before its 16-bit counter overflows
+    static constexpr std::int64_t PrepaidTickets = 1 << 15;
+    static constexpr std::uint64_t TopUpThreshold = 1 << 14;
+
+    static constexpr std::uint64_t InlineTag = 0x1;
+    static constexpr unsigned InlineSizeShift = 1;
+    static constexpr unsigned InlinePayloadShift = 8;
+
+    struct node
+    {
+        // prepaid tickets + 1 for being published - tickets returned
+        std::atomic<std::int64_t> refs;
+        string_type value;
+    };
+
+    [[nodiscard]] static bool _is_inline(std::uint64_t w) noexcept
+    {
+        return (w & InlineTag) != 0;
+    }
+
+    [[nodiscard]] static node* _node_of(std::uint64_t w) noexcept
+    {
+        return reinterpret_cast<node*>(std::uintptr_t(w & PointerMask));
+    }
+
+    [[nodiscard]] static std::uint64_t _tickets(std::uint64_t w) noexcept
+    {
+        return w >> PointerBits;
+    }
+
+    // the ticket counter is meaningless for inline values, readers just keep bumping it
+    [[nodiscard]] static bool _same_value(std::uint64_t a, std::uint64_t b) noexcept
+    {
+        return (a & PointerMask) == (b & PointerMask);
+    }
+
+    [[nodiscard]] static std::uint64_t _make_word(string_type&& value)
+    {
+        auto const sz = value.size();
+        if (sz <= InlineCapacity)
+        {
+            using raw_type = typename detail::raw_from_char<value_type>::raw_type;
+
+            std::uint64_t w = InlineTag | (std::uint64_t(sz) << InlineSizeShift);
+            for (size_type i = 0; i < sz; ++i)
+                w |= std::uint64_t(static_cast<raw_type>(value.data()[i])) << (InlinePayloadShift + i * 8 * sizeof(value_type));
+
+            return w;
+        }
+
+        auto n = new node{ PrepaidTickets + 1, std::move(value) };
+        auto w = std::uint64_t(reinterpret_cast<std::uintptr_t>(n));
+        assert((w & ~PointerMask) == 0);
+        assert(!_is_inline(w));
+        return w;
+    }
+
+    [[nodiscard]] static string_type _unpack(std::uint64_t w)
+    {
+        using raw_type = typename detail::raw_from_char<value_type>::raw_type;
+
+        auto const sz = size_type((w >> InlineSizeShift) & 0x7);
+        value_type buffer[InlineCapacity ? InlineCapacity : 1];
+        for (size_type i = 0; i < sz; ++i)
+            buffer[i] = static_cast<value_type>(raw_type(w >> (InlinePayloadShift + i * 8 * sizeof(value_type))));
+
+        return string_type(buffer, sz); // SSO, no allocation
+    }
+
+    // takes a ticket and returns the word as it was
+    [[nodiscard]] std::uint64_t _acquire() const noexcept
+    {
+        auto w = m_word.fetch_add(OneTicket, std::memory_order_acquire);
+        if (!_is_inline(w) && _tickets(w) >= TopUpThreshold) [[unlikely]]
+            _top_up(w);
+
+        return w;
+    }
+
+    // moves the taken tickets from the word to the node, resetting the word's counter
+    void _top_up(std::uint64_t w) const noexcept
+    {
+        auto n = _node_of(w);
+        auto cur = m_word.load(std::memory_order_relaxed);
+        while (_same_value(cur, w) && _tickets(cur) >= TopUpThreshold)
+        {
+            auto taken = std::int64_t(_tickets(cur));
+
+            // pay first, so that the node never looks unreferenced; we hold a ticket ourselves anyway
+            n->refs.fetch_add(taken, std::memory_order_relaxed);
+            if (m_word.compare_exchange_weak(cur, cur & PointerMask, std::memory_order_relaxed))
+                return;
+
+            n->refs.fetch_sub(taken, std::memory_order_relaxed);
+        }
+    }
+
+    static void _release(node* n) noexcept
+    {
+        if (n->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete n;
+    }
+
+    // the word has just been swapped out: drops the publication reference and the tickets nobody took
+    static void _retire(std::uint64_t w) noexcept
+    {
+        if (_is_inline(w))
+            return;
+
+        auto n = _node_of(w);
+        auto const unused = 1 + PrepaidTickets - std::int64_t(_tickets(w));
+        if (n->refs.fetch_sub(unused, std::memory_order_acq_rel) == unused)
+            delete n;
+    }
+
+    mutable std::atomic<std::uint64_t> m_word;
+};
+
+
+using atomic_immutable_string = basic_atomic_immutable_string<immutable_string>;
+
+} // namespace ims {}
@@ -0,0 +1,275 @@
+#pragma once
+
+
+#include <immutable_string/string.hxx>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#if defined(IMS_SSE2)
+#include <xmmintrin.h>
+#endif
+
+namespace ims
+{
+
+namespace detail
+{
+
+template <class RangeT>
+using batch_char_t = typename std::ranges::range_value_t<RangeT>::value_type;
+
+template <class RangeT>
+concept IsStringBatch =
+    std::ranges::random_access_range<RangeT> &&
+    std::ranges::sized_range<RangeT> &&
+    IsStringViewish<std::ranges::range_value_t<RangeT>, batch_char_t<RangeT>>;
+
+// payloads this many elements ahead are requested while the current ones are processed
+inline constexpr std::size_t PrefetchDistance = 64;
+
+// hash states advanced in lockstep, so that their multiplications overlap
+inline constexpr std::size_t HashLanes = 4;
+
+inline void prefetch(const void* p) noexcept
+{
+#if defined(IMS_SSE2)
+    _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#elif defined(__GNUC__)
+    __builtin_prefetch(p);
+#endif
+}
+
+// true if the characters are inside the object itself (SSO), i.e. they came into cache along with it
+template <class StringT>
+[[nodiscard]] bool is_inline(const StringT& s) noexcept
+{
+    auto const p = reinterpret_cast<std::uintptr_t>(s.data());
+    auto const self = reinterpret_cast<std::uintptr_t>(std::addressof(s));
+    return p - self < sizeof(StringT);
+}
+
+template <class StringT>
+void prefetch_payload(const StringT& s) noexcept
+{
+    if (!is_inline(s))
+        prefetch(s.data());
+}
+
+// hashes of [first, first + count), the same as hash_bytes() gives one by one
+template <class IteratorT>
+void hash_batch(IteratorT first, std::size_t count, std::size_t* hashes) noexcept
+{
+    using char_type = typename std::iter_value_t<IteratorT>::value_type;
+
+    for (std::size_t i = 0; i < std::min(count, PrefetchDistance); ++i)
+        prefetch_payload(first[i]);
+
+    std::size_t i = 0;
+    for (; i + HashLanes <= count; i += HashLanes)
+    {
+        for (std::size_t j = i + PrefetchDistance; j < std::min(count, i + PrefetchDistance + HashLanes); ++j)
+            prefetch_payload(first[j]);
+
+        const unsigned char* p[HashLanes];
+        std::size_t bytes[HashLanes];
+        std::uint64_t h[HashLanes];
+        auto common = std::numeric_limits<std::size_t>::max();
+        for (std::size_t k = 0; k < HashLanes; ++k)
+        {
+            auto const& s = first[i + k];
+            p[k] = reinterpret_cast<const unsigned char*>(s.data());
+            bytes[k] = std::size_t(s.size()) * sizeof(char_type);
+            h[k] = HashSeed ^ bytes[k];
+            common = std::min(common, bytes[k] / sizeof(std::uint64_t));
+        }
+
+        // the words all of them have
+        for (std::size_t w = 0; w < common; ++w)
+        {
+            for (std::size_t k = 0; k < HashLanes; ++k)
+            {
+                std::uint64_t word;
+                std::memcpy(&word, p[k] + w * sizeof(word), sizeof(word));
+                h[k] = hash_round(h[k], word);
+            }
+        }
+
+        auto const done = common * sizeof(std::uint64_t);
+        for (std::size_t k = 0; k < HashLanes; ++k)
+            hashes[i + k] = std::size_t(hash_bytes_from(h[k], p[k] + done, bytes[k] - done));
+    }
+
+    for (; i < count; ++i)
+    {
+        auto const& s = first[i];
+        hashes[i] = std::size_t(hash_bytes(s.data(), std::size_t(s.size()) * sizeof(char_type)));
+    }
+}
+
+template <class TraitsT, class StringA, class StringB>
+[[nodiscard]] bool equal_strings(const StringA& a, const StringB& b) noexcept
+{
+    auto const sz = std::size_t(a.size());
+    if (sz != std::size_t(b.size()))
+        return false;
+
+    return (a.data() == b.data()) || TraitsT::compare(a.data(), b.data(), sz) == 0;
+}
+
+} // namespace detail {}
+
+
+// Batch operations over ranges of strings (immutable strings, string views etc.) with random access.
+// Scattered heap payloads make every element a cache miss; these prefetch the payloads a few elements ahead
+// and leave SSO elements alone, their characters being in the element itself.
+
+// hashes[i] gets the hash of strings[i], the same as std::hash<basic_immutable_string> gives;
+// HashLanes strings are hashed in lockstep
+template <detail::IsStringBatch RangeT>
+void hash_many(const RangeT& strings, std::span<std::size_t> hashes)
+{
+    auto const n = std::size_t(std::ranges::size(strings));
+    if (hashes.size() < n)
+        throw std::length_error("Output span is shorter than the string range");
+
+    detail::hash_batch(std::ranges::begin(strings), n, hashes.data());
+}
+
+// equal[i] tells whether a[i] == b[i]; returns the number of equal pairs.
+// Pairs of different sizes or sharing the characters are decided without touching the payloads.
+template <detail::IsStringBatch RangeA, detail::IsStringBatch RangeB>
+    requires std::is_same_v<detail::batch_char_t<RangeA>, detail::batch_char_t<RangeB>>
+std::size_t equal_many(const RangeA& a, const RangeB& b, std::span<bool> equal)
+{
+    using traits_type = typename std::ranges::range_value_t<RangeA>::traits_type;
+
+    auto const n = std::size_t(std::ranges::size(a));
+    if (std::size_t(std::ranges::size(b)) != n)
+        throw std::invalid_argument("String ranges differ in size");
+
+    if (equal.size() < n)
+        throw std::length_error("Output span is shorter than the string range");
+
+    auto const first_a = std::ranges::begin(a);
+    auto const first_b = std::ranges::begin(b);
+    auto prefetch_pair = [first_a, first_b](std::size_t i)
+    {
+        auto const& x = first_a[i];
+        auto const& y = first_b[i];
+        if (x.size() == y.size() && x.data() != y.data())
+        {
+            detail::prefetch_payload(x);
+            detail::prefetch_payload(y);
+        }
+    };
+
+    for (std::size_t i = 0; i < std::min(n, detail::PrefetchDistance); ++i)
+        prefetch_pair(i);
+
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (i + detail::PrefetchDistance < n)
+            prefetch_pair(i + detail::PrefetchDistance);
+
+        auto const e = detail::equal_strings<traits_type>(first_a[i], first_b[i]);
+        equal[i] = e;
+        count += e;
+    }
+
+    return count;
+}
+
+// positions[k] gets the index of the first string equal to needles[k], npos if there's none; returns the number found.
+// The needles go into a hash table, then the strings are hashed in chunks (see hash_many()) and looked up;
+// the scan stops once every needle has been found.
+template <detail::IsStringBatch RangeT, detail::IsStringBatch NeedlesT>
+    requires std::is_same_v<detail::batch_char_t<RangeT>, detail::batch_char_t<NeedlesT>>
+std::size_t find_many(const RangeT& strings, const NeedlesT& needles, std::span<std::size_t> positions)
+{
+    using traits_type = typename std::ranges::range_value_t<RangeT>::traits_type;
+    constexpr auto npos = std::size_t(-1);
+    constexpr std::size_t Chunk = 256;
+
+    auto const m = std::size_t(std::ranges::size(needles));
+    if (positions.size() < m)
+        throw std::length_error("Output span is shorter than the needle range");
+
+    std::fill_n(positions.begin(), m, npos);
+    if (!m)
+        return 0;
+
+    auto const needle = std::ranges::begin(needles);
+    std::vector<std::size_t> needle_hashes(m);
+    detail::hash_batch(needle, m, needle_hashes.data());
+
+    // open addressing, needle index + 1 per slot; duplicate needles are answered by their first occurrence
+    auto const mask = std::bit_ceil(m * 2) - 1;
+    std::vector<std::size_t> slots(mask + 1, 0);
+    std::vector<std::size_t> same_as(m, npos);
+    std::size_t unique = 0;
+    for (std::size_t k = 0; k < m; ++k)
+    {
+        auto slot = needle_hashes[k] & mask;
+        for (; slots[slot]; slot = (slot + 1) & mask)
+        {
+            auto const j = slots[slot] - 1;
+            if (needle_hashes[j] == needle_hashes[k] && detail::equal_strings<traits_type>(needle[j], needle[k]))
+            {
+                same_as[k] = j;
+                break;
+            }
+        }
+
+        if (same_as[k] == npos)
+        {
+            slots[slot] = k + 1;
+            ++unique;
+        }
+    }
+
+    auto const n = std::size_t(std::ranges::size(strings));
+    auto const first = std::ranges::begin(strings);
+    std::size_t hashes[Chunk];
+    std::size_t found = 0;
+    for (std::size_t c = 0; c < n && found < unique; c += Chunk)
+    {
+        auto const count = std::min(Chunk, n - c);
+        detail::hash_batch(first + std::ptrdiff_t(c), count, hashes);
+        for (std::size_t i = 0; i < count && found < unique; ++i)
+        {
+            auto const h = hashes[i];
+            for (auto slot = h & mask; slots[slot]; slot = (slot + 1) & mask)
+            {
+                auto const j = slots[slot] - 1;
+                if (needle_hashes[j] == h && positions[j] == npos && detail::equal_strings<traits_type>(first[c + i], needle[j]))
+                {
+                    positions[j] = c + i;
+                    ++found;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (std::size_t k = 0; k < m; ++k)
+    {
+        if (same_as[k] != npos)
+        {
+            positions[k] = positions[same_as[k]];
+            found += (positions[k] != npos);
+        }
+    }
+
+    return found;
+}
+
+} // namespace ims {}
@@ -0,0 +1,365 @@
+#pragma once
+
+
+#include <immutable_string/atomic_string.hxx>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ims
+{
+
+namespace detail
+{
+
+// A byte-oriented LZ77 block codec in the spirit of LZ4: no entropy coding, just literal runs and back references,
+// so that decompression is a tight copy loop. A sequence is
+//   [token: literal count:4 | match length - MinMatch:4] [more literal count...] [literals]
+//   [offset:16, little-endian] [more match length...]
+// where a nibble of 15 continues in the following bytes (255 means "add and read on"); the last sequence has literals only.
+namespace lz
+{
+
+inline constexpr std::size_t MinMatch = 4;
+inline constexpr std::size_t MaxOffset = 65535;
+inline constexpr unsigned HashBits = 14;
+
+[[nodiscard]] inline std::uint32_t load32(const unsigned char* p) noexcept
+{
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+[[nodiscard]] inline std::uint32_t hash4(std::uint32_t v, unsigned bits) noexcept
+{
+    return (v * 2654435761u) >> (32 - bits);
+}
+
+// cleared table of 1 << bits match positions; the memory is kept for the thread's next call
+[[nodiscard]] inline std::uint32_t* match_table(unsigned bits)
+{
+    thread_local std::vector<std::uint32_t> table;
+    table.assign(std::size_t(1) << bits, 0);
+    return table.data();
+}
+
+template <class ByteVectorT>
+void put_length(ByteVectorT& out, std::size_t length)
+{
+    for (; length >= 255; length -= 255)
+        out.push_back(255);
+
+    out.push_back(static_cast<unsigned char>(length));
+}
+
+template <class ByteVectorT>
+void put_sequence(ByteVectorT& out, const unsigned char* literals, std::size_t literal_count, std::size_t offset, std::size_t match_length)
+{
+    auto const match_code = match_length ? match_length - MinMatch : 0;
+    out.push_back(static_cast<unsigned char>((std::min<std::size_t>(literal_count, 15) << 4) | std::min<std::size_t>(match_code, 15)));
+    if (literal_count >= 15)
+        put_length(out, literal_count - 15);
+
+    out.insert(out.end(), literals, literals + literal_count);
+
+    if (match_length)
+    {
+        out.push_back(static_cast<unsigned char>(offset));
+        out.push_back(static_cast<unsigned char>(offset >> 8));
+        if (match_code >= 15)
+            put_length(out, match_code - 15);
+    }
+}
+
+// appends the compressed form of [src, src + size) to 'out'
+template <class ByteVectorT>
+void compress(const unsigned char* src, std::size_t size, ByteVectorT& out)
+{
+    // positions + 1, 0 meaning none; no more slots than there are positions
+    auto const bits = std::clamp(unsigned(std::bit_width(size)), 8u, HashBits);
+    auto const table = match_table(bits);
+
+    std::size_t anchor = 0;
+    std::size_t i = 0;
+    while (size >= MinMatch && i + MinMatch <= size)
+    {
+        auto const v = load32(src + i);
+        auto& slot = table[hash4(v, bits)];
+        auto const candidate = std::size_t(slot);
+        slot = std::uint32_t(i + 1);
+
+        if (!candidate || i + 1 - candidate > MaxOffset || load32(src + candidate - 1) != v)
+        {
+            ++i;
+            continue;
+        }
+
+        auto const from = candidate - 1;
+        auto length = MinMatch;
+        while (i + length < size && src[from + length] == src[i + length])
+            ++length;
+
+        put_sequence(out, src + anchor, i - anchor, i - from, length);
+        i += length;
+        anchor = i;
+    }
+
+    put_sequence(out, src + anchor, size - anchor, 0, 0);
+}
+
+[[nodiscard]] inline std::size_t get_length(const unsigned char*& p, const unsigned char* end, std::size_t nibble)
+{
+    if (nibble < 15)
+        return nibble;
+
+    std::size_t length = nibble;
+    for (;;)
+    {
+        if (p == end)
+            throw std::runtime_error("Corrupt compressed string");
+
+        auto const b = *p++;
+        length += b;
+        if (b != 255)
+            return length;
+    }
+}
+
+// fills exactly [dest, dest + size) from [src, src + src_size)
+inline void decompress(const unsigned char* src, std::size_t src_size, unsigned char* dest, std::size_t size)
+{
+    auto p = src;
+    auto const end = src + src_size;
+    std::size_t out = 0;
+    while (p != end)
+    {
+        auto const token = *p++;
+        auto const literal_count = get_length(p, end, token >> 4);
+        if (literal_count > std::size_t(end - p) || literal_count > size - out)
+            throw std::runtime_error("Corrupt compressed string");
+
+        std::memcpy(dest + out, p, literal_count);
+        p += literal_count;
+        out += literal_count;
+
+        if (p == end)
+            break;
+
+        if (end - p < 2)
+            throw std::runtime_error("Corrupt compressed string");
+
+        auto const offset = std::size_t(p[0]) | (std::size_t(p[1]) << 8);
+        p += 2;
+        auto const length = get_length(p, end, token & 15) + MinMatch;
+        if (!offset || offset > out || length > size - out)
+            throw std::runtime_error("Corrupt compressed string");
+
+        auto from = dest + out - offset;
+        auto to = dest + out;
+        if (offset >= 8 && length + 8 <= size - out)
+        {
+            // 8 bytes at a time, possibly past the match end but never past the buffer
+            for (std::size_t k = 0; k < length; k += 8)
+                std::memcpy(to + k, from + k, 8);
+        }
+        else
+        {
+            // overlapping: a run of the last 'offset' bytes
+            for (std::size_t k = 0; k < length; ++k)
+                to[k] = from[k];
+        }
+
+        out += length;
+    }
+
+    if (out != size)
+        throw std::runtime_error("Corrupt compressed string");
+}
+
+} // namespace lz {}
+
+} // namespace detail {}
+
+
+// A large, rarely read string that can be kept compressed, e.g. a cache entry.
+// compress() replaces the characters with their LZ-compressed form (a built-in LZ4-like codec, see detail::lz);
+// get() decompresses them on first access into a string that is cached and shared by all readers from then on.
+// compress_if_cold() is the policy hook for cache sweeps: it compresses entries not read for a while
+// and drops the decompressed copies of already compressed ones.
+// Memory is freed only if nobody else holds the string, as with any shared buffer.
+// get() may be called from several threads at once; compress(), compress_if_cold() and moves need exclusive access,
+// like assignment does. A moved-from object is empty.
+template <class StringT = immutable_string>
+class basic_cold_string final
+{
+public:
+    using string_type = StringT;
+    using value_type = typename StringT::value_type;
+    using size_type = typename StringT::size_type;
+    using allocator_type = typename StringT::allocator_type;
+    using clock_type = std::chrono::steady_clock;
+
+    // shorter strings aren't worth compressing
+    static constexpr size_type MinBytes = 1024;
+
+    basic_cold_string() = default;
+
+    explicit basic_cold_string(string_type str)
+        : m_cache(str)
+        , m_size(str.size())
+        , m_allocator(str.get_allocator())
+    {
+    }
+
+    basic_cold_string(const basic_cold_string&) = delete;
+    basic_cold_string& operator=(const basic_cold_string&) = delete;
+
+    basic_cold_string(basic_cold_string&& other)
+        : m_cache(other.m_cache.exchange(string_type()))
+        , m_compressed(std::move(other.m_compressed))
+        , m_size(std::exchange(other.m_size, 0))
+        , m_incompressible(std::exchange(other.m_incompressible, false))
+        , m_allocator(other.m_allocator)
+        , m_last_access(other.m_last_access.load(std::memory_order_relaxed))
+    {
+        other.m_compressed.clear();
+    }
+
+    basic_cold_string& operator=(basic_cold_string&& other)
+    {
+        if (this != &other)
+        {
+            m_cache.store(other.m_cache.exchange(string_type()));
+            m_compressed = std::move(other.m_compressed);
+            other.m_compressed.clear();
+            m_size = std::exchange(other.m_size, 0);
+            m_incompressible = std::exchange(other.m_incompressible, false);
+            m_allocator = other.m_allocator;
+            m_last_access.store(other.m_last_access.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+
+        return *this;
+    }
+
+    // the characters; decompresses them if there's no cached copy
+    [[nodiscard]] string_type get() const
+    {
+        m_last_access.store(clock_type::now().time_since_epoch().count(), std::memory_order_relaxed);
+
+        auto s = m_cache.load();
+        if (!s.empty() || m_compressed.empty())
+            return s;
+
+        auto decompressed = string_type::create(m_size, [this](value_type* dest)
+        {
+            detail::lz::decompress(m_compressed.data(), m_compressed.size(), reinterpret_cast<unsigned char*>(dest), m_size * sizeof(value_type));
+        }, m_allocator);
+
+        // somebody may have been faster
+        string_type expected;
+        if (!m_cache.compare_exchange(expected, decompressed))
+            return expected;
+
+        return decompressed;
+    }
+
+    [[nodiscard]] size_type size() const noexcept
+    {
+        return m_size;
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    [[nodiscard]] bool is_compressed() const noexcept
+    {
+        return !m_compressed.empty();
+    }
+
+    // true if compress() found that the string doesn't shrink enough; it isn't tried again
+    [[nodiscard]] bool is_incompressible() const noexcept
+    {
+        return m_incompressible;
+    }
+
+    // Compresses the string unless it's shorter than MinBytes or saves less than 1/8;
+    // returns true if the string is compressed now.
+    bool compress()
+    {
+        if (is_compressed())
+        {
+            m_cache.store(string_type());
+            return true;
+        }
+
+        auto const bytes = m_size * sizeof(value_type);
+        if (bytes < MinBytes || m_incompressible)
+            return false;
+
+        auto const s = m_cache.load();
+        _byte_vector packed{ _byte_allocator(m_allocator) };
+        packed.reserve(bytes / 2);
+        detail::lz::compress(reinterpret_cast<const unsigned char*>(s.data()), bytes, packed);
+        if (packed.size() > bytes - bytes / 8)
+        {
+            // the characters never change, so neither will the outcome
+            m_incompressible = true;
+            return false;
+        }
+
+        packed.shrink_to_fit();
+        m_compressed = std::move(packed);
+        m_cache.store(string_type());
+        return true;
+    }
+
+    // compresses (or drops the decompressed copy of) a string that hasn't been read for 'idle'
+    bool compress_if_cold(clock_type::duration idle)
+    {
+        auto const last = clock_type::time_point(clock_type::duration(m_last_access.load(std::memory_order_relaxed)));
+        if (clock_type::now() - last < idle)
+            return false;
+
+        return compress();
+    }
+
+    // the compressed characters, if any, plus the decompressed or uncompressed ones held by this object
+    [[nodiscard]] size_type memory_usage() const
+    {
+        auto const s = m_cache.load();
+        return sizeof(*this) + m_compressed.capacity() + (s.empty() ? 0 : s.size() * sizeof(value_type));
+    }
+
+    // how many bytes the compressed form takes, 0 if the string isn't compressed
+    [[nodiscard]] size_type compressed_size() const noexcept
+    {
+        return m_compressed.size();
+    }
+
+private:
+    using _byte_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<unsigned char>;
+    using _byte_vector = std::vector<unsigned char, _byte_allocator>;
+
+    mutable basic_atomic_immutable_string<string_type> m_cache; // the characters, unless they are compressed and nobody has read them since
+    _byte_vector m_compressed;
+    size_type m_size = 0;
+    bool m_incompressible = false;
+    allocator_type m_allocator;
+    mutable std::atomic<clock_type::rep> m_last_access{ clock_type::now().time_since_epoch().count() };
+};
+
+
+using cold_string = basic_cold_string<immutable_string>;
+
+} // namespace ims {}
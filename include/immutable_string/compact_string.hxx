@@ -0,0 +1,372 @@
+#pragma once
+
+
+#include <immutable_string/string.hxx>
+
+#include <algorithm>
+#include <compare>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+
+namespace ims
+{
+
+// 16-byte string in the Umbra/DuckDB layout: a 32-bit size followed by 12 bytes that hold either
+// the whole string (up to InlineCapacity characters) or its first 4 bytes (the prefix) and a tagged pointer:
+//
+//    [size:32][prefix:32][word:64]          word = [borrowed:1][null-terminated:1][offset:14][pointer:48]
+//
+// Equality checks the size and the prefix with a single 64-bit compare, and most orderings are decided
+// by the prefix, both without touching the characters out there.
+// Long strings share the buffer of the basic_immutable_string they were made from: the pointer is the buffer itself
+// and the offset locates the characters in it, so conversions either way cost just a refcount increment.
+// Substrings starting further than MaxOffset characters into their buffer are copied; literals and static storage are borrowed.
+// Pointers are assumed to fit into 48 bits, which holds for x86-64 and AArch64 user space.
+template <class StringT = immutable_string>
+class alignas(8) basic_compact_string final
+{
+public:
+    using string_type = StringT;
+    using value_type = typename StringT::value_type;
+    using traits_type = typename StringT::traits_type;
+    using allocator_type = typename StringT::allocator_type;
+    using size_type = typename StringT::size_type;
+    using const_pointer = const value_type*;
+    using view_type = std::basic_string_view<value_type, traits_type>;
+
+    static constexpr size_type InlineCapacity = 12 / sizeof(value_type);
+    static constexpr size_type PrefixLength = 4 / sizeof(value_type);
+    static constexpr size_type MaxSize = std::numeric_limits<std::uint32_t>::max();
+    static constexpr size_type MaxOffset = (size_type(1) << 14) - 1;
+
+    ~basic_compact_string()
+    {
+        _release();
+    }
+
+    constexpr basic_compact_string() noexcept
+        : m_size(0)
+        , m_chars{}
+    {
+    }
+
+    basic_compact_string(std::nullptr_t) = delete;
+
+    // copies the characters
+    template <detail::IsStringViewish<value_type> StringViewT>
+    explicit basic_compact_string(const StringViewT& str, const allocator_type& a = allocator_type())
+        : basic_compact_string()
+    {
+        _assign_copy(str.data(), size_type(str.size()), a);
+    }
+
+    explicit basic_compact_string(const value_type* str, const allocator_type& a = allocator_type())
+        : basic_compact_string(view_type(str), a)
+    {
+    }
+
+    // shares the buffer of 'str' unless the string is short enough to be stored inline
+    explicit basic_compact_string(const string_type& str)
+        : basic_compact_string()
+    {
+        auto const sz = str.size();
+        if (sz <= InlineCapacity || str._is_short())
+        {
+            _assign_copy(str.data(), sz, allocator_type());
+            return;
+        }
+
+        _check_size(sz);
+
+        auto const sd = str._get_shared_no_add_ref();
+        if (!sd)
+        {
+            // string literal or static storage
+            _set_long(str.data(), sz, _pack(str.data(), 0, str._has_null_terminator()) | Borrowed);
+            return;
+        }
+
+        auto const offset = size_type(str.data() - sd->data());
+        if (offset > MaxOffset)
+        {
+            _assign_copy(str.data(), sz, sd->get_allocator());
+            return;
+        }
+
+        sd->add_ref();
+        _set_long(str.data(), sz, _pack(sd, offset, str._has_null_terminator()));
+    }
+
+    basic_compact_string(const basic_compact_string& other) noexcept
+        : m_size(other.m_size)
+    {
+        std::memcpy(m_chars, other.m_chars, sizeof(m_chars));
+
+        auto const sd = _shared();
+        if (sd)
+            sd->add_ref();
+    }
+
+    basic_compact_string(basic_compact_string&& other) noexcept
+        : basic_compact_string()
+    {
+        swap(other);
+    }
+
+    basic_compact_string& operator=(const basic_compact_string& other) noexcept
+    {
+        basic_compact_string tmp(other);
+        swap(tmp);
+        return *this;
+    }
+
+    basic_compact_string& operator=(basic_compact_string&& other) noexcept
+    {
+        basic_compact_string tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    void swap(basic_compact_string& other) noexcept
+    {
+        std::swap(m_size, other.m_size);
+
+        value_type tmp[InlineCapacity];
+        std::memcpy(tmp, m_chars, sizeof(m_chars));
+        std::memcpy(m_chars, other.m_chars, sizeof(m_chars));
+        std::memcpy(other.m_chars, tmp, sizeof(m_chars));
+    }
+
+    friend void swap(basic_compact_string& a, basic_compact_string& b) noexcept
+    {
+        a.swap(b);
+    }
+
+    [[nodiscard]] size_type size() const noexcept
+    {
+        return m_size;
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    // not null-terminated for inline strings
+    [[nodiscard]] const_pointer data() const noexcept
+    {
+        if (_is_inline())
+            return m_chars;
+
+        auto const w = _word();
+        if (w & Borrowed)
+            return reinterpret_cast<const_pointer>(std::uintptr_t(w & PointerMask));
+
+        return _shared_of(w)->data() + ((w >> OffsetShift) & MaxOffset);
+    }
+
+    [[nodiscard]] view_type view() const noexcept
+    {
+        return view_type(data(), size());
+    }
+
+    operator view_type() const noexcept
+    {
+        return view();
+    }
+
+    // shares the buffer, no copying except for inline strings (which become SSO ones)
+    [[nodiscard]] string_type str() const
+    {
+        if (_is_inline())
+            return string_type(m_chars, m_size);
+
+        auto const w = _word();
+        if (w & Borrowed)
+            return string_type(data(), m_size, (w & NullTerminated) != 0, string_type::FromStaticStorage);
+
+        auto const sd = _shared_of(w);
+        sd->add_ref();
+        return string_type(sd, data(), m_size, (w & NullTerminated) != 0);
+    }
+
+    explicit operator string_type() const
+    {
+        return str();
+    }
+
+    [[nodiscard]] friend bool operator==(const basic_compact_string& a, const basic_compact_string& b) noexcept
+    {
+        // the size and the prefix
+        if (a._head() != b._head())
+            return false;
+
+        // the rest of an inline string, zero-padded; or the same pointer
+        if (a._word() == b._word())
+            return true;
+
+        if (a._is_inline())
+            return false;
+
+        return traits_type::compare(a.data() + PrefixLength, b.data() + PrefixLength, a.m_size - PrefixLength) == 0;
+    }
+
+    [[nodiscard]] friend std::strong_ordering operator<=>(const basic_compact_string& a, const basic_compact_string& b) noexcept
+    {
+        auto const common = std::min(a.size(), b.size());
+        if constexpr (sizeof(value_type) == 1 && std::is_same_v<traits_type, std::char_traits<value_type>>)
+        {
+            // the prefixes are zero-padded and byte characters compare as unsigned, just like big-endian integers
+            auto const pa = a._prefix_key();
+            auto const pb = b._prefix_key();
+            if (pa != pb)
+                return pa <=> pb;
+        }
+        else
+        {
+            auto const r = traits_type::compare(a.m_chars, b.m_chars, std::min(common, PrefixLength));
+            if (r)
+                return r <=> 0;
+        }
+
+        if (common > PrefixLength)
+        {
+            auto const r = traits_type::compare(a.data() + PrefixLength, b.data() + PrefixLength, common - PrefixLength);
+            if (r)
+                return r <=> 0;
+        }
+
+        return a.size() <=> b.size();
+    }
+
+private:
+    static constexpr unsigned PointerBits = 48;
+    static constexpr unsigned OffsetShift = PointerBits;
+    static constexpr std::uint64_t PointerMask = (std::uint64_t(1) << PointerBits) - 1;
+    static constexpr std::uint64_t NullTerminated = std::uint64_t(1) << 62;
+    static constexpr std::uint64_t Borrowed = std::uint64_t(1) << 63;
+
+    using _shared_data = typename string_type::_shared_data;
+
+    static_assert(PrefixLength * sizeof(value_type) == 4);
+
+    [[nodiscard]] bool _is_inline() const noexcept
+    {
+        return m_size <= InlineCapacity;
+    }
+
+    [[nodiscard]] std::uint64_t _head() const noexcept
+    {
+        std::uint64_t h;
+        std::memcpy(&h, this, sizeof(h));
+        return h;
+    }
+
+    // the rest of an inline string or the tagged pointer
+    [[nodiscard]] std::uint64_t _word() const noexcept
+    {
+        std::uint64_t w;
+        std::memcpy(&w, m_chars + PrefixLength, sizeof(w));
+        return w;
+    }
+
+    [[nodiscard]] std::uint32_t _prefix_key() const noexcept
+    {
+        auto const p = reinterpret_cast<const unsigned char*>(m_chars);
+        return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | std::uint32_t(p[3]);
+    }
+
+    [[nodiscard]] static _shared_data* _shared_of(std::uint64_t w) noexcept
+    {
+        return reinterpret_cast<_shared_data*>(std::uintptr_t(w & PointerMask));
+    }
+
+    [[nodiscard]] _shared_data* _shared() const noexcept
+    {
+        if (_is_inline())
+            return nullptr;
+
+        auto const w = _word();
+        return (w & Borrowed) ? nullptr : _shared_of(w);
+    }
+
+    [[nodiscard]] static std::uint64_t _pack(const void* p, size_type offset, bool null_terminated) noexcept
+    {
+        auto w = std::uint64_t(reinterpret_cast<std::uintptr_t>(p));
+        assert((w & ~PointerMask) == 0);
+        assert(offset <= MaxOffset);
+
+        w |= std::uint64_t(offset) << OffsetShift;
+        if (null_terminated)
+            w |= NullTerminated;
+
+        return w;
+    }
+
+    static void _check_size(size_type sz)
+    {
+        if (sz > MaxSize)
+            throw std::length_error("String is too long for basic_compact_string");
+    }
+
+    void _set_long(const_pointer str, size_type sz, std::uint64_t w) noexcept
+    {
+        m_size = std::uint32_t(sz);
+        traits_type::copy(m_chars, str, PrefixLength);
+        std::memcpy(m_chars + PrefixLength, &w, sizeof(w));
+    }
+
+    void _assign_copy(const_pointer str, size_type sz, const allocator_type& a)
+    {
+        _check_size(sz);
+
+        if (sz <= InlineCapacity)
+        {
+            m_size = std::uint32_t(sz);
+            std::memset(m_chars, 0, sizeof(m_chars));
+            if (sz)
+                traits_type::copy(m_chars, str, sz);
+
+            return;
+        }
+
+        auto sd = _shared_data::create(sz, str, sz, a);
+        if (!sd) [[unlikely]]
+            throw std::bad_alloc();
+
+        _set_long(sd->data(), sz, _pack(sd, 0, true));
+    }
+
+    void _release() noexcept
+    {
+        auto const sd = _shared();
+        if (sd)
+            sd->release();
+    }
+
+    std::uint32_t m_size;
+    value_type m_chars[InlineCapacity];
+};
+
+static_assert(sizeof(basic_compact_string<>) == 16);
+
+
+using compact_string = basic_compact_string<immutable_string>;
+using compact_wstring = basic_compact_string<immutable_wstring>;
+
+} // namespace ims {}
+
+
+template <class StringT>
+struct std::hash<ims::basic_compact_string<StringT>>
+{
+    // same as for the basic_immutable_string
+    [[nodiscard]] std::size_t operator()(const ims::basic_compact_string<StringT>& str) const noexcept
+    {
+        return static_cast<std::size_t>(ims::detail::hash_bytes(str.data(), str.size() * sizeof(typename StringT::value_type)));
+    }
+};
@@ -0,0 +1,349 @@
+#pragma once
+
+
+#include <immutable_string/string.hxx>
+
+#include <bit>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <utility>
+
+namespace ims
+{
+
+namespace detail
+{
+
+// SWAR helpers for a group of 8 control bytes packed into one 64-bit word
+struct control_group
+{
+    static constexpr unsigned Size = 8;
+
+    static constexpr std::uint64_t Ones = 0x0101010101010101ull;
+    static constexpr std::uint64_t Low7 = 0x7f7f7f7f7f7f7f7full;
+
+    static constexpr std::uint8_t Empty = 0x00;
+    static constexpr std::uint8_t Busy = 0x01; // claimed by a writer, not published yet
+    static constexpr std::uint8_t Full = 0x80; // | 7 bits of the hash
+
+    // 0x80 in every byte equal to zero, exact (no false positives)
+    [[nodiscard]] static constexpr std::uint64_t zero_bytes(std::uint64_t w) noexcept
+    {
+        return ~(((w & Low7) + Low7) | w | Low7);
+    }
+
+    [[nodiscard]] static constexpr std::uint64_t match(std::uint64_t w, std::uint8_t b) noexcept
+    {
+        return zero_bytes(w ^ (Ones * b));
+    }
+
+    [[nodiscard]] static constexpr std::uint64_t empty(std::uint64_t w) noexcept
+    {
+        return zero_bytes(w);
+    }
+
+    // index of the lowest byte marked by match()/empty()
+    [[nodiscard]] static constexpr unsigned first(std::uint64_t mask) noexcept
+    {
+        return unsigned(std::countr_zero(mask)) / 8;
+    }
+
+    [[nodiscard]] static constexpr std::uint64_t next(std::uint64_t mask) noexcept
+    {
+        return mask & (mask - 1);
+    }
+
+    [[nodiscard]] static constexpr std::uint8_t fingerprint(std::size_t hash) noexcept
+    {
+        return std::uint8_t(Full | (hash & 0x7f));
+    }
+};
+
+} // namespace detail {}
+
+
+// Concurrent insert-only hash map keyed by immutable strings.
+// Open addressing over groups of 8 slots; every slot has a control byte holding 7 bits of the key hash,
+// and a whole group is probed at once with SWAR arithmetic. Full hashes are stored per slot,
+// so growing the table never touches key payloads.
+// Lookups take no locks and do no atomic RMW operations. Inserts are serialized per lock stripe;
+// growing the table blocks inserts but not lookups. Mapped values never move, so pointers returned
+// by find()/try_emplace() stay valid for the lifetime of the map; concurrent updates of a value
+// are up to the value type (e.g. std::atomic<> counters).
+// Tables replaced by a bigger one are only freed in the destructor, because lock-free readers might still be probing them.
+template <class V, class StringT = immutable_string>
+class concurrent_string_map final
+{
+public:
+    using key_type = StringT;
+    using mapped_type = V;
+    using value_type = typename StringT::value_type;
+    using size_type = std::size_t;
+    using hasher = std::hash<StringT>;
+
+    ~concurrent_string_map()
+    {
+        auto t = m_table.load(std::memory_order_relaxed);
+        for (size_type i = 0; i <= t->mask; ++i)
+        {
+            if (t->ctrl_byte(i) & Group::Full)
+                delete t->slots[i].n;
+        }
+
+        while (t)
+        {
+            auto prev = t->retired;
+            delete t;
+            t = prev;
+        }
+    }
+
+    explicit concurrent_string_map(size_type capacity = 64)
+        : m_table(new table(_slots_for(capacity)))
+    {
+    }
+
+    concurrent_string_map(const concurrent_string_map&) = delete;
+    concurrent_string_map& operator=(const concurrent_string_map&) = delete;
+
+    [[nodiscard]] size_type size() const noexcept
+    {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    // lock-free
+    [[nodiscard]] V* find(const key_type& key) const noexcept
+    {
+        return _find(m_table.load(std::memory_order_acquire), _hash(key), key);
+    }
+
+    template <detail::IsStringViewish<value_type> StringViewT>
+    [[nodiscard]] V* find(const StringViewT& key) const noexcept
+    {
+        std::basic_string_view<value_type> view(key.data(), key.size());
+        return _find(m_table.load(std::memory_order_acquire), _hash(view), view);
+    }
+
+    // returns the mapped value and whether it was inserted; an existing value is left untouched
+    template <class... ArgsT>
+    std::pair<V*, bool> try_emplace(const key_type& key, ArgsT&&... args)
+    {
+        auto const hash = _hash(key);
+        std::unique_ptr<node> n; // survives retries, so that 'args' are consumed only once
+
+        for (;;)
+        {
+            size_type slots = 0;
+
+            {
+                std::shared_lock resize_lock(m_resize);
+                std::lock_guard stripe_lock(m_stripes[(hash >> 7) % StripeCount].m);
+
+                auto t = m_table.load(std::memory_order_relaxed);
+                if (auto existing = _find(t, hash, key))
+                    return { existing, false };
+
+                if (!n)
+                    n.reset(new node{ hash, key, V(std::forward<ArgsT>(args)...) });
+
+                // reserve a slot first, so that concurrent inserts never overfill the table
+                slots = t->mask + 1;
+                if (m_size.fetch_add(1, std::memory_order_relaxed) < _max_load(slots)) [[likely]]
+                {
+                    auto value = &n->value;
+                    _insert(t, hash, n.release());
+                    return { value, true };
+                }
+
+                m_size.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            _grow(slots);
+        }
+    }
+
+    // 'f(const key_type&, V&)' is called for every element; may run concurrently with inserts,
+    // in which case newly inserted elements may or may not be visited
+    template <class FunctionT>
+    void for_each(FunctionT&& f) const
+    {
+        auto t = m_table.load(std::memory_order_acquire);
+        for (size_type g = 0; g <= t->mask / Group::Size; ++g)
+        {
+            auto w = t->ctrl[g].load(std::memory_order_acquire);
+            for (unsigned i = 0; i < Group::Size; ++i)
+            {
+                if ((w >> (i * 8)) & Group::Full)
+                {
+                    auto n = t->slots[g * Group::Size + i].n;
+                    f(static_cast<const key_type&>(n->key), n->value);
+                }
+            }
+        }
+    }
+
+private:
+    using Group = detail::control_group;
+
+    static constexpr size_type StripeCount = 64;
+
+    struct node
+    {
+        std::size_t hash;
+        key_type key;
+        V value;
+    };
+
+    struct slot
+    {
+        std::size_t hash;
+        node* n;
+    };
+
+    struct table
+    {
+        explicit table(size_type slot_count)
+            : mask(slot_count - 1)
+            , ctrl(new std::atomic<std::uint64_t>[slot_count / Group::Size])
+            , slots(new slot[slot_count])
+        {
+            for (size_type g = 0; g < slot_count / Group::Size; ++g)
+                ctrl[g].store(0, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] std::uint8_t ctrl_byte(size_type i) const noexcept
+        {
+            return std::uint8_t(ctrl[i / Group::Size].load(std::memory_order_relaxed) >> ((i % Group::Size) * 8));
+        }
+
+        size_type const mask;
+        std::unique_ptr<std::atomic<std::uint64_t>[]> ctrl;
+        std::unique_ptr<slot[]> slots;
+        table* retired = nullptr;
+    };
+
+    struct alignas(64) stripe
+    {
+        std::mutex m;
+    };
+
+    [[nodiscard]] static size_type _slots_for(size_type capacity) noexcept
+    {
+        size_type slots = Group::Size * 2;
+        while (_max_load(slots) < capacity)
+            slots *= 2;
+
+        return slots;
+    }
+
+    [[nodiscard]] static constexpr size_type _max_load(size_type slots) noexcept
+    {
+        return slots - slots / 8;
+    }
+
+    template <class KeyT>
+    [[nodiscard]] static std::size_t _hash(const KeyT& key) noexcept
+    {
+        // same as std::hash<StringT>, so that views and strings land in the same slot
+        return static_cast<std::size_t>(detail::hash_bytes(key.data(), key.size() * sizeof(value_type)));
+    }
+
+    [[nodiscard]] static bool _equal(const key_type& stored, const key_type& key) noexcept
+    {
+        // operator== compares data pointers first,
+        // so keys sharing the same buffer never get their payloads compared
+        return stored == key;
+    }
+
+    [[nodiscard]] static bool _equal(const key_type& stored, std::basic_string_view<value_type> key) noexcept
+    {
+        return (stored.size() == key.size()) && (std::basic_string_view<value_type>(stored.data(), stored.size()) == key);
+    }
+
+    template <class KeyT>
+    [[nodiscard]] static V* _find(const table* t, std::size_t hash, const KeyT& key) noexcept
+    {
+        auto const groups_mask = t->mask / Group::Size;
+        auto const fp = Group::fingerprint(hash);
+        auto g = (hash >> 7) & groups_mask;
+
+        for (size_type step = 1;; ++step)
+        {
+            auto w = t->ctrl[g].load(std::memory_order_acquire);
+            for (auto m = Group::match(w, fp); m; m = Group::next(m))
+            {
+                auto& s = t->slots[g * Group::Size + Group::first(m)];
+                if (s.hash == hash && _equal(s.n->key, key))
+                    return &s.n->value;
+            }
+
+            // slots never get emptied, so an empty slot terminates the probe sequence
+            if (Group::empty(w))
+                return nullptr;
+
+            // triangular probing visits every group of a power-of-2 table
+            g = (g + step) & groups_mask;
+        }
+    }
+
+    static void _insert(table* t, std::size_t hash, node* n) noexcept
+    {
+        auto const groups_mask = t->mask / Group::Size;
+        auto g = (hash >> 7) & groups_mask;
+
+        for (size_type step = 1;; ++step)
+        {
+            auto w = t->ctrl[g].load(std::memory_order_relaxed);
+            while (auto e = Group::empty(w))
+            {
+                // other stripes may be claiming slots in the same group
+                auto i = Group::first(e);
+                auto claimed = w | (std::uint64_t(Group::Busy) << (i * 8));
+                if (t->ctrl[g].compare_exchange_weak(w, claimed, std::memory_order_relaxed))
+                {
+                    t->slots[g * Group::Size + i] = slot{ hash, n };
+
+                    // Busy -> fingerprint, publishes the slot to readers
+                    auto flip = std::uint64_t(Group::Busy ^ Group::fingerprint(hash)) << (i * 8);
+                    t->ctrl[g].fetch_xor(flip, std::memory_order_release);
+                    return;
+                }
+            }
+
+            g = (g + step) & groups_mask;
+        }
+    }
+
+    void _grow(size_type old_slots)
+    {
+        std::unique_lock resize_lock(m_resize);
+
+        auto old = m_table.load(std::memory_order_relaxed);
+        if (old->mask + 1 != old_slots)
+            return; // someone else has already grown the table
+
+        auto t = new table(old_slots * 2);
+        for (size_type i = 0; i < old_slots; ++i)
+        {
+            // stored hashes only, keys are never re-read
+            if (old->ctrl_byte(i) & Group::Full)
+                _insert(t, old->slots[i].hash, old->slots[i].n);
+        }
+
+        t->retired = old;
+        m_table.store(t, std::memory_order_release);
+    }
+
+    std::atomic<table*> m_table;
+    std::atomic<size_type> m_size = 0;
+    std::shared_mutex m_resize;
+    stripe m_stripes[StripeCount];
+};
+
+} // namespace ims {}
@@ -0,0 +1,189 @@
+#pragma once
+
+
+#include <immutable_string/parallel.hxx>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ims
+{
+
+struct deduplicate_options
+{
+    unsigned threads = 0; // for hashing; 0 means one per core
+
+    // strings using less than this share of their buffer (e.g. a short substring of a huge chunk)
+    // get their own exact-size copy, so that the parent can go; 0 disables detaching
+    double min_buffer_usage = 0.0;
+};
+
+struct deduplicate_report
+{
+    std::size_t strings = 0;            // looked at
+    std::size_t duplicates = 0;         // repointed to the buffer of an equal string
+    std::size_t detached = 0;           // copied out of a buffer they used too little of
+    std::size_t buffers_released = 0;   // buffers nothing refers to anymore
+    std::size_t bytes_released = 0;     // freed by releasing these buffers
+    std::size_t bytes_allocated = 0;    // taken by the detached copies
+};
+
+// Compaction pass over a collection of immutable strings, e.g. a long-lived cache:
+// equal strings are made to share a single buffer (preferably the smallest one among them),
+// and with 'min_buffer_usage' set, strings that pin a much larger buffer are detached from it.
+// Elements are hashed in parallel, the rest is a sort by hash and a linear pass.
+// Buffers also referenced from outside the range are never counted as released (they aren't).
+// The range must not be modified, and its strings must not be copied or released by other threads while this runs.
+namespace detail
+{
+
+// 'size' characters use too little of the buffer, and an exact-size copy would actually be smaller than it
+template <class SharedDataT>
+[[nodiscard]] bool worth_detaching(const SharedDataT* sd, std::size_t size, std::size_t buffer_bytes, double min_buffer_usage) noexcept
+{
+    if (!sd || double(size) >= min_buffer_usage * double(sd->capacity()))
+        return false;
+
+    return SharedDataT::allocated_bytes_for(size) < buffer_bytes;
+}
+
+} // namespace detail {}
+
+
+template <std::ranges::forward_range RangeT>
+    requires detail::IsImmutableString<std::ranges::range_value_t<RangeT>>
+deduplicate_report deduplicate(RangeT&& strings, const deduplicate_options& options = deduplicate_options())
+{
+    using string_type = std::ranges::range_value_t<RangeT>;
+    using value_type = typename string_type::value_type;
+    using view_type = std::basic_string_view<value_type, typename string_type::traits_type>;
+    using access = detail::buffer_access<string_type>;
+    using shared_data_type = typename access::shared_data_type;
+
+    deduplicate_report report;
+
+    std::vector<string_type*> items;
+    std::size_t total_chars = 0;
+    for (auto& s : strings)
+    {
+        items.push_back(std::addressof(s));
+        total_chars += s.size();
+    }
+
+    auto const n = items.size();
+    report.strings = n;
+    if (!n)
+        return report;
+
+    std::vector<std::uint64_t> hashes(n);
+    auto const parts = std::min<std::size_t>(n, detail::parts_for(total_chars * sizeof(value_type), options.threads));
+    detail::run_parts(parts, [&items, &hashes, n, parts](std::size_t part)
+    {
+        for (auto i = n * part / parts, last = n * (part + 1) / parts; i < last; ++i)
+            hashes[i] = detail::hash_bytes(items[i]->data(), items[i]->size() * sizeof(value_type));
+    });
+
+    // references held by the range; buffers also held from outside can't be released by us
+    struct buffer_info
+    {
+        std::size_t refs = 0;
+        bool external = false;
+    };
+
+    std::unordered_map<const shared_data_type*, buffer_info> buffers;
+    for (auto s : items)
+    {
+        auto sd = access::shared(*s);
+        if (sd)
+            ++buffers[sd].refs;
+    }
+
+    for (auto& [sd, info] : buffers)
+        info.external = sd->use_count() > info.refs;
+
+    auto const buffer_bytes = [](const string_type& s) -> std::size_t
+    {
+        auto sd = access::shared(s);
+        return sd ? sd->allocated_bytes() : 0;
+    };
+
+    // buffers are dropped one by one, so that the report is taken before they are gone
+    auto const reassign = [&buffers, &report](string_type& s, const string_type& value)
+    {
+        auto sd = access::shared(s);
+        if (sd)
+        {
+            auto& info = buffers[sd];
+            if (!--info.refs && !info.external)
+            {
+                ++report.buffers_released;
+                report.bytes_released += sd->allocated_bytes();
+            }
+        }
+
+        s = value;
+    };
+
+    std::vector<std::size_t> order(n);
+    for (std::size_t i = 0; i < n; ++i)
+        order[i] = i;
+
+    std::sort(order.begin(), order.end(), [&hashes, &items](std::size_t a, std::size_t b)
+    {
+        if (hashes[a] != hashes[b])
+            return hashes[a] < hashes[b];
+
+        return view_type(items[a]->data(), items[a]->size()) < view_type(items[b]->data(), items[b]->size());
+    });
+
+    for (std::size_t first = 0; first < n;)
+    {
+        auto const& head = *items[order[first]];
+        view_type const contents(head.data(), head.size());
+
+        // the group of equal strings and the one with the smallest buffer
+        auto last = first + 1;
+        auto best = first;
+        auto best_bytes = buffer_bytes(head);
+        for (; last < n && hashes[order[last]] == hashes[order[first]] && view_type(items[order[last]]->data(), items[order[last]]->size()) == contents; ++last)
+        {
+            auto bytes = buffer_bytes(*items[order[last]]);
+            if (bytes < best_bytes)
+            {
+                best = last;
+                best_bytes = bytes;
+            }
+        }
+
+        string_type canonical = *items[order[best]];
+        if (options.min_buffer_usage > 0 && detail::worth_detaching(access::shared(canonical), contents.size(), best_bytes, options.min_buffer_usage))
+        {
+            canonical = string_type(contents.data(), contents.size(), canonical.get_allocator());
+            report.bytes_allocated += buffer_bytes(canonical);
+            ++report.detached;
+            reassign(*items[order[best]], canonical);
+        }
+
+        for (auto k = first; k < last; ++k)
+        {
+            // SSO strings and literals have nothing to give back
+            auto& s = *items[order[k]];
+            if (k == best || s.data() == canonical.data() || !access::shared(s))
+                continue;
+
+            reassign(s, canonical);
+            ++report.duplicates;
+        }
+
+        first = last;
+    }
+
+    return report;
+}
+
+} // namespace ims {}
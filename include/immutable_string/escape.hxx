@@ -0,0 +1,538 @@
+#pragma once
+
+
+#include <immutable_string/transcode.hxx>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace ims
+{
+
+namespace detail
+{
+
+inline constexpr char HexDigits[] = "0123456789ABCDEF";
+
+[[nodiscard]] constexpr int hex_value(std::uint32_t c) noexcept
+{
+    if (c >= '0' && c <= '9')
+        return int(c - '0');
+
+    if (c >= 'a' && c <= 'f')
+        return int(c - 'a' + 10);
+
+    if (c >= 'A' && c <= 'F')
+        return int(c - 'A' + 10);
+
+    return -1;
+}
+
+// Escaping kernels tell the characters that need escaping, checking 16 at a time for byte strings,
+// and how to escape them.
+struct json_escape_kernel
+{
+    [[nodiscard]] bool special(std::uint32_t c) const noexcept
+    {
+        return c < 0x20 || c == '"' || c == '\\';
+    }
+
+#if defined(IMS_SSE2)
+    [[nodiscard]] __m128i special(__m128i v) const noexcept
+    {
+        auto const control = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1f)), v);
+        return _mm_or_si128(control, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))));
+    }
+#endif
+
+    [[nodiscard]] std::size_t escaped_size(std::uint32_t c) const noexcept
+    {
+        switch (c)
+        {
+        case '"': case '\\': case '\b': case '\f': case '\n': case '\r': case '\t':
+            return 2;
+        }
+
+        return 6;
+    }
+
+    template <class CharT>
+    void escape(std::uint32_t c, CharT* dest) const noexcept
+    {
+        *dest++ = CharT('\\');
+        switch (c)
+        {
+        case '"': *dest = CharT('"'); return;
+        case '\\': *dest = CharT('\\'); return;
+        case '\b': *dest = CharT('b'); return;
+        case '\f': *dest = CharT('f'); return;
+        case '\n': *dest = CharT('n'); return;
+        case '\r': *dest = CharT('r'); return;
+        case '\t': *dest = CharT('t'); return;
+        }
+
+        *dest++ = CharT('u');
+        *dest++ = CharT('0');
+        *dest++ = CharT('0');
+        *dest++ = CharT(HexDigits[c >> 4]);
+        *dest = CharT(HexDigits[c & 0xf]);
+    }
+};
+
+// everything but the RFC 3986 unreserved characters
+struct url_escape_kernel
+{
+    [[nodiscard]] bool special(std::uint32_t c) const noexcept
+    {
+        return !((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_' || c == '~');
+    }
+
+#if defined(IMS_SSE2)
+    [[nodiscard]] __m128i special(__m128i v) const noexcept
+    {
+        auto const in_range = [v](char lo, char hi)
+        {
+            auto const d = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+            return _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(char(hi - lo))), d);
+        };
+
+        auto const letters = _mm_or_si128(in_range('A', 'Z'), in_range('a', 'z'));
+        auto const marks = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('-')), _mm_cmpeq_epi8(v, _mm_set1_epi8('.'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')), _mm_cmpeq_epi8(v, _mm_set1_epi8('~'))));
+
+        auto const unreserved = _mm_or_si128(_mm_or_si128(letters, in_range('0', '9')), marks);
+        return _mm_xor_si128(unreserved, _mm_set1_epi8(-1));
+    }
+#endif
+
+    [[nodiscard]] std::size_t escaped_size(std::uint32_t) const noexcept
+    {
+        return 3;
+    }
+
+    template <class CharT>
+    void escape(std::uint32_t c, CharT* dest) const noexcept
+    {
+        dest[0] = CharT('%');
+        dest[1] = CharT(HexDigits[c >> 4]);
+        dest[2] = CharT(HexDigits[c & 0xf]);
+    }
+};
+
+// a field containing any of these must be quoted
+struct csv_special_kernel
+{
+    std::uint32_t delimiter;
+
+    [[nodiscard]] bool special(std::uint32_t c) const noexcept
+    {
+        return c == delimiter || c == '"' || c == '\n' || c == '\r';
+    }
+
+#if defined(IMS_SSE2)
+    [[nodiscard]] __m128i special(__m128i v) const noexcept
+    {
+        return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(char(delimiter))), _mm_cmpeq_epi8(v, _mm_set1_epi8('"'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+    }
+#endif
+};
+
+// quotes get doubled inside a quoted field
+struct csv_quote_kernel
+{
+    [[nodiscard]] bool special(std::uint32_t c) const noexcept
+    {
+        return c == '"';
+    }
+
+#if defined(IMS_SSE2)
+    [[nodiscard]] __m128i special(__m128i v) const noexcept
+    {
+        return _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+    }
+#endif
+
+    [[nodiscard]] std::size_t escaped_size(std::uint32_t) const noexcept
+    {
+        return 2;
+    }
+
+    template <class CharT>
+    void escape(std::uint32_t, CharT* dest) const noexcept
+    {
+        dest[0] = CharT('"');
+        dest[1] = CharT('"');
+    }
+};
+
+// position of the first character the kernel picks, or 'size'
+template <class KernelT, class CharT>
+[[nodiscard]] std::size_t find_special(const KernelT& k, const CharT* src, std::size_t size) noexcept
+{
+    std::size_t i = 0;
+
+#if defined(IMS_SSE2)
+    if constexpr (sizeof(CharT) == 1)
+    {
+        for (; i + 16 <= size; i += 16)
+        {
+            auto const mask = unsigned(_mm_movemask_epi8(k.special(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)))));
+            if (mask)
+                return i + unsigned(std::countr_zero(mask));
+        }
+    }
+#endif
+
+    for (; i < size; ++i)
+    {
+        if (k.special(code_unit(src[i])))
+            return i;
+    }
+
+    return size;
+}
+
+// Escapes [src, src + size), 'next' being the position of the first character to escape;
+// returns the escaped size and only writes to 'dest' if 'Write' is set.
+template <bool Write, class KernelT, class CharT>
+std::size_t escape_pass(const KernelT& k, const CharT* src, std::size_t size, std::size_t next, CharT* dest) noexcept
+{
+    std::size_t total = 0;
+    std::size_t i = 0;
+    for (;;)
+    {
+        if constexpr (Write)
+            std::copy(src + i, src + next, dest + total);
+
+        total += next - i;
+        if (next == size)
+            return total;
+
+        auto const c = code_unit(src[next]);
+        if constexpr (Write)
+            k.escape(c, dest + total);
+
+        total += k.escaped_size(c);
+        i = next + 1;
+        next = i + find_special(k, src + i, size - i);
+    }
+}
+
+// the input unchanged (sharing the buffer) if there's nothing to escape, an exact-size copy otherwise
+template <class KernelT, class StringT>
+[[nodiscard]] StringT escape_string(const KernelT& k, const StringT& str)
+{
+    using value_type = typename StringT::value_type;
+
+    auto const src = str.data();
+    auto const size = std::size_t(str.size());
+    auto const first = find_special(k, src, size);
+    if (first == size)
+        return str;
+
+    auto const total = escape_pass<false>(k, src, size, first, static_cast<value_type*>(nullptr));
+    return StringT::create(total, [&k, src, size, first](value_type* dest)
+    {
+        escape_pass<true>(k, src, size, first, dest);
+    }, str.get_allocator());
+}
+
+template <class KernelT, class BuilderT, class CharT>
+BuilderT& escape_append(const KernelT& k, BuilderT& b, const CharT* src, std::size_t size)
+{
+    auto const first = find_special(k, src, size);
+    if (first == size)
+        return b.append(std::basic_string_view<CharT, typename BuilderT::traits_type>(src, size));
+
+    auto const total = escape_pass<false>(k, src, size, first, static_cast<CharT*>(nullptr));
+    return b.append_with(total, [&k, src, size, first, total](CharT* dest, std::size_t)
+    {
+        escape_pass<true>(k, src, size, first, dest);
+        return total;
+    });
+}
+
+template <bool Write, class CharT>
+std::size_t csv_quote_pass(const CharT* src, std::size_t size, CharT* dest) noexcept
+{
+    csv_quote_kernel const k;
+    if constexpr (Write)
+        *dest++ = CharT('"');
+
+    auto const total = escape_pass<Write>(k, src, size, find_special(k, src, size), dest);
+    if constexpr (Write)
+        dest[total] = CharT('"');
+
+    return total + 2;
+}
+
+template <class CharT>
+[[nodiscard]] std::size_t find_char(const CharT* src, std::size_t size, CharT ch) noexcept
+{
+    auto const found = std::char_traits<CharT>::find(src, size, ch);
+    return found ? std::size_t(found - src) : size;
+}
+
+template <class CharT>
+[[nodiscard]] std::uint32_t parse_hex4(const CharT* src, std::size_t size)
+{
+    if (size < 4)
+        throw std::invalid_argument("Incomplete \\u escape sequence");
+
+    std::uint32_t v = 0;
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        auto const d = hex_value(code_unit(src[i]));
+        if (d < 0)
+            throw std::invalid_argument("Invalid \\u escape sequence");
+
+        v = (v << 4) | std::uint32_t(d);
+    }
+
+    return v;
+}
+
+// Unescapes [src, src + size), 'next' being the position of the first backslash; \uXXXX sequences
+// (including surrogate pairs) are encoded into UTF-8, UTF-16 or UTF-32 depending on the character width.
+// Returns the unescaped size and only writes to 'dest' if 'Write' is set.
+template <bool Write, class CharT>
+std::size_t json_unescape_pass(const CharT* src, std::size_t size, std::size_t next, CharT* dest)
+{
+    std::size_t total = 0;
+    std::size_t i = 0;
+    for (;;)
+    {
+        if constexpr (Write)
+            std::copy(src + i, src + next, dest + total);
+
+        total += next - i;
+        if (next == size)
+            return total;
+
+        if (next + 1 == size)
+            throw std::invalid_argument("Incomplete JSON escape sequence");
+
+        i = next + 2;
+        char32_t cp;
+        switch (code_unit(src[next + 1]))
+        {
+        case '"': cp = U'"'; break;
+        case '\\': cp = U'\\'; break;
+        case '/': cp = U'/'; break;
+        case 'b': cp = U'\b'; break;
+        case 'f': cp = U'\f'; break;
+        case 'n': cp = U'\n'; break;
+        case 'r': cp = U'\r'; break;
+        case 't': cp = U'\t'; break;
+        case 'u':
+            cp = char32_t(parse_hex4(src + i, size - i));
+            i += 4;
+            if (cp >= 0xdc00 && cp <= 0xdfff)
+                throw std::invalid_argument("Unpaired surrogate in JSON escape sequence");
+
+            if (cp >= 0xd800 && cp <= 0xdbff)
+            {
+                if (size - i < 2 || src[i] != CharT('\\') || src[i + 1] != CharT('u'))
+                    throw std::invalid_argument("Unpaired surrogate in JSON escape sequence");
+
+                auto const low = parse_hex4(src + i + 2, size - i - 2);
+                if (low < 0xdc00 || low > 0xdfff)
+                    throw std::invalid_argument("Unpaired surrogate in JSON escape sequence");
+
+                cp = char32_t(0x10000 + ((std::uint32_t(cp) - 0xd800) << 10) + (low - 0xdc00));
+                i += 6;
+            }
+            break;
+
+        default:
+            throw std::invalid_argument("Invalid JSON escape sequence");
+        }
+
+        if constexpr (Write)
+            encode(cp, dest + total);
+
+        total += encoded_size<CharT>(cp);
+        next = i + find_char(src + i, size - i, CharT('\\'));
+    }
+}
+
+template <bool Write, class CharT>
+std::size_t url_unescape_pass(const CharT* src, std::size_t size, std::size_t next, CharT* dest)
+{
+    std::size_t total = 0;
+    std::size_t i = 0;
+    for (;;)
+    {
+        if constexpr (Write)
+            std::copy(src + i, src + next, dest + total);
+
+        total += next - i;
+        if (next == size)
+            return total;
+
+        auto const hi = (next + 1 < size) ? hex_value(code_unit(src[next + 1])) : -1;
+        auto const lo = (next + 2 < size) ? hex_value(code_unit(src[next + 2])) : -1;
+        if (hi < 0 || lo < 0)
+            throw std::invalid_argument("Invalid percent-encoded sequence");
+
+        if constexpr (Write)
+            dest[total] = CharT((hi << 4) | lo);
+
+        ++total;
+        i = next + 3;
+        next = i + find_char(src + i, size - i, CharT('%'));
+    }
+}
+
+} // namespace detail {}
+
+
+// Escaping and unescaping of immutable strings for JSON, CSV and URLs.
+// Most strings need neither, and they're returned as they are, sharing the buffer; the others are measured first,
+// so there is exactly one allocation for the result. Byte strings are scanned 16 characters at a time.
+// The *_escape_to() functions append the escaped string to a builder instead.
+
+// backslash-escapes quotes, backslashes and control characters; other characters, including non-ASCII ones, are kept
+template <detail::IsImmutableString StringT>
+[[nodiscard]] StringT json_escape(const StringT& str)
+{
+    return detail::escape_string(detail::json_escape_kernel{}, str);
+}
+
+template <class BuilderT, class StringT>
+    requires detail::IsStringViewish<StringT, typename BuilderT::value_type>
+BuilderT& json_escape_to(BuilderT& b, const StringT& str)
+{
+    return detail::escape_append(detail::json_escape_kernel{}, b, str.data(), std::size_t(str.size()));
+}
+
+// throws std::invalid_argument on malformed escape sequences
+template <detail::IsImmutableString StringT>
+[[nodiscard]] StringT json_unescape(const StringT& str)
+{
+    using value_type = typename StringT::value_type;
+
+    auto const src = str.data();
+    auto const size = std::size_t(str.size());
+    auto const first = detail::find_char(src, size, value_type('\\'));
+    if (first == size)
+        return str;
+
+    auto const total = detail::json_unescape_pass<false>(src, size, first, static_cast<value_type*>(nullptr));
+    return StringT::create(total, [src, size, first](value_type* dest)
+    {
+        detail::json_unescape_pass<true>(src, size, first, dest);
+    }, str.get_allocator());
+}
+
+// quotes the field if it contains the delimiter, a quote or a line break, doubling the quotes (RFC 4180)
+template <detail::IsImmutableString StringT>
+[[nodiscard]] StringT csv_escape(const StringT& str, typename StringT::value_type delimiter = ',')
+{
+    using value_type = typename StringT::value_type;
+
+    auto const src = str.data();
+    auto const size = std::size_t(str.size());
+    if (detail::find_special(detail::csv_special_kernel{ detail::code_unit(delimiter) }, src, size) == size)
+        return str;
+
+    return StringT::create(detail::csv_quote_pass<false>(src, size, static_cast<value_type*>(nullptr)), [src, size](value_type* dest)
+    {
+        detail::csv_quote_pass<true>(src, size, dest);
+    }, str.get_allocator());
+}
+
+template <class BuilderT, class StringT>
+    requires detail::IsStringViewish<StringT, typename BuilderT::value_type>
+BuilderT& csv_escape_to(BuilderT& b, const StringT& str, typename BuilderT::value_type delimiter = ',')
+{
+    using value_type = typename BuilderT::value_type;
+
+    auto const src = str.data();
+    auto const size = std::size_t(str.size());
+    if (detail::find_special(detail::csv_special_kernel{ detail::code_unit(delimiter) }, src, size) == size)
+        return b.append(str);
+
+    auto const total = detail::csv_quote_pass<false>(src, size, static_cast<value_type*>(nullptr));
+    return b.append_with(total, [src, size, total](value_type* dest, std::size_t)
+    {
+        detail::csv_quote_pass<true>(src, size, dest);
+        return total;
+    });
+}
+
+// removes the quotes around a field and undoubles the quotes inside; a quoted field with no quotes inside
+// is a substring sharing the buffer. Throws std::invalid_argument on a lone quote inside a quoted field.
+template <detail::IsImmutableString StringT>
+[[nodiscard]] StringT csv_unescape(const StringT& str)
+{
+    using value_type = typename StringT::value_type;
+
+    auto const size = std::size_t(str.size());
+    if (size < 2 || str[0] != value_type('"') || str[size - 1] != value_type('"'))
+        return str;
+
+    auto const src = str.data() + 1;
+    auto const inner = size - 2;
+    std::size_t quotes = 0;
+    for (auto i = detail::find_char(src, inner, value_type('"')); i < inner; i = i + 2 + detail::find_char(src + i + 2, inner - i - 2, value_type('"')))
+    {
+        if (i + 1 == inner || src[i + 1] != value_type('"'))
+            throw std::invalid_argument("Lone quote inside a quoted CSV field");
+
+        ++quotes;
+    }
+
+    if (!quotes)
+        return str.substr(1, inner);
+
+    return StringT::create(inner - quotes, [src, inner](value_type* dest)
+    {
+        for (std::size_t i = 0; i < inner; ++i)
+        {
+            *dest++ = src[i];
+            i += (src[i] == value_type('"'));
+        }
+    }, str.get_allocator());
+}
+
+// percent-encodes everything but the unreserved characters (RFC 3986); bytes only, so UTF-8 gets encoded byte by byte
+template <detail::IsImmutableString StringT>
+    requires (sizeof(typename StringT::value_type) == 1)
+[[nodiscard]] StringT url_escape(const StringT& str)
+{
+    return detail::escape_string(detail::url_escape_kernel{}, str);
+}
+
+template <class BuilderT, class StringT>
+    requires (sizeof(typename BuilderT::value_type) == 1) && detail::IsStringViewish<StringT, typename BuilderT::value_type>
+BuilderT& url_escape_to(BuilderT& b, const StringT& str)
+{
+    return detail::escape_append(detail::url_escape_kernel{}, b, str.data(), std::size_t(str.size()));
+}
+
+// decodes %XX sequences ('+' is kept as it is); throws std::invalid_argument on malformed ones
+template <detail::IsImmutableString StringT>
+    requires (sizeof(typename StringT::value_type) == 1)
+[[nodiscard]] StringT url_unescape(const StringT& str)
+{
+    using value_type = typename StringT::value_type;
+
+    auto const src = str.data();
+    auto const size = std::size_t(str.size());
+    auto const first = detail::find_char(src, size, value_type('%'));
+    if (first == size)
+        return str;
+
+    auto const total = detail::url_unescape_pass<false>(src, size, first, static_cast<value_type*>(nullptr));
+    return StringT::create(total, [src, size, first](value_type* dest)
+    {
+        detail::url_unescape_pass<true>(src, size, first, dest);
+    }, str.get_allocator());
+}
+
+} // namespace ims {}
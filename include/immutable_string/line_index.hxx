@@ -0,0 +1,316 @@
+#pragma once
+
+
+#include <immutable_string/parallel.hxx>
+
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace ims
+{
+
+namespace detail
+{
+
+// calls 'f(pos)' with the position right past every 'delimiter' in [data + first, data + last), in order
+template <class CharT, class FunctionT>
+void for_each_delimiter(const CharT* data, std::size_t first, std::size_t last, CharT delimiter, FunctionT&& f)
+{
+    auto i = first;
+
+#if defined(IMS_SSE2)
+    constexpr std::size_t PerVector = 16 / sizeof(CharT);
+    __m128i d;
+    if constexpr (sizeof(CharT) == 1)
+        d = _mm_set1_epi8(static_cast<char>(delimiter));
+    else if constexpr (sizeof(CharT) == 2)
+        d = _mm_set1_epi16(static_cast<short>(delimiter));
+    else
+        d = _mm_set1_epi32(static_cast<int>(delimiter));
+
+    for (; i + PerVector <= last; i += PerVector)
+    {
+        auto const v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i eq;
+        if constexpr (sizeof(CharT) == 1)
+            eq = _mm_cmpeq_epi8(v, d);
+        else if constexpr (sizeof(CharT) == 2)
+            eq = _mm_cmpeq_epi16(v, d);
+        else
+            eq = _mm_cmpeq_epi32(v, d);
+
+        // sizeof(CharT) bits per character
+        auto mask = unsigned(_mm_movemask_epi8(eq));
+        while (mask)
+        {
+            auto const bit = unsigned(std::countr_zero(mask));
+            f(i + bit / sizeof(CharT) + 1);
+            mask &= ~(((1u << sizeof(CharT)) - 1) << bit);
+        }
+    }
+#endif
+
+    for (; i < last; ++i)
+    {
+        if (data[i] == delimiter)
+            f(i + 1);
+    }
+}
+
+} // namespace detail {}
+
+
+// Offsets of the lines (or any delimited records) of a string, so that line N is a zero-copy substring in O(1).
+// The delimiter scan is vectorized and runs on up to 'threads' threads (0 means one per core) for large strings.
+// Every SampleInterval-th line start is kept as is, the others as 32-bit deltas from it, i.e. about 4 bytes per line.
+// Lines don't include the delimiter; the text after the last delimiter is a line too, unless it's empty.
+// The index keeps a reference to the string. append() grows it in place while the index is its only owner
+// (no lines obtained from it are alive), see basic_immutable_string::with_appended(); extend() takes a string grown elsewhere.
+template <class StringT = immutable_string>
+class basic_line_index final
+{
+public:
+    using string_type = StringT;
+    using value_type = typename StringT::value_type;
+    using traits_type = typename StringT::traits_type;
+    using size_type = std::size_t;
+    using view_type = std::basic_string_view<value_type, traits_type>;
+
+    static constexpr size_type SampleInterval = 64;
+
+    basic_line_index() noexcept = default;
+
+    explicit basic_line_index(const string_type& source, value_type delimiter = value_type('\n'), unsigned threads = 0)
+        : m_delimiter(delimiter)
+    {
+        extend(source, threads);
+    }
+
+    [[nodiscard]] size_type size() const noexcept
+    {
+        auto const delimiters = _delimiters();
+        return delimiters + (_start(delimiters) < m_source.size() ? 1 : 0);
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return m_source.empty();
+    }
+
+    [[nodiscard]] string_type operator[](size_type i) const
+    {
+        assert(i < size());
+        auto const first = _start(i);
+        return m_source.substr(first, _end(i) - first);
+    }
+
+    [[nodiscard]] string_type at(size_type i) const
+    {
+        if (i >= size())
+            throw std::out_of_range("basic_line_index index out of range");
+
+        return (*this)[i];
+    }
+
+    [[nodiscard]] view_type view(size_type i) const noexcept
+    {
+        assert(i < size());
+        auto const first = _start(i);
+        return view_type(m_source.data() + first, _end(i) - first);
+    }
+
+    // where line 'i' starts in the source
+    [[nodiscard]] size_type offset(size_type i) const noexcept
+    {
+        assert(i < size());
+        return _start(i);
+    }
+
+    [[nodiscard]] const string_type& source() const noexcept
+    {
+        return m_source;
+    }
+
+    [[nodiscard]] value_type delimiter() const noexcept
+    {
+        return m_delimiter;
+    }
+
+    // Indexes 'grown', which must begin with the string indexed so far (e.g. a log that has been appended to).
+    // Only the new part is scanned; the line that had no delimiter yet gets completed.
+    void extend(const string_type& grown, unsigned threads = 0)
+    {
+        auto const old_size = m_source.size();
+        if (grown.size() < old_size)
+            throw std::invalid_argument("basic_line_index::extend() needs a string that begins with the indexed one");
+
+        assert(traits_type::compare(grown.data(), m_source.data(), old_size) == 0);
+
+        _index(grown, old_size, threads);
+        m_source = grown;
+    }
+
+    // appends 'text' to the source and indexes it
+    template <detail::IsStringViewish<value_type> StringViewT>
+    void append(const StringViewT& text, unsigned threads = 0)
+    {
+        auto const old_size = m_source.size();
+        auto grown = std::move(m_source).with_appended(text);
+        try
+        {
+            _index(grown, old_size, threads);
+        }
+        catch (...)
+        {
+            m_source = grown.substr(0, old_size);
+            throw;
+        }
+
+        m_source = std::move(grown);
+    }
+
+    // what the index takes in memory, including spare capacity; the source isn't counted
+    [[nodiscard]] size_type memory_usage() const noexcept
+    {
+        return sizeof(*this) + m_samples.capacity() * sizeof(size_type) + m_deltas.capacity() * sizeof(std::uint32_t);
+    }
+
+private:
+    [[nodiscard]] size_type _delimiters() const noexcept
+    {
+        // the first start is 0, the others follow delimiters
+        return m_deltas.empty() ? 0 : m_deltas.size() - 1;
+    }
+
+    [[nodiscard]] size_type _start(size_type k) const noexcept
+    {
+        if (k >= m_deltas.size())
+            return 0;
+
+        return m_samples[k / SampleInterval] + m_deltas[k];
+    }
+
+    [[nodiscard]] size_type _end(size_type i) const noexcept
+    {
+        return (i < _delimiters()) ? _start(i + 1) - 1 : m_source.size();
+    }
+
+    // scans [first, grown.size()); on failure the offsets are left as they were
+    void _index(const string_type& grown, size_type first, unsigned threads)
+    {
+        auto const samples = m_samples.size();
+        auto const deltas = m_deltas.size();
+        try
+        {
+            if (m_deltas.empty())
+                _push(0);
+
+            _scan(grown.data(), first, grown.size(), threads);
+        }
+        catch (...)
+        {
+            m_samples.resize(samples);
+            m_deltas.resize(deltas);
+            throw;
+        }
+    }
+
+    void _push(size_type pos)
+    {
+        auto const k = m_deltas.size();
+        if (k % SampleInterval == 0)
+        {
+            m_samples.push_back(pos);
+            m_deltas.push_back(0);
+            return;
+        }
+
+        m_deltas.push_back(_delta(pos, m_samples.back()));
+    }
+
+    void _scan(const value_type* data, size_type first, size_type last, unsigned threads)
+    {
+        auto const delimiter = m_delimiter;
+        auto const parts = detail::partition(data + first, last - first, detail::parts_for(last - first, threads));
+        if (parts.size() < 2)
+        {
+            detail::for_each_delimiter(data, first, last, delimiter, [this](size_type pos) { _push(pos); });
+            return;
+        }
+
+        // count first, then every part writes its offsets straight into place
+        std::vector<size_type> firsts(parts.size() + 1, 0);
+        detail::run_parts(parts.size(), [&](std::size_t i)
+        {
+            size_type count = 0;
+            detail::for_each_delimiter(data, first + parts[i].first, first + parts[i].last, delimiter, [&count](size_type) { ++count; });
+            firsts[i + 1] = count;
+        });
+
+        firsts[0] = m_deltas.size();
+        for (std::size_t i = 0; i < parts.size(); ++i)
+            firsts[i + 1] += firsts[i];
+
+        m_deltas.resize(firsts.back());
+        m_samples.resize((firsts.back() + SampleInterval - 1) / SampleInterval);
+
+        // lines whose sample is found by a previous part are done afterwards, there are less than SampleInterval of them per part
+        std::vector<std::vector<size_type>> pending(parts.size());
+        detail::run_parts(parts.size(), [&](std::size_t i)
+        {
+            auto k = firsts[i];
+            detail::for_each_delimiter(data, first + parts[i].first, first + parts[i].last, delimiter, [&](size_type pos)
+            {
+                auto const sample = k - k % SampleInterval;
+                if (sample == k)
+                {
+                    m_samples[k / SampleInterval] = pos;
+                    m_deltas[k] = 0;
+                }
+                else if (sample >= firsts[i])
+                {
+                    m_deltas[k] = _delta(pos, m_samples[k / SampleInterval]);
+                }
+                else
+                {
+                    pending[i].push_back(pos);
+                }
+
+                ++k;
+            });
+        });
+
+        for (std::size_t i = 0; i < parts.size(); ++i)
+        {
+            auto k = firsts[i];
+            for (auto pos : pending[i])
+            {
+                m_deltas[k] = _delta(pos, m_samples[k / SampleInterval]);
+                ++k;
+            }
+        }
+    }
+
+    [[nodiscard]] static std::uint32_t _delta(size_type pos, size_type sample)
+    {
+        auto const delta = pos - sample;
+        if (delta > std::numeric_limits<std::uint32_t>::max())
+            throw std::length_error("basic_line_index lines are too long for 32-bit deltas");
+
+        return std::uint32_t(delta);
+    }
+
+    string_type m_source;
+    std::vector<size_type> m_samples;
+    std::vector<std::uint32_t> m_deltas;
+    value_type m_delimiter = value_type('\n');
+};
+
+
+using line_index = basic_line_index<immutable_string>;
+
+} // namespace ims {}
@@ -0,0 +1,435 @@
+#pragma once
+
+
+#include <immutable_string/string.hxx>
+
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+namespace ims
+{
+
+namespace detail
+{
+
+inline constexpr std::uint64_t PowersOf10[] =
+{
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+    10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull, 1000000000000000ull,
+    10000000000000000ull, 100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull
+};
+
+// the most digits any value fits into std::uint64_t
+inline constexpr std::size_t MaxSafeDigits = 19;
+
+// Validates and converts up to 8 digits at once (SWAR): the digits are loaded into a word
+// after as many '0' as are missing, then adjacent digits are combined pairwise in three multiplications.
+// 'avail' is how many characters starting at 'src' may be read, at least 'n'; with 8 of them a single load does.
+[[nodiscard]] inline bool parse_8_digits(const char* src, std::size_t n, std::size_t avail, std::uint32_t& value) noexcept
+{
+    assert(n <= 8 && n <= avail);
+
+    constexpr std::uint64_t Zeros = 0x3030303030303030ull;
+
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        std::uint64_t w;
+        if (n == 0)
+        {
+            w = Zeros;
+        }
+        else if (avail >= 8)
+        {
+            std::memcpy(&w, src, 8);
+            if (n < 8)
+                w = (w << (8 * (8 - n))) | (Zeros >> (8 * n));
+        }
+        else if (n >= 4)
+        {
+            // two overlapping halves
+            std::uint32_t lo;
+            std::uint32_t hi;
+            std::memcpy(&lo, src, 4);
+            std::memcpy(&hi, src + n - 4, 4);
+            w = (std::uint64_t(hi) << 32) | ((std::uint64_t(lo) << (8 * (8 - n))) & 0xffffffffull) | (Zeros >> (8 * n));
+        }
+        else
+        {
+            w = Zeros >> (8 * n);
+            for (std::size_t i = 0; i < n; ++i)
+                w |= std::uint64_t(std::uint8_t(src[i])) << (8 * (8 - n + i));
+        }
+
+        // every byte in ['0', '9']: the high nibble is 3, and adding 6 doesn't carry into it
+        if (((w & 0xf0f0f0f0f0f0f0f0ull) | (((w + 0x0606060606060606ull) & 0xf0f0f0f0f0f0f0f0ull) >> 4)) != 0x3333333333333333ull)
+            return false;
+
+        w = ((w & 0x0f0f0f0f0f0f0f0full) * 2561) >> 8;
+        w = ((w & 0x00ff00ff00ff00ffull) * 6553601) >> 16;
+        value = std::uint32_t(((w & 0x0000ffff0000ffffull) * 42949672960001ull) >> 32);
+        return true;
+    }
+    else
+    {
+        std::uint32_t v = 0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            auto const d = unsigned(src[i]) - '0';
+            if (d > 9)
+                return false;
+
+            v = v * 10 + d;
+        }
+
+        value = v;
+        return true;
+    }
+}
+
+// up to MaxSafeDigits digits, 8 at a time
+[[nodiscard]] inline bool parse_digits(const char* src, std::size_t n, std::size_t avail, std::uint64_t& value) noexcept
+{
+    assert(n <= MaxSafeDigits && n <= avail);
+
+    auto const head = (n % 8) ? (n % 8) : std::min<std::size_t>(n, 8);
+    std::uint32_t chunk;
+    if (!parse_8_digits(src, head, avail, chunk))
+        return false;
+
+    std::uint64_t v = chunk;
+    for (auto i = head; i < n; i += 8)
+    {
+        if (!parse_8_digits(src + i, 8, avail - i, chunk))
+            return false;
+
+        v = v * 100000000ull + chunk;
+    }
+
+    value = v;
+    return true;
+}
+
+[[nodiscard]] inline std::size_t skip_zeros(const char* src, std::size_t n) noexcept
+{
+    std::size_t i = 0;
+    while (i < n && src[i] == '0')
+        ++i;
+
+    return i;
+}
+
+// the magnitude of an unsigned decimal number of any length, if it fits into std::uint64_t
+[[nodiscard]] inline std::errc parse_magnitude(const char* src, std::size_t n, std::uint64_t& value) noexcept
+{
+    if (!n)
+        return std::errc::invalid_argument;
+
+    auto const zeros = skip_zeros(src, n);
+    src += zeros;
+    n -= zeros;
+    if (n <= MaxSafeDigits)
+        return parse_digits(src, n, n, value) ? std::errc() : std::errc::invalid_argument;
+
+    if (n > MaxSafeDigits + 1)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (unsigned(src[i]) - '0' > 9)
+                return std::errc::invalid_argument;
+        }
+
+        return std::errc::result_out_of_range;
+    }
+
+    // one more digit may still fit
+    std::uint64_t head;
+    if (!parse_digits(src, MaxSafeDigits, n, head) || !parse_digits(src + MaxSafeDigits, 1, 1, value))
+        return std::errc::invalid_argument;
+
+    if (head > (std::numeric_limits<std::uint64_t>::max() - value) / 10)
+        return std::errc::result_out_of_range;
+
+    value += head * 10;
+    return std::errc();
+}
+
+template <class IntT>
+[[nodiscard]] std::errc parse_integer(const char* src, std::size_t n, IntT& value) noexcept
+{
+    using unsigned_type = std::make_unsigned_t<IntT>;
+
+    bool negative = false;
+    if constexpr (std::is_signed_v<IntT>)
+    {
+        if (n && *src == '-')
+        {
+            negative = true;
+            ++src;
+            --n;
+        }
+    }
+
+    std::uint64_t m;
+    auto const e = parse_magnitude(src, n, m);
+    if (e != std::errc())
+        return e;
+
+    // the magnitude of the smallest value of a signed type is one more than the largest one
+    auto const limit = std::uint64_t(std::numeric_limits<IntT>::max()) + (negative ? 1 : 0);
+    if (m > limit)
+        return std::errc::result_out_of_range;
+
+    value = negative ? IntT(unsigned_type(0) - unsigned_type(m)) : IntT(m);
+    return std::errc();
+}
+
+// '[-]digits[.digits]' scaled by 10^scale, with the extra fractional digits truncated
+[[nodiscard]] inline std::errc parse_decimal(const char* src, std::size_t n, unsigned scale, std::int64_t& value) noexcept
+{
+    bool negative = false;
+    if (n && *src == '-')
+    {
+        negative = true;
+        ++src;
+        --n;
+    }
+
+    auto const dot = static_cast<const char*>(std::memchr(src, '.', n));
+    auto const int_len = dot ? std::size_t(dot - src) : n;
+    auto frac = dot ? dot + 1 : src + n;
+    auto frac_len = dot ? n - int_len - 1 : 0;
+    if (!int_len && !frac_len)
+        return std::errc::invalid_argument;
+
+    // the truncated digits must still be digits
+    if (frac_len > scale)
+    {
+        for (auto p = frac + scale; p != frac + frac_len; ++p)
+        {
+            if (unsigned(*p) - '0' > 9)
+                return std::errc::invalid_argument;
+        }
+
+        frac_len = scale;
+    }
+
+    std::uint64_t int_part = 0;
+    if (int_len)
+    {
+        auto const e = parse_magnitude(src, int_len, int_part);
+        if (e != std::errc())
+            return e;
+    }
+
+    std::uint64_t frac_part = 0;
+    if (frac_len && !parse_digits(frac, frac_len, frac_len, frac_part))
+        return std::errc::invalid_argument;
+
+    auto const limit = std::uint64_t(std::numeric_limits<std::int64_t>::max()) + (negative ? 1 : 0);
+    auto const multiplier = PowersOf10[scale];
+    if (int_part > limit / multiplier)
+        return std::errc::result_out_of_range;
+
+    auto const m = int_part * multiplier;
+    auto const f = frac_part * PowersOf10[scale - frac_len];
+    if (f > limit - m)
+        return std::errc::result_out_of_range;
+
+    value = negative ? std::int64_t(std::uint64_t(0) - (m + f)) : std::int64_t(m + f);
+    return std::errc();
+}
+
+template <class FloatT>
+struct float_fast_path;
+
+template <>
+struct float_fast_path<double>
+{
+    static constexpr std::uint64_t MaxMantissa = std::uint64_t(1) << 53;
+    static constexpr int MaxExponent = 22;
+    static constexpr double Powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+};
+
+template <>
+struct float_fast_path<float>
+{
+    static constexpr std::uint64_t MaxMantissa = std::uint64_t(1) << 24;
+    static constexpr int MaxExponent = 10;
+    static constexpr float Powers[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+};
+
+// Clinger's fast path: a mantissa and a power of ten that are both exact in FloatT make a correctly rounded
+// product or quotient; everything else (long mantissas, large exponents, inf, nan, errors) goes to std::from_chars()
+template <class FloatT>
+[[nodiscard]] std::errc parse_float(const char* src, std::size_t n, FloatT& value) noexcept
+{
+    using fast = float_fast_path<FloatT>;
+
+    auto const slow = [src, n, &value]()
+    {
+        auto const r = std::from_chars(src, src + n, value);
+        if (r.ptr != src + n)
+            return std::errc::invalid_argument;
+
+        return r.ec;
+    };
+
+    auto p = src;
+    auto const end = src + n;
+    bool const negative = (p != end && *p == '-');
+    p += negative;
+
+    // the digits accumulate into the mantissa as they're scanned, 8 at a time where possible
+    std::uint64_t mantissa = 0;
+    auto const scan_digits = [&p, end, &mantissa]()
+    {
+        auto const begin = p;
+        std::uint32_t chunk;
+        while (end - p >= 8 && parse_8_digits(p, 8, 8, chunk))
+        {
+            mantissa = mantissa * 100000000ull + chunk;
+            p += 8;
+        }
+
+        while (p != end && unsigned(*p) - '0' <= 9)
+        {
+            mantissa = mantissa * 10 + unsigned(*p - '0');
+            ++p;
+        }
+
+        return std::size_t(p - begin);
+    };
+
+    auto const int_len = scan_digits();
+    std::size_t frac_len = 0;
+    if (p != end && *p == '.')
+    {
+        ++p;
+        frac_len = scan_digits();
+    }
+
+    // the mantissa may have overflowed
+    if ((!int_len && !frac_len) || int_len + frac_len > MaxSafeDigits)
+        return slow();
+
+    int exponent = 0;
+    if (p != end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+        bool const negative_exponent = (p != end && *p == '-');
+        p += (p != end && (*p == '-' || *p == '+'));
+
+        auto const exp_begin = p;
+        while (p != end && unsigned(*p) - '0' <= 9 && p - exp_begin < 4)
+        {
+            exponent = exponent * 10 + (*p - '0');
+            ++p;
+        }
+
+        if (p == exp_begin)
+            return slow();
+
+        exponent = negative_exponent ? -exponent : exponent;
+    }
+
+    if (p != end)
+        return slow();
+
+    exponent -= int(frac_len);
+    if (mantissa > fast::MaxMantissa || exponent < -fast::MaxExponent || exponent > fast::MaxExponent)
+        return slow();
+
+    auto v = FloatT(mantissa);
+    v = (exponent < 0) ? v / fast::Powers[-exponent] : v * fast::Powers[exponent];
+    value = negative ? -v : v;
+    return std::errc();
+}
+
+// runs 'parse(data, size, value)' for every token; returns the number of failures
+template <class RangeT, class ValueT, class ParseT>
+std::size_t parse_tokens(RangeT&& tokens, std::span<ValueT> values, std::span<std::errc> errors, ParseT&& parse)
+{
+    if constexpr (std::ranges::sized_range<RangeT>)
+    {
+        auto const n = std::size_t(std::ranges::size(tokens));
+        if (values.size() < n || (!errors.empty() && errors.size() < n))
+            throw std::length_error("Output spans are shorter than the token range");
+    }
+
+    std::size_t i = 0;
+    std::size_t failures = 0;
+    for (auto&& t : tokens)
+    {
+        if (i == values.size() || (!errors.empty() && i == errors.size()))
+            throw std::length_error("Output spans are shorter than the token range");
+
+        ValueT v{};
+        auto const e = parse(t.data(), std::size_t(t.size()), v);
+        values[i] = (e == std::errc()) ? v : ValueT{};
+        if (!errors.empty())
+            errors[i] = e;
+
+        failures += (e != std::errc());
+        ++i;
+    }
+
+    return failures;
+}
+
+} // namespace detail {}
+
+
+// Batch parsers for ranges of tokens (immutable strings, string views etc.), e.g. fields split out of records.
+// Every token must be a whole number in the std::from_chars() syntax (no leading '+' or whitespace).
+// values[i] gets the i-th result, 0 on failure; errors[i], if errors are wanted, gets std::errc() on success,
+// std::errc::invalid_argument for a malformed token or std::errc::result_out_of_range for one that doesn't fit.
+// Both spans must hold at least as many elements as there are tokens; the number of failures is returned.
+// Tokens may come from any input range, views yielding temporaries (e.g. std::views::transform) included;
+// bool and character types aren't integers here.
+// Digits are validated and converted 8 at a time within a 64-bit word.
+
+template <detail::IsNumber IntT, std::ranges::input_range RangeT>
+    requires std::is_integral_v<IntT> && detail::IsStringViewish<std::ranges::range_value_t<RangeT>, char>
+std::size_t parse_integers(RangeT&& tokens, std::span<IntT> values, std::span<std::errc> errors = {})
+{
+    return detail::parse_tokens(std::forward<RangeT>(tokens), values, errors, [](const char* src, std::size_t n, IntT& v)
+    {
+        return detail::parse_integer(src, n, v);
+    });
+}
+
+// fixed-point decimals: "-12.345" with scale 2 becomes -1234 (extra fractional digits are truncated)
+template <std::ranges::input_range RangeT>
+    requires detail::IsStringViewish<std::ranges::range_value_t<RangeT>, char>
+std::size_t parse_decimals(RangeT&& tokens, unsigned scale, std::span<std::int64_t> values, std::span<std::errc> errors = {})
+{
+    if (scale > detail::MaxSafeDigits - 1)
+        throw std::invalid_argument("Decimal scale is too large");
+
+    return detail::parse_tokens(std::forward<RangeT>(tokens), values, errors, [scale](const char* src, std::size_t n, std::int64_t& v)
+    {
+        return detail::parse_decimal(src, n, scale, v);
+    });
+}
+
+// correctly rounded; short mantissas with small exponents take a fast path, the rest goes to std::from_chars()
+template <std::floating_point FloatT, std::ranges::input_range RangeT>
+    requires detail::IsStringViewish<std::ranges::range_value_t<RangeT>, char> && (std::is_same_v<FloatT, float> || std::is_same_v<FloatT, double>)
+std::size_t parse_floats(RangeT&& tokens, std::span<FloatT> values, std::span<std::errc> errors = {})
+{
+    return detail::parse_tokens(std::forward<RangeT>(tokens), values, errors, [](const char* src, std::size_t n, FloatT& v)
+    {
+        return detail::parse_float(src, n, v);
+    });
+}
+
+} // namespace ims {}
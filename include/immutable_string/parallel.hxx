@@ -0,0 +1,228 @@
+#pragma once
+
+
+#include <immutable_string/string.hxx>
+
+#include <algorithm>
+#include <exception>
+#include <iterator>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace ims
+{
+
+namespace detail
+{
+
+struct text_range
+{
+    std::size_t first;
+    std::size_t last;
+};
+
+// smaller parts aren't worth a thread
+inline constexpr std::size_t MinPartSize = 64 * 1024;
+
+[[nodiscard]] inline unsigned parts_for(std::size_t size, unsigned threads) noexcept
+{
+    if (!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    return unsigned(std::clamp<std::size_t>(size / MinPartSize, 1, threads));
+}
+
+// Cuts [0, size) into up to 'parts' ranges of about the same size.
+// With 'delimiter' given, every cut is moved forward right past the next delimiter, so no record gets split in two.
+template <class CharT, class TraitsT = std::char_traits<CharT>>
+[[nodiscard]] std::vector<text_range> partition(const CharT* data, std::size_t size, unsigned parts, const CharT* delimiter = nullptr)
+{
+    std::vector<text_range> result;
+    result.reserve(parts);
+
+    std::size_t first = 0;
+    for (unsigned i = 1; i <= parts && first < size; ++i)
+    {
+        auto last = (i == parts) ? size : std::max(first, std::size_t(size / parts * i));
+        if (delimiter && last < size)
+        {
+            auto found = TraitsT::find(data + last, size - last, *delimiter);
+            last = found ? std::size_t(found - data) + 1 : size;
+        }
+
+        if (last > first)
+            result.push_back(text_range{ first, last });
+
+        first = last;
+    }
+
+    return result;
+}
+
+// runs 'f(part_index)' for every part, the calling thread takes the first one; rethrows the first exception
+template <class FunctionT>
+void run_parts(std::size_t parts, FunctionT&& f)
+{
+    std::vector<std::exception_ptr> errors(parts);
+    auto guarded = [&f, &errors](std::size_t i)
+    {
+        try
+        {
+            f(i);
+        }
+        catch (...)
+        {
+            errors[i] = std::current_exception();
+        }
+    };
+
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(parts);
+        for (std::size_t i = 1; i < parts; ++i)
+            workers.emplace_back(guarded, i);
+
+        if (parts)
+            guarded(0);
+    }
+
+    for (auto& e : errors)
+    {
+        if (e)
+            std::rethrow_exception(e);
+    }
+}
+
+} // namespace detail {}
+
+
+// Splits 'source' like basic_immutable_string::split() does, using up to 'threads' threads (0 means one per core).
+// The source is cut into per-thread ranges at delimiter boundaries, every thread collects the substrings
+// of its range into its own vector, and the vectors are then moved into the result in parallel, preserving the order.
+template <detail::IsImmutableString StringT>
+[[nodiscard]] std::vector<StringT> parallel_split(const StringT& source, typename StringT::value_type delimiter, unsigned threads = 0, bool skip_empty = true)
+{
+    using traits_type = typename StringT::traits_type;
+
+    auto const parts = detail::partition<typename StringT::value_type, traits_type>(source.data(), source.size(), detail::parts_for(source.size(), threads), &delimiter);
+
+    if (parts.size() < 2)
+    {
+        std::vector<StringT> result;
+        source.split(delimiter, std::back_inserter(result), skip_empty);
+        return result;
+    }
+
+    std::vector<std::vector<StringT>> pieces(parts.size());
+    detail::run_parts(parts.size(), [&](std::size_t i)
+    {
+        source.split(delimiter, std::back_inserter(pieces[i]), skip_empty, parts[i].first, parts[i].last);
+    });
+
+    std::vector<std::size_t> offsets(pieces.size() + 1, 0);
+    for (std::size_t i = 0; i < pieces.size(); ++i)
+        offsets[i + 1] = offsets[i] + pieces[i].size();
+
+    // empty strings cost nothing to create
+    std::vector<StringT> result(offsets.back());
+    detail::run_parts(pieces.size(), [&](std::size_t i)
+    {
+        std::move(pieces[i].begin(), pieces[i].end(), result.begin() + std::ptrdiff_t(offsets[i]));
+        pieces[i] = std::vector<StringT>();
+    });
+
+    return result;
+}
+
+// Counts the occurrences of 'ch', using up to 'threads' threads (0 means one per core).
+template <class StringT>
+    requires detail::IsStringViewish<StringT, typename StringT::value_type>
+[[nodiscard]] std::size_t parallel_count(const StringT& source, typename StringT::value_type ch, unsigned threads = 0)
+{
+    auto const data = source.data();
+    auto const parts = detail::partition(data, std::size_t(source.size()), detail::parts_for(source.size(), threads));
+
+    std::vector<std::size_t> counts(parts.size());
+    detail::run_parts(parts.size(), [&](std::size_t i)
+    {
+        counts[i] = std::size_t(std::count(data + parts[i].first, data + parts[i].last, ch));
+    });
+
+    std::size_t total = 0;
+    for (auto c : counts)
+        total += c;
+
+    return total;
+}
+
+// Returns all the positions where 'needle' occurs in ascending order (occurrences may overlap),
+// using up to 'threads' threads (0 means one per core).
+template <class StringT, class NeedleT>
+    requires detail::IsStringViewish<StringT, typename StringT::value_type> && detail::IsStringViewish<NeedleT, typename StringT::value_type>
+[[nodiscard]] std::vector<std::size_t> parallel_find_all(const StringT& source, const NeedleT& needle, unsigned threads = 0)
+{
+    using view_type = std::basic_string_view<typename StringT::value_type>;
+
+    view_type const haystack(source.data(), source.size());
+    view_type const what(needle.data(), needle.size());
+    if (what.empty() || what.size() > haystack.size())
+        return {};
+
+    auto const parts = detail::partition(haystack.data(), haystack.size(), detail::parts_for(haystack.size(), threads));
+
+    std::vector<std::vector<std::size_t>> found(parts.size());
+    detail::run_parts(parts.size(), [&](std::size_t i)
+    {
+        // matches starting within the range, they may run into the next one by up to what.size() - 1 characters
+        auto const first = parts[i].first;
+        auto const window = haystack.substr(first, std::min(haystack.size(), parts[i].last + what.size() - 1) - first);
+        for (auto pos = window.find(what); pos != view_type::npos; pos = window.find(what, pos + 1))
+            found[i].push_back(first + pos);
+    });
+
+    std::vector<std::size_t> result;
+    std::size_t total = 0;
+    for (auto& f : found)
+        total += f.size();
+
+    result.reserve(total);
+    for (auto& f : found)
+        result.insert(result.end(), f.begin(), f.end());
+
+    return result;
+}
+
+// Counts non-empty records separated by 'delimiter' (i.e. what split() would return) without creating any strings,
+// using up to 'threads' threads (0 means one per core).
+template <class StringT>
+    requires detail::IsStringViewish<StringT, typename StringT::value_type>
+[[nodiscard]] std::size_t parallel_word_count(const StringT& source, typename StringT::value_type delimiter, unsigned threads = 0)
+{
+    auto const data = source.data();
+    auto const parts = detail::partition(data, std::size_t(source.size()), detail::parts_for(source.size(), threads), &delimiter);
+
+    std::vector<std::size_t> counts(parts.size());
+    detail::run_parts(parts.size(), [&](std::size_t i)
+    {
+        // a word starts wherever a non-delimiter follows a delimiter (or the range start, which always follows one)
+        std::size_t words = 0;
+        bool in_word = false;
+        for (auto p = data + parts[i].first, end = data + parts[i].last; p != end; ++p)
+        {
+            auto const is_delimiter = (*p == delimiter);
+            words += (!is_delimiter && !in_word);
+            in_word = !is_delimiter;
+        }
+
+        counts[i] = words;
+    });
+
+    std::size_t total = 0;
+    for (auto c : counts)
+        total += c;
+
+    return total;
+}
+
+} // namespace ims {}
@@ -0,0 +1,864 @@
+#pragma once
+
+
+#include <immutable_string/string.hxx>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+namespace ims
+{
+
+// Adaptive radix tree (Leis et al.) keyed by byte strings, for prefix scans and longest-prefix matches
+// (routing tables, path prefixes) that hash maps can't serve.
+// Inner nodes come in 4, 16, 48 and 256 child flavors and grow as needed; Node16 is searched with one SSE2 compare.
+// Paths are compressed: every inner node stores the bytes its children have in common as a substring of some key,
+// so neither keys nor prefixes copy any characters (keys are stored by reference, i.e. the buffer is shared).
+// A key that ends where an inner node starts branching is kept in that node's 'terminal' slot.
+// Iteration goes in lexicographic (unsigned byte) order and yields references to the stored keys.
+template <class V, class StringT = immutable_string>
+class radix_tree final
+{
+public:
+    using key_type = StringT;
+    using mapped_type = V;
+    using value_type = typename StringT::value_type;
+    using size_type = std::size_t;
+    using view_type = std::basic_string_view<value_type, typename StringT::traits_type>;
+
+    static_assert(sizeof(value_type) == 1, "radix_tree keys are byte strings");
+
+    struct entry
+    {
+        key_type const key;
+        V value;
+    };
+
+    ~radix_tree()
+    {
+        _destroy(m_root);
+    }
+
+    radix_tree() noexcept = default;
+
+    radix_tree(const radix_tree&) = delete;
+    radix_tree& operator=(const radix_tree&) = delete;
+
+    radix_tree(radix_tree&& other) noexcept
+        : m_root(std::exchange(other.m_root, nullptr))
+        , m_size(std::exchange(other.m_size, 0))
+    {
+    }
+
+    radix_tree& operator=(radix_tree&& other) noexcept
+    {
+        radix_tree tmp(std::move(other));
+        std::swap(m_root, tmp.m_root);
+        std::swap(m_size, tmp.m_size);
+        return *this;
+    }
+
+    [[nodiscard]] size_type size() const noexcept
+    {
+        return m_size;
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    void clear() noexcept
+    {
+        _destroy(m_root);
+        m_root = nullptr;
+        m_size = 0;
+    }
+
+    [[nodiscard]] V* find(view_type key) noexcept
+    {
+        auto e = _find(key);
+        return e ? &e->value : nullptr;
+    }
+
+    [[nodiscard]] const V* find(view_type key) const noexcept
+    {
+        auto e = _find(key);
+        return e ? &e->value : nullptr;
+    }
+
+    template <detail::IsStringViewish<value_type> StringViewT>
+    [[nodiscard]] V* find(const StringViewT& key) noexcept
+    {
+        return find(view_type(key.data(), key.size()));
+    }
+
+    template <detail::IsStringViewish<value_type> StringViewT>
+    [[nodiscard]] const V* find(const StringViewT& key) const noexcept
+    {
+        return find(view_type(key.data(), key.size()));
+    }
+
+    // the entry with the longest key that is a prefix of 'key' (maybe 'key' itself), or nullptr
+    [[nodiscard]] entry* longest_prefix_match(view_type key) noexcept
+    {
+        return _longest_prefix_match(key);
+    }
+
+    [[nodiscard]] const entry* longest_prefix_match(view_type key) const noexcept
+    {
+        return _longest_prefix_match(key);
+    }
+
+    // returns the mapped value and whether it was inserted; an existing value is left untouched
+    template <class... ArgsT>
+    std::pair<V*, bool> try_emplace(const key_type& key, ArgsT&&... args)
+    {
+        auto const k = _view(key);
+        child* ref = &m_root;
+        size_type depth = 0;
+
+        for (;;)
+        {
+            if (!*ref)
+            {
+                auto l = _make_leaf(key, std::forward<ArgsT>(args)...);
+                *ref = _tag(l.get());
+                return { _linked(l), true };
+            }
+
+            if (_is_leaf(*ref))
+            {
+                auto existing = _leaf(*ref);
+                auto const other = _view(existing->key);
+                if (other == k)
+                    return { &existing->value, false };
+
+                // both keys go under a new node holding what they have in common past 'depth'
+                auto const common = _common_length(k.substr(depth), other.substr(depth));
+                auto l = _make_leaf(key, std::forward<ArgsT>(args)...);
+
+                auto n = new node4(key.substr(depth, common));
+                _attach(n, existing, depth + common);
+                _attach(n, l.get(), depth + common);
+                *ref = n;
+                return { _linked(l), true };
+            }
+
+            auto n = _node(*ref);
+            auto const p = _view(n->prefix);
+            auto const matched = _common_length(k.substr(depth), p);
+            if (matched < p.size())
+            {
+                // the key leaves the compressed path half way: split the path
+                auto l = _make_leaf(key, std::forward<ArgsT>(args)...);
+
+                auto split = new node4(n->prefix.substr(0, matched));
+                auto const edge = _byte(p[matched]);
+                n->prefix = n->prefix.substr(matched + 1);
+                _add_child(split, edge, n);
+                _attach(split, l.get(), depth + matched);
+                *ref = split;
+                return { _linked(l), true };
+            }
+
+            depth += p.size();
+            if (depth == k.size())
+            {
+                if (n->terminal)
+                    return { &n->terminal->value, false };
+
+                auto l = _make_leaf(key, std::forward<ArgsT>(args)...);
+                n->terminal = l.get();
+                return { _linked(l), true };
+            }
+
+            auto const b = _byte(k[depth]);
+            auto next = _find_child(n, b);
+            if (!next)
+            {
+                auto l = _make_leaf(key, std::forward<ArgsT>(args)...);
+                _add_child_grow(*ref, b, _tag(l.get()));
+                return { _linked(l), true };
+            }
+
+            ref = next;
+            ++depth;
+        }
+    }
+
+    bool erase(view_type key)
+    {
+        return _erase(m_root, key, 0);
+    }
+
+    template <detail::IsStringViewish<value_type> StringViewT>
+    bool erase(const StringViewT& key)
+    {
+        return erase(view_type(key.data(), key.size()));
+    }
+
+    // 'f(const key_type&, V&)' is called for every element in key order
+    template <class FunctionT>
+    void for_each(FunctionT&& f) const
+    {
+        if (m_root)
+            _visit(m_root, f);
+    }
+
+    // 'f(const key_type&, V&)' is called for every element whose key starts with 'prefix', in key order
+    template <class FunctionT>
+    void for_each_prefix(view_type prefix, FunctionT&& f) const
+    {
+        auto c = m_root;
+        size_type depth = 0;
+        while (c)
+        {
+            if (_is_leaf(c))
+            {
+                auto l = _leaf(c);
+                if (_view(l->key).starts_with(prefix))
+                    f(static_cast<const key_type&>(l->key), l->value);
+
+                return;
+            }
+
+            auto n = _node(c);
+            auto const p = _view(n->prefix);
+            auto const rest = prefix.substr(depth);
+            if (rest.size() <= p.size())
+            {
+                // the prefix ends within this node's path: everything below matches
+                if (p.starts_with(rest))
+                    _visit(c, f);
+
+                return;
+            }
+
+            if (!rest.starts_with(p))
+                return;
+
+            depth += p.size();
+            auto next = _find_child(n, _byte(prefix[depth]));
+            if (!next)
+                return;
+
+            c = *next;
+            ++depth;
+        }
+    }
+
+private:
+    enum class node_type : std::uint8_t
+    {
+        n4,
+        n16,
+        n48,
+        n256
+    };
+
+    using leaf = entry;
+
+    // a leaf pointer has its lowest bit set
+    using child = void*;
+
+    struct node_base
+    {
+        node_base(node_type t, key_type&& p) noexcept
+            : type(t)
+            , prefix(std::move(p))
+        {
+        }
+
+        node_type const type;
+        std::uint16_t count = 0;
+        key_type prefix;
+        leaf* terminal = nullptr;
+    };
+
+    struct node4
+        : node_base
+    {
+        explicit node4(key_type p) noexcept
+            : node_base(node_type::n4, std::move(p))
+        {
+        }
+
+        std::uint8_t keys[4] = {};
+        child children[4] = {};
+    };
+
+    struct node16
+        : node_base
+    {
+        explicit node16(key_type p) noexcept
+            : node_base(node_type::n16, std::move(p))
+        {
+        }
+
+        std::uint8_t keys[16] = {};
+        child children[16] = {};
+    };
+
+    struct node48
+        : node_base
+    {
+        explicit node48(key_type p) noexcept
+            : node_base(node_type::n48, std::move(p))
+        {
+        }
+
+        std::uint8_t index[256] = {}; // child slot + 1, 0 if none
+        child children[48] = {};
+    };
+
+    struct node256
+        : node_base
+    {
+        explicit node256(key_type p) noexcept
+            : node_base(node_type::n256, std::move(p))
+        {
+        }
+
+        child children[256] = {};
+    };
+
+    [[nodiscard]] static view_type _view(const key_type& s) noexcept
+    {
+        return view_type(s.data(), s.size());
+    }
+
+    [[nodiscard]] static std::uint8_t _byte(value_type c) noexcept
+    {
+        return static_cast<std::uint8_t>(c);
+    }
+
+    [[nodiscard]] static bool _is_leaf(child c) noexcept
+    {
+        return (reinterpret_cast<std::uintptr_t>(c) & 1) != 0;
+    }
+
+    [[nodiscard]] static leaf* _leaf(child c) noexcept
+    {
+        return reinterpret_cast<leaf*>(reinterpret_cast<std::uintptr_t>(c) & ~std::uintptr_t(1));
+    }
+
+    [[nodiscard]] static child _tag(leaf* l) noexcept
+    {
+        return reinterpret_cast<child>(reinterpret_cast<std::uintptr_t>(l) | 1);
+    }
+
+    [[nodiscard]] static node_base* _node(child c) noexcept
+    {
+        return static_cast<node_base*>(c);
+    }
+
+    [[nodiscard]] static size_type _common_length(view_type a, view_type b) noexcept
+    {
+        auto const n = std::min(a.size(), b.size());
+        size_type i = 0;
+        while (i < n && a[i] == b[i])
+            ++i;
+
+        return i;
+    }
+
+    // owned by the caller until it is linked into the tree, so that a throwing node allocation doesn't leak it
+    template <class... ArgsT>
+    std::unique_ptr<leaf> _make_leaf(const key_type& key, ArgsT&&... args)
+    {
+        return std::unique_ptr<leaf>(new leaf{ key, V(std::forward<ArgsT>(args)...) });
+    }
+
+    // hands a leaf over to the tree once it is reachable from the root
+    V* _linked(std::unique_ptr<leaf>& l) noexcept
+    {
+        ++m_size;
+        return &l.release()->value;
+    }
+
+    // puts a leaf under a fresh node whose path ends at 'depth'
+    static void _attach(node4* n, leaf* l, size_type depth) noexcept
+    {
+        auto const k = _view(l->key);
+        if (k.size() == depth)
+            n->terminal = l;
+        else
+            _add_child(n, _byte(k[depth]), _tag(l));
+    }
+
+    [[nodiscard]] static child* _find_child(node_base* n, std::uint8_t b) noexcept
+    {
+        switch (n->type)
+        {
+        case node_type::n4:
+        {
+            auto n4 = static_cast<node4*>(n);
+            for (unsigned i = 0; i < n4->count; ++i)
+            {
+                if (n4->keys[i] == b)
+                    return &n4->children[i];
+            }
+
+            return nullptr;
+        }
+
+        case node_type::n16:
+        {
+            auto n16 = static_cast<node16*>(n);
+#if defined(IMS_SSE2)
+            auto const eq = _mm_cmpeq_epi8(_mm_set1_epi8(char(b)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(n16->keys)));
+            auto const mask = unsigned(_mm_movemask_epi8(eq)) & ((1u << n16->count) - 1);
+            return mask ? &n16->children[std::countr_zero(mask)] : nullptr;
+#else
+            for (unsigned i = 0; i < n16->count; ++i)
+            {
+                if (n16->keys[i] == b)
+                    return &n16->children[i];
+            }
+
+            return nullptr;
+#endif
+        }
+
+        case node_type::n48:
+        {
+            auto n48 = static_cast<node48*>(n);
+            auto const i = n48->index[b];
+            return i ? &n48->children[i - 1] : nullptr;
+        }
+
+        default:
+        {
+            auto n256 = static_cast<node256*>(n);
+            return n256->children[b] ? &n256->children[b] : nullptr;
+        }
+        }
+    }
+
+    // the node must have room for one more child; callers that know the node type call the overload for it,
+    // so that the compiler never sees a small node accessed as a bigger one
+    static void _add_child(node_base* n, std::uint8_t b, child c) noexcept
+    {
+        switch (n->type)
+        {
+        case node_type::n4: _add_child(static_cast<node4*>(n), b, c); break;
+        case node_type::n16: _add_child(static_cast<node16*>(n), b, c); break;
+        case node_type::n48: _add_child(static_cast<node48*>(n), b, c); break;
+        default: _add_child(static_cast<node256*>(n), b, c); break;
+        }
+    }
+
+    static void _add_child(node4* n, std::uint8_t b, child c) noexcept
+    {
+        assert(n->count < 4);
+        _insert_sorted(n->keys, n->children, n->count, b, c);
+        ++n->count;
+    }
+
+    static void _add_child(node16* n, std::uint8_t b, child c) noexcept
+    {
+        assert(n->count < 16);
+        _insert_sorted(n->keys, n->children, n->count, b, c);
+        ++n->count;
+    }
+
+    static void _add_child(node48* n, std::uint8_t b, child c) noexcept
+    {
+        assert(n->count < 48);
+        n->children[n->count] = c;
+        n->index[b] = std::uint8_t(n->count + 1);
+        ++n->count;
+    }
+
+    static void _add_child(node256* n, std::uint8_t b, child c) noexcept
+    {
+        n->children[b] = c;
+        ++n->count;
+    }
+
+    static void _insert_sorted(std::uint8_t* keys, child* children, unsigned count, std::uint8_t b, child c) noexcept
+    {
+        unsigned pos = 0;
+        while (pos < count && keys[pos] < b)
+            ++pos;
+
+        std::memmove(keys + pos + 1, keys + pos, count - pos);
+        std::memmove(children + pos + 1, children + pos, (count - pos) * sizeof(child));
+        keys[pos] = b;
+        children[pos] = c;
+    }
+
+    [[nodiscard]] static bool _full(const node_base* n) noexcept
+    {
+        switch (n->type)
+        {
+        case node_type::n4: return n->count == 4;
+        case node_type::n16: return n->count == 16;
+        case node_type::n48: return n->count == 48;
+        default: return false;
+        }
+    }
+
+    // replaces a full node with the next bigger one
+    static void _add_child_grow(child& ref, std::uint8_t b, child c)
+    {
+        auto n = _node(ref);
+        if (_full(n))
+        {
+            node_base* bigger;
+            switch (n->type)
+            {
+            case node_type::n4:
+            {
+                auto from = static_cast<node4*>(n);
+                auto to = new node16(std::move(n->prefix));
+                std::memcpy(to->keys, from->keys, sizeof(from->keys));
+                std::memcpy(to->children, from->children, sizeof(from->children));
+                bigger = to;
+                break;
+            }
+
+            case node_type::n16:
+            {
+                auto from = static_cast<node16*>(n);
+                auto to = new node48(std::move(n->prefix));
+                for (unsigned i = 0; i < 16; ++i)
+                {
+                    to->children[i] = from->children[i];
+                    to->index[from->keys[i]] = std::uint8_t(i + 1);
+                }
+
+                bigger = to;
+                break;
+            }
+
+            default:
+            {
+                auto from = static_cast<node48*>(n);
+                auto to = new node256(std::move(n->prefix));
+                for (unsigned k = 0; k < 256; ++k)
+                {
+                    if (from->index[k])
+                        to->children[k] = from->children[from->index[k] - 1];
+                }
+
+                bigger = to;
+                break;
+            }
+            }
+
+            bigger->count = n->count;
+            bigger->terminal = n->terminal;
+            _delete_node(n);
+            ref = bigger;
+            n = bigger;
+        }
+
+        _add_child(n, b, c);
+    }
+
+    static void _remove_child(node_base* n, std::uint8_t b) noexcept
+    {
+        switch (n->type)
+        {
+        case node_type::n4:
+            _remove_sorted(static_cast<node4*>(n)->keys, static_cast<node4*>(n)->children, n->count, b);
+            break;
+
+        case node_type::n16:
+            _remove_sorted(static_cast<node16*>(n)->keys, static_cast<node16*>(n)->children, n->count, b);
+            break;
+
+        case node_type::n48:
+        {
+            // the last child takes the freed slot
+            auto n48 = static_cast<node48*>(n);
+            auto const slot = n48->index[b] - 1;
+            auto const last = n->count - 1;
+            n48->index[b] = 0;
+            if (slot != last)
+            {
+                n48->children[slot] = n48->children[last];
+                for (unsigned k = 0; k < 256; ++k)
+                {
+                    if (n48->index[k] == last + 1)
+                    {
+                        n48->index[k] = std::uint8_t(slot + 1);
+                        break;
+                    }
+                }
+            }
+
+            n48->children[last] = nullptr;
+            break;
+        }
+
+        default:
+            static_cast<node256*>(n)->children[b] = nullptr;
+            break;
+        }
+
+        --n->count;
+    }
+
+    static void _remove_sorted(std::uint8_t* keys, child* children, unsigned count, std::uint8_t b) noexcept
+    {
+        unsigned pos = 0;
+        while (keys[pos] != b)
+            ++pos;
+
+        std::memmove(keys + pos, keys + pos + 1, count - pos - 1);
+        std::memmove(children + pos, children + pos + 1, (count - pos - 1) * sizeof(child));
+    }
+
+    // calls 'f(byte, child)' for every child in byte order
+    template <class FunctionT>
+    static void _for_each_child(const node_base* n, FunctionT&& f)
+    {
+        switch (n->type)
+        {
+        case node_type::n4:
+        {
+            auto n4 = static_cast<const node4*>(n);
+            for (unsigned i = 0; i < n->count; ++i)
+                f(n4->keys[i], n4->children[i]);
+            break;
+        }
+
+        case node_type::n16:
+        {
+            auto n16 = static_cast<const node16*>(n);
+            for (unsigned i = 0; i < n->count; ++i)
+                f(n16->keys[i], n16->children[i]);
+            break;
+        }
+
+        case node_type::n48:
+        {
+            auto n48 = static_cast<const node48*>(n);
+            for (unsigned k = 0; k < 256; ++k)
+            {
+                if (n48->index[k])
+                    f(std::uint8_t(k), n48->children[n48->index[k] - 1]);
+            }
+            break;
+        }
+
+        default:
+        {
+            auto n256 = static_cast<const node256*>(n);
+            for (unsigned k = 0; k < 256; ++k)
+            {
+                if (n256->children[k])
+                    f(std::uint8_t(k), n256->children[k]);
+            }
+            break;
+        }
+        }
+    }
+
+    template <class FunctionT>
+    static void _visit(child c, FunctionT& f)
+    {
+        if (_is_leaf(c))
+        {
+            auto l = _leaf(c);
+            f(static_cast<const key_type&>(l->key), l->value);
+            return;
+        }
+
+        auto n = _node(c);
+        if (n->terminal)
+            f(static_cast<const key_type&>(n->terminal->key), n->terminal->value);
+
+        _for_each_child(n, [&f](std::uint8_t, child next) { _visit(next, f); });
+    }
+
+    [[nodiscard]] entry* _find(view_type key) const noexcept
+    {
+        auto c = m_root;
+        size_type depth = 0;
+        while (c)
+        {
+            if (_is_leaf(c))
+            {
+                auto l = _leaf(c);
+                return (_view(l->key) == key) ? l : nullptr;
+            }
+
+            auto n = _node(c);
+            auto const p = _view(n->prefix);
+            if (key.size() - depth < p.size() || key.compare(depth, p.size(), p) != 0)
+                return nullptr;
+
+            depth += p.size();
+            if (depth == key.size())
+                return n->terminal;
+
+            auto next = _find_child(n, _byte(key[depth]));
+            if (!next)
+                return nullptr;
+
+            c = *next;
+            ++depth;
+        }
+
+        return nullptr;
+    }
+
+    [[nodiscard]] entry* _longest_prefix_match(view_type key) const noexcept
+    {
+        entry* best = nullptr;
+        auto c = m_root;
+        size_type depth = 0;
+        while (c)
+        {
+            if (_is_leaf(c))
+            {
+                auto l = _leaf(c);
+                return key.starts_with(_view(l->key)) ? l : best;
+            }
+
+            auto n = _node(c);
+            auto const p = _view(n->prefix);
+            if (key.size() - depth < p.size() || key.compare(depth, p.size(), p) != 0)
+                return best;
+
+            depth += p.size();
+            if (n->terminal)
+                best = n->terminal;
+
+            if (depth == key.size())
+                return best;
+
+            auto next = _find_child(n, _byte(key[depth]));
+            if (!next)
+                return best;
+
+            c = *next;
+            ++depth;
+        }
+
+        return best;
+    }
+
+    bool _erase(child& ref, view_type key, size_type depth)
+    {
+        if (!ref)
+            return false;
+
+        if (_is_leaf(ref))
+        {
+            auto l = _leaf(ref);
+            if (_view(l->key) != key)
+                return false;
+
+            delete l;
+            --m_size;
+            ref = nullptr;
+            return true;
+        }
+
+        auto n = _node(ref);
+        auto const p = _view(n->prefix);
+        if (key.size() - depth < p.size() || key.compare(depth, p.size(), p) != 0)
+            return false;
+
+        depth += p.size();
+        if (depth == key.size())
+        {
+            if (!n->terminal)
+                return false;
+
+            delete n->terminal;
+            --m_size;
+            n->terminal = nullptr;
+        }
+        else
+        {
+            auto const b = _byte(key[depth]);
+            auto next = _find_child(n, b);
+            if (!next || !_erase(*next, key, depth + 1))
+                return false;
+
+            if (!*next)
+                _remove_child(n, b);
+        }
+
+        _collapse(ref);
+        return true;
+    }
+
+    // removes a node that is no longer needed for branching, keeping the paths compressed
+    static void _collapse(child& ref)
+    {
+        auto n = _node(ref);
+        if (n->count == 0)
+        {
+            ref = n->terminal ? _tag(n->terminal) : nullptr;
+            _delete_node(n);
+        }
+        else if (n->count == 1 && !n->terminal)
+        {
+            std::uint8_t b = 0;
+            child only = nullptr;
+            _for_each_child(n, [&b, &only](std::uint8_t k, child c) { b = k; only = c; });
+
+            if (!_is_leaf(only))
+            {
+                // the child's path is now our path + the edge + its own path
+                auto next = _node(only);
+                auto const a = _view(n->prefix);
+                auto const z = _view(next->prefix);
+                next->prefix = key_type::create(a.size() + 1 + z.size(), [a, b, z](value_type* dest)
+                {
+                    std::memcpy(dest, a.data(), a.size());
+                    dest[a.size()] = value_type(b);
+                    std::memcpy(dest + a.size() + 1, z.data(), z.size());
+                }, n->prefix.get_allocator());
+            }
+
+            ref = only;
+            _delete_node(n);
+        }
+    }
+
+    static void _delete_node(node_base* n) noexcept
+    {
+        switch (n->type)
+        {
+        case node_type::n4: delete static_cast<node4*>(n); break;
+        case node_type::n16: delete static_cast<node16*>(n); break;
+        case node_type::n48: delete static_cast<node48*>(n); break;
+        default: delete static_cast<node256*>(n); break;
+        }
+    }
+
+    static void _destroy(child c) noexcept
+    {
+        if (!c)
+            return;
+
+        if (_is_leaf(c))
+        {
+            delete _leaf(c);
+            return;
+        }
+
+        auto n = _node(c);
+        delete n->terminal;
+        _for_each_child(n, [](std::uint8_t, child next) { _destroy(next); });
+        _delete_node(n);
+    }
+
+    child m_root = nullptr;
+    size_type m_size = 0;
+};
+
+} // namespace ims {}
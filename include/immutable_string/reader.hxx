@@ -0,0 +1,402 @@
+#pragma once
+
+
+#include <immutable_string/string.hxx>
+
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <thread>
+
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace ims
+{
+
+namespace detail
+{
+
+inline std::size_t read_some(int fd, void* buffer, std::size_t size)
+{
+    for (;;)
+    {
+#if defined(_WIN32)
+        auto r = ::_read(fd, buffer, unsigned(std::min<std::size_t>(size, INT_MAX)));
+#else
+        auto r = ::read(fd, buffer, size);
+#endif
+        if (r >= 0) [[likely]]
+            return std::size_t(r);
+
+        if (errno != EINTR)
+            throw std::system_error(errno, std::generic_category(), "Failed to read from file descriptor");
+    }
+}
+
+// read() on anything but a regular file may block for as long as the writer pleases
+inline bool is_regular_file(int fd) noexcept
+{
+#if defined(_WIN32)
+    struct _stat64 st;
+    return ::_fstat64(fd, &st) == 0 && (st.st_mode & _S_IFMT) == _S_IFREG;
+#else
+    struct stat st;
+    return ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+#endif
+}
+
+#if !defined(_WIN32)
+
+// waits until 'fd' can be read without blocking; returns false if 'wake_fd' got readable first
+inline bool wait_readable(int fd, int wake_fd)
+{
+    pollfd fds[2] = { { fd, POLLIN, 0 }, { wake_fd, POLLIN, 0 } };
+    for (;;)
+    {
+        auto r = ::poll(fds, 2, -1);
+        if (r >= 0) [[likely]]
+        {
+            if (fds[1].revents)
+                return false;
+
+            if (fds[0].revents) // POLLHUP and POLLERR too: read() reports these
+                return true;
+
+            continue;
+        }
+
+        if (errno != EINTR)
+            throw std::system_error(errno, std::generic_category(), "Failed to poll file descriptor");
+    }
+}
+
+// a self-pipe: signal() makes the read end readable for good
+class wake_pipe final
+{
+public:
+    ~wake_pipe()
+    {
+        if (m_fds[0] >= 0)
+        {
+            ::close(m_fds[0]);
+            ::close(m_fds[1]);
+        }
+    }
+
+    wake_pipe() noexcept = default;
+
+    wake_pipe(const wake_pipe&) = delete;
+    wake_pipe& operator=(const wake_pipe&) = delete;
+
+    void open()
+    {
+        if (::pipe(m_fds) != 0)
+            throw std::system_error(errno, std::generic_category(), "Failed to create a pipe");
+    }
+
+    [[nodiscard]] bool is_open() const noexcept
+    {
+        return m_fds[0] >= 0;
+    }
+
+    [[nodiscard]] int read_end() const noexcept
+    {
+        return m_fds[0];
+    }
+
+    void signal() noexcept
+    {
+        if (m_fds[1] < 0)
+            return;
+
+        char const signal = 0;
+        while (::write(m_fds[1], &signal, 1) < 0 && errno == EINTR)
+        {
+        }
+    }
+
+private:
+    int m_fds[2] = { -1, -1 };
+};
+
+#endif
+
+} // namespace detail {}
+
+
+// Splits a stream into records separated by 'delimiter' without loading it whole.
+// The stream is read into large reference-counted chunks, and records are substr()s of these chunks,
+// so only records that straddle a chunk boundary get copied.
+// With read-ahead on, the next chunk is read by a background thread while the current one is being parsed;
+// for pipes and other non-regular files the thread waits in poll(), so that the destructor can interrupt it
+// (on Windows, there is no read-ahead for these).
+template <class StringT = immutable_string>
+class basic_chunked_reader final
+{
+public:
+    using string_type = StringT;
+    using value_type = typename StringT::value_type;
+    using size_type = typename StringT::size_type;
+    using allocator_type = typename StringT::allocator_type;
+    using builder = typename StringT::builder;
+
+    static_assert(sizeof(value_type) == 1, "basic_chunked_reader reads bytes");
+
+    static constexpr size_type DefaultChunkSize = 1024 * 1024;
+
+    ~basic_chunked_reader()
+    {
+        if (m_worker.joinable())
+        {
+            {
+                std::lock_guard l(m_mutex);
+                m_stop = true;
+            }
+
+            m_cv.notify_all();
+#if !defined(_WIN32)
+            m_wake.signal();
+#endif
+            m_worker.join();
+        }
+    }
+
+    // the caller still owns 'fd'; it must stay open for the lifetime of the reader
+    explicit basic_chunked_reader(int fd, value_type delimiter = value_type('\n'), size_type chunk_size = DefaultChunkSize, bool read_ahead = true, const allocator_type& a = allocator_type())
+        : m_fd(fd)
+        , m_delimiter(delimiter)
+        , m_chunk_size(chunk_size ? chunk_size : DefaultChunkSize)
+        , m_allocator(a)
+    {
+        if (read_ahead && !detail::is_regular_file(fd))
+        {
+#if defined(_WIN32)
+            read_ahead = false;
+#else
+            m_wake.open(); // closed by its own destructor if starting the thread throws
+#endif
+        }
+
+        if (read_ahead)
+            m_worker = std::thread([this]() { _read_ahead(); });
+    }
+
+    basic_chunked_reader(const basic_chunked_reader&) = delete;
+    basic_chunked_reader& operator=(const basic_chunked_reader&) = delete;
+    basic_chunked_reader(basic_chunked_reader&&) = delete;
+    basic_chunked_reader& operator=(basic_chunked_reader&&) = delete;
+
+    // fetches the next record (without the delimiter); returns false at the end of the stream
+    bool next(string_type& record)
+    {
+        for (;;)
+        {
+            auto const chunk_size = m_chunk.size();
+            if (m_pos < chunk_size)
+            {
+                auto delim = m_chunk.find(m_delimiter, m_pos);
+                if (delim != string_type::npos)
+                {
+                    if (m_carry)
+                    {
+                        // the record started in one of the previous chunks
+                        m_carry->append(std::basic_string_view<value_type>(m_chunk.data() + m_pos, delim - m_pos));
+                        record = m_carry->str();
+                        m_carry.reset();
+                    }
+                    else if (!m_tail.empty())
+                    {
+                        if (delim == m_pos)
+                        {
+                            // the record ended right at the chunk boundary
+                            record = std::move(m_tail);
+                            m_tail = string_type();
+                            m_pos = delim + 1;
+                            return true;
+                        }
+
+                        record = _concat(m_tail, m_chunk.data() + m_pos, delim - m_pos);
+                        m_tail = string_type();
+                    }
+                    else
+                    {
+                        record = m_chunk.substr(m_pos, delim - m_pos);
+                    }
+
+                    m_pos = delim + 1;
+                    return true;
+                }
+
+                // the rest of the chunk is an incomplete record
+                if (m_carry)
+                {
+                    m_carry->append(std::basic_string_view<value_type>(m_chunk.data() + m_pos, chunk_size - m_pos));
+                }
+                else if (!m_tail.empty())
+                {
+                    // the record spans more than two chunks
+                    m_carry.emplace(m_tail.size() + (chunk_size - m_pos) + m_chunk_size, m_allocator);
+                    m_carry->append(m_tail);
+                    m_carry->append(std::basic_string_view<value_type>(m_chunk.data() + m_pos, chunk_size - m_pos));
+                    m_tail = string_type();
+                }
+                else
+                {
+                    // don't copy until we know it straddles the boundary
+                    m_tail = m_chunk.substr(m_pos);
+                }
+
+                m_pos = chunk_size;
+            }
+
+            if (m_eof)
+            {
+                if (m_carry)
+                {
+                    record = m_carry->str();
+                    m_carry.reset();
+                    return true;
+                }
+
+                if (!m_tail.empty())
+                {
+                    record = std::move(m_tail);
+                    m_tail = string_type();
+                    return true;
+                }
+
+                return false;
+            }
+
+            m_chunk = _next_chunk();
+            m_pos = 0;
+            if (m_chunk.empty())
+                m_eof = true;
+        }
+    }
+
+private:
+    // reads until the chunk is full, so that short reads from pipes neither pin a block each nor move the boundaries;
+    // comes back early if the reader is being destroyed
+    string_type _read_chunk()
+    {
+        builder b(m_chunk_size, m_allocator);
+        while (b.size() < m_chunk_size)
+        {
+#if !defined(_WIN32)
+            if (m_wake.is_open() && !detail::wait_readable(m_fd, m_wake.read_end()))
+                break;
+#endif
+            auto const before = b.size();
+            b.append_with(m_chunk_size - before, [this](value_type* dest, size_type max_count) { return detail::read_some(m_fd, dest, max_count); });
+            if (b.size() == before)
+                break; // EOF
+        }
+
+        // records are substrings of the chunk, don't copy it even if the stream ended early
+        return b.str(builder::shrink_policy::keep);
+    }
+
+    string_type _next_chunk()
+    {
+        if (!m_worker.joinable())
+            return _read_chunk();
+
+        std::unique_lock l(m_mutex);
+        m_cv.wait(l, [this]() { return m_ready; });
+
+        if (m_error)
+            std::rethrow_exception(m_error);
+
+        auto chunk = std::move(m_next);
+        m_next = string_type();
+        m_ready = false;
+
+        l.unlock();
+        m_cv.notify_all();
+
+        return chunk;
+    }
+
+    void _read_ahead()
+    {
+        for (;;)
+        {
+            string_type chunk;
+            std::exception_ptr error;
+            try
+            {
+                chunk = _read_chunk();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            auto const last = chunk.empty();
+
+            std::unique_lock l(m_mutex);
+            m_cv.wait(l, [this]() { return !m_ready || m_stop; });
+            if (m_stop)
+                return;
+
+            m_next = std::move(chunk);
+            m_error = error;
+            m_ready = true;
+
+            l.unlock();
+            m_cv.notify_all();
+
+            if (last || error)
+                return;
+        }
+    }
+
+    string_type _concat(const string_type& head, const value_type* tail, size_type tail_size) const
+    {
+        builder b(head.size() + tail_size, m_allocator);
+        b.append(head);
+        b.append(std::basic_string_view<value_type>(tail, tail_size));
+        return b.str();
+    }
+
+    int const m_fd;
+    value_type const m_delimiter;
+    size_type const m_chunk_size;
+    allocator_type const m_allocator;
+
+    // consumer side
+    string_type m_chunk;
+    size_type m_pos = 0;
+    string_type m_tail;
+    std::optional<builder> m_carry;
+    bool m_eof = false;
+
+    // read-ahead
+    std::thread m_worker;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    string_type m_next;
+    std::exception_ptr m_error;
+    bool m_ready = false;
+    bool m_stop = false;
+#if !defined(_WIN32)
+    detail::wake_pipe m_wake; // interrupts poll() in the worker
+#endif
+};
+
+
+using chunked_reader = basic_chunked_reader<immutable_string>;
+
+} // namespace ims {}
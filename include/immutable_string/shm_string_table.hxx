@@ -0,0 +1,415 @@
+#pragma once
+
+
+#include <immutable_string/string.hxx>
+
+#if defined(_WIN32)
+#error "shm_string_table requires POSIX shared memory"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ims
+{
+
+// Append-only string table in shared memory, so that processes on a host keep a single copy of a common vocabulary.
+// The mapping holds a header, an open-addressing index and the records, which are appended with an atomic bump pointer;
+// index slots are claimed with a CAS, so interning is lock-free across processes.
+// Strings returned are views into the mapping that borrow its storage (see basic_immutable_string::FromStaticStorage),
+// so copying them involves no reference counting, and c_str() needs no copy as records are null-terminated;
+// they're valid while this table object keeps the mapping.
+// Capacity and the index size are fixed at creation: interning into a full table throws std::length_error.
+// A record allocated by a process that then loses the race for the slot to an equal string stays unused.
+template <class StringT = immutable_string>
+class basic_shm_string_table final
+{
+public:
+    using string_type = StringT;
+    using value_type = typename StringT::value_type;
+    using traits_type = typename StringT::traits_type;
+    using size_type = std::size_t;
+    using view_type = std::basic_string_view<value_type, traits_type>;
+
+    ~basic_shm_string_table()
+    {
+        _unmap();
+    }
+
+    basic_shm_string_table(const basic_shm_string_table&) = delete;
+    basic_shm_string_table& operator=(const basic_shm_string_table&) = delete;
+
+    basic_shm_string_table(basic_shm_string_table&& other) noexcept
+        : m_base(std::exchange(other.m_base, nullptr))
+        , m_mapping_size(std::exchange(other.m_mapping_size, 0))
+    {
+    }
+
+    basic_shm_string_table& operator=(basic_shm_string_table&& other) noexcept
+    {
+        if (this != &other)
+        {
+            _unmap();
+            m_base = std::exchange(other.m_base, nullptr);
+            m_mapping_size = std::exchange(other.m_mapping_size, 0);
+        }
+
+        return *this;
+    }
+
+    // creates a named shared memory object (see shm_open()) for up to 'capacity' bytes of records and 'max_strings' strings;
+    // fails if it already exists
+    [[nodiscard]] static basic_shm_string_table create(const char* name, size_type capacity, size_type max_strings)
+    {
+        auto const slots = _slots_for(max_strings);
+        auto const size = _mapping_size(capacity, slots);
+
+        auto const fd = ::shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "Failed to create shared memory object");
+
+        try
+        {
+            if (::ftruncate(fd, off_t(size)) != 0)
+                throw std::system_error(errno, std::generic_category(), "Failed to size shared memory object");
+
+            basic_shm_string_table table(_map(fd, size), size);
+            ::close(fd);
+
+            table._initialize(slots);
+            return table;
+        }
+        catch (...)
+        {
+            ::close(fd);
+            ::shm_unlink(name);
+            throw;
+        }
+    }
+
+    // maps a table made by create()
+    [[nodiscard]] static basic_shm_string_table open(const char* name)
+    {
+        auto const fd = ::shm_open(name, O_RDWR, 0);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "Failed to open shared memory object");
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            auto const e = errno;
+            ::close(fd);
+            throw std::system_error(e, std::generic_category(), "Failed to stat shared memory object");
+        }
+
+        auto const size = size_type(st.st_size);
+        if (size < sizeof(_header))
+        {
+            ::close(fd);
+            throw std::runtime_error("Shared memory object is not a basic_shm_string_table");
+        }
+
+        void* base = nullptr;
+        try
+        {
+            base = _map(fd, size);
+        }
+        catch (...)
+        {
+            ::close(fd);
+            throw;
+        }
+
+        ::close(fd);
+
+        basic_shm_string_table table(base, size);
+        auto const h = table._head();
+        if (_atomic(h->magic).load(std::memory_order_acquire) != Magic || h->char_size != sizeof(value_type) || h->mapping_size != size)
+            throw std::runtime_error("Shared memory object is not a basic_shm_string_table");
+
+        return table;
+    }
+
+    // an anonymous shared mapping, inherited by the child processes fork()ed afterwards
+    [[nodiscard]] static basic_shm_string_table anonymous(size_type capacity, size_type max_strings)
+    {
+        auto const slots = _slots_for(max_strings);
+        auto const size = _mapping_size(capacity, slots);
+
+        auto const base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "Failed to map shared memory");
+
+        basic_shm_string_table table(base, size);
+        table._initialize(slots);
+        return table;
+    }
+
+    // the object goes away once every process has unmapped it
+    static bool remove(const char* name) noexcept
+    {
+        return ::shm_unlink(name) == 0;
+    }
+
+    // the stored string equal to 'str', added if there's none yet
+    [[nodiscard]] string_type intern(view_type str)
+    {
+        auto const n = str.size();
+        if (!n)
+            return string_type();
+
+        if (n > std::numeric_limits<std::uint32_t>::max())
+            throw std::length_error("String is too long for basic_shm_string_table");
+
+        auto const h = detail::hash_bytes(str.data(), n * sizeof(value_type));
+        auto const tag = h >> OffsetBits;
+        auto const mask = _head()->slots - 1;
+        auto const slots = _slots();
+
+        // allocated, but not published yet
+        std::uint64_t mine = 0;
+        for (std::uint64_t probe = 0; probe <= mask; ++probe)
+        {
+            auto slot = _atomic(slots[(h + probe) & mask]);
+            auto v = slot.load(std::memory_order_acquire);
+            if (!v)
+            {
+                if (!mine)
+                    mine = _allocate(str);
+
+                if (slot.compare_exchange_strong(v, (tag << OffsetBits) | (mine / RecordAlignment), std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    _atomic(_head()->count).fetch_add(1, std::memory_order_relaxed);
+                    return _string_at(mine);
+                }
+
+                // someone else took the slot; 'v' is theirs now
+            }
+
+            if ((v >> OffsetBits) == tag)
+            {
+                auto const offset = (v & OffsetMask) * RecordAlignment;
+                if (_view_at(offset) == str)
+                    return _string_at(offset);
+            }
+        }
+
+        throw std::length_error("basic_shm_string_table index is full");
+    }
+
+    template <detail::IsStringViewish<value_type> StringViewT>
+    [[nodiscard]] string_type intern(const StringViewT& str)
+    {
+        return intern(view_type(str.data(), str.size()));
+    }
+
+    [[nodiscard]] std::optional<string_type> find(view_type str) const noexcept
+    {
+        auto const n = str.size();
+        if (!n)
+            return string_type();
+
+        auto const h = detail::hash_bytes(str.data(), n * sizeof(value_type));
+        auto const tag = h >> OffsetBits;
+        auto const mask = _head()->slots - 1;
+        auto const slots = _slots();
+        for (std::uint64_t probe = 0; probe <= mask; ++probe)
+        {
+            auto const v = _atomic(slots[(h + probe) & mask]).load(std::memory_order_acquire);
+            if (!v)
+                break;
+
+            if ((v >> OffsetBits) == tag)
+            {
+                auto const offset = (v & OffsetMask) * RecordAlignment;
+                if (_view_at(offset) == str)
+                    return _string_at(offset);
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    template <detail::IsStringViewish<value_type> StringViewT>
+    [[nodiscard]] std::optional<string_type> find(const StringViewT& str) const noexcept
+    {
+        return find(view_type(str.data(), str.size()));
+    }
+
+    // strings interned by all the processes
+    [[nodiscard]] size_type size() const noexcept
+    {
+        return size_type(_atomic(_head()->count).load(std::memory_order_relaxed));
+    }
+
+    // bytes taken by the records
+    [[nodiscard]] size_type bytes_used() const noexcept
+    {
+        auto const h = _head();
+        auto const used = std::min(_atomic(h->used).load(std::memory_order_relaxed), h->mapping_size);
+        return size_type(used - h->data_offset);
+    }
+
+    [[nodiscard]] size_type capacity() const noexcept
+    {
+        auto const h = _head();
+        return size_type(h->mapping_size - h->data_offset);
+    }
+
+private:
+    static constexpr std::uint64_t Magic = 0x3142545353534d49; // "IMSSSTB1"
+    static constexpr unsigned OffsetBits = 40;
+    static constexpr std::uint64_t OffsetMask = (std::uint64_t(1) << OffsetBits) - 1;
+    static constexpr size_type RecordAlignment = 8;
+
+    // the rest of the mapping is zeroed when created
+    struct _header
+    {
+        std::uint64_t magic;
+        std::uint64_t char_size;
+        std::uint64_t mapping_size;
+        std::uint64_t slots;
+        std::uint64_t data_offset;
+        std::uint64_t used;     // the bump pointer
+        std::uint64_t count;
+    };
+
+    // a slot is [tag:24][record offset / 8:40], 0 when free; a record is [size:32][characters][null terminator]
+    using _record_size = std::uint32_t;
+
+    basic_shm_string_table(void* base, size_type size) noexcept
+        : m_base(static_cast<unsigned char*>(base))
+        , m_mapping_size(size)
+    {
+    }
+
+    template <class T>
+    [[nodiscard]] static std::atomic_ref<T> _atomic(T& v) noexcept
+    {
+        return std::atomic_ref<T>(v);
+    }
+
+    [[nodiscard]] static size_type _align(size_type n) noexcept
+    {
+        return (n + RecordAlignment - 1) & ~(RecordAlignment - 1);
+    }
+
+    [[nodiscard]] static size_type _slots_for(size_type max_strings) noexcept
+    {
+        // at most half full
+        return std::bit_ceil(std::max<size_type>(16, max_strings * 2));
+    }
+
+    [[nodiscard]] static size_type _mapping_size(size_type capacity, size_type slots)
+    {
+        auto const size = _align(sizeof(_header)) + slots * sizeof(std::uint64_t) + _align(capacity);
+        if (size / RecordAlignment > OffsetMask)
+            throw std::length_error("basic_shm_string_table capacity is too large");
+
+        return size;
+    }
+
+    [[nodiscard]] static void* _map(int fd, size_type size)
+    {
+        auto const base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "Failed to map shared memory");
+
+        return base;
+    }
+
+    void _unmap() noexcept
+    {
+        if (m_base)
+        {
+            ::munmap(m_base, m_mapping_size);
+            m_base = nullptr;
+        }
+    }
+
+    void _initialize(size_type slots) noexcept
+    {
+        auto const h = _head();
+        h->char_size = sizeof(value_type);
+        h->mapping_size = m_mapping_size;
+        h->slots = slots;
+        h->data_offset = _align(sizeof(_header)) + slots * sizeof(std::uint64_t);
+        h->used = h->data_offset;
+        h->count = 0;
+
+        // the fields above become visible to open() along with the magic
+        _atomic(h->magic).store(Magic, std::memory_order_release);
+    }
+
+    [[nodiscard]] _header* _head() const noexcept
+    {
+        return reinterpret_cast<_header*>(m_base);
+    }
+
+    [[nodiscard]] std::uint64_t* _slots() const noexcept
+    {
+        return reinterpret_cast<std::uint64_t*>(m_base + _align(sizeof(_header)));
+    }
+
+    [[nodiscard]] std::uint64_t _allocate(view_type str)
+    {
+        auto const h = _head();
+        auto const need = _align(sizeof(_record_size) + (str.size() + 1) * sizeof(value_type));
+        // a string that doesn't fit must not move 'used' past the end, smaller ones may still fit
+        auto used = _atomic(h->used);
+        auto offset = used.load(std::memory_order_relaxed);
+        do
+        {
+            if (need > h->mapping_size - offset)
+                throw std::length_error("basic_shm_string_table is full");
+        }
+        while (!used.compare_exchange_weak(offset, offset + need, std::memory_order_relaxed));
+
+        auto const record = m_base + offset;
+        auto const sz = _record_size(str.size());
+        std::memcpy(record, &sz, sizeof(sz));
+
+        auto const chars = reinterpret_cast<value_type*>(record + sizeof(_record_size));
+        traits_type::copy(chars, str.data(), str.size());
+        chars[str.size()] = value_type();
+
+        return offset;
+    }
+
+    [[nodiscard]] view_type _view_at(std::uint64_t offset) const noexcept
+    {
+        auto const record = m_base + offset;
+        _record_size sz;
+        std::memcpy(&sz, record, sizeof(sz));
+        return view_type(reinterpret_cast<const value_type*>(record + sizeof(_record_size)), sz);
+    }
+
+    [[nodiscard]] string_type _string_at(std::uint64_t offset) const noexcept
+    {
+        auto const v = _view_at(offset);
+        return string_type(v.data(), v.size(), true, string_type::FromStaticStorage); // records are null-terminated
+    }
+
+    unsigned char* m_base = nullptr;
+    size_type m_mapping_size = 0;
+};
+
+
+using shm_string_table = basic_shm_string_table<immutable_string>;
+
+} // namespace ims {}
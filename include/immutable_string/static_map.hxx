@@ -0,0 +1,356 @@
+#pragma once
+
+
+#include <immutable_string/string.hxx>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace ims
+{
+
+namespace detail
+{
+
+// the characters of a short key (up to 8 bytes) as a zero-padded word, laid out as in memory
+template <class CharT>
+[[nodiscard]] constexpr std::uint64_t load_key_word(const CharT* s, std::size_t n) noexcept
+{
+    assert(n * sizeof(CharT) <= sizeof(std::uint64_t));
+
+    std::uint64_t w = 0;
+    if (std::is_constant_evaluated())
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            auto const ch = std::uint64_t(std::make_unsigned_t<CharT>(s[i]));
+            for (std::size_t b = 0; b < sizeof(CharT); ++b)
+            {
+                auto const byte = (ch >> (8 * b)) & 0xff;
+                auto const pos = i * sizeof(CharT) + (std::endian::native == std::endian::little ? b : sizeof(CharT) - 1 - b);
+                w |= byte << (std::endian::native == std::endian::little ? 8 * pos : 8 * (7 - pos));
+            }
+        }
+    }
+    else if (n)
+    {
+        std::memcpy(&w, s, n * sizeof(CharT));
+    }
+
+    return w;
+}
+
+// a word at a time, the same at compile time and at run time
+template <class CharT>
+[[nodiscard]] constexpr std::uint64_t static_key_hash(const CharT* s, std::size_t n) noexcept
+{
+    constexpr std::size_t WordChars = sizeof(std::uint64_t) / sizeof(CharT);
+
+    auto h = std::uint64_t(n) * 0x9e3779b97f4a7c15ull;
+    for (std::size_t i = 0; i < n; i += WordChars)
+    {
+        h = (h ^ load_key_word(s + i, std::min(WordChars, n - i))) * 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 31;
+    }
+
+    return h;
+}
+
+[[nodiscard]] constexpr std::size_t static_key_slot(std::uint64_t h, std::uint32_t seed, std::size_t n) noexcept
+{
+    h ^= std::uint64_t(seed) * 0x9e3779b97f4a7c15ull;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return std::size_t(h % n);
+}
+
+} // namespace detail {}
+
+
+template <class V, class StringT, std::size_t N>
+class basic_static_string_map;
+
+// Fixed set of string literals with a minimal perfect hash built at compile time (hash and displace):
+// a key hashes into one of N buckets, and the bucket's seed sends it to its own slot out of N.
+// A lookup is one hash of the key, a size check and one comparison, which is a single word compare
+// for keys of up to 8 bytes; nothing is done at startup and nothing is allocated.
+// The keys are returned as basic_immutable_strings referencing the literals.
+template <class StringT, std::size_t N>
+class basic_static_string_set final
+{
+public:
+    using string_type = StringT;
+    using value_type = typename StringT::value_type;
+    using traits_type = typename StringT::traits_type;
+    using size_type = std::size_t;
+    using view_type = std::basic_string_view<value_type, traits_type>;
+
+    static constexpr size_type npos = size_type(-1);
+
+    static_assert(N > 0);
+
+    // throws (i.e. fails to compile) on duplicate keys
+    consteval explicit basic_static_string_set(const value_type* const (&keys)[N])
+    {
+        _build(keys);
+    }
+
+    [[nodiscard]] static constexpr size_type size() noexcept
+    {
+        return N;
+    }
+
+    // the slot of 'key' in [0, size()), or npos
+    [[nodiscard]] constexpr size_type index_of(view_type key) const noexcept
+    {
+        auto const n = key.size();
+        auto const h = detail::static_key_hash(key.data(), n);
+        auto const slot = detail::static_key_slot(h, m_seeds[size_type(h % N)], N);
+        auto const& e = m_entries[slot];
+        if (e.size != n)
+            return npos;
+
+        if (n <= WordChars)
+            return (detail::load_key_word(key.data(), n) == e.word) ? slot : npos;
+
+        return (traits_type::compare(e.data, key.data(), n) == 0) ? slot : npos;
+    }
+
+    template <detail::IsStringViewish<value_type> StringViewT>
+    [[nodiscard]] constexpr size_type index_of(const StringViewT& key) const noexcept
+    {
+        return index_of(view_type(key.data(), key.size()));
+    }
+
+    template <class KeyT>
+    [[nodiscard]] constexpr bool contains(const KeyT& key) const noexcept
+    {
+        return index_of(key) != npos;
+    }
+
+    // the stored literal equal to 'key', if any
+    template <class KeyT>
+    [[nodiscard]] std::optional<string_type> find(const KeyT& key) const noexcept
+    {
+        auto const i = index_of(key);
+        if (i == npos)
+            return std::nullopt;
+
+        return key_at(i);
+    }
+
+    // the literal in slot 'index'; no allocation
+    [[nodiscard]] string_type key_at(size_type index) const noexcept
+    {
+        assert(index < N);
+        return string_type(m_entries[index].data, m_entries[index].size, string_type::FromStringLiteral);
+    }
+
+    [[nodiscard]] constexpr view_type view_at(size_type index) const noexcept
+    {
+        assert(index < N);
+        return view_type(m_entries[index].data, m_entries[index].size);
+    }
+
+private:
+    template <class, class, std::size_t>
+    friend class basic_static_string_map;
+
+    static constexpr size_type WordChars = sizeof(std::uint64_t) / sizeof(value_type);
+    static constexpr std::uint32_t MaxSeed = 1u << 20;
+
+    struct _entry
+    {
+        const value_type* data = nullptr;
+        size_type size = 0;
+        std::uint64_t word = 0; // the characters of a short key
+    };
+
+    consteval basic_static_string_set() = default;
+
+    consteval void _build(const value_type* const* keys)
+    {
+        std::array<std::uint64_t, N> hashes{};
+        std::array<size_type, N> sizes{};
+        std::array<size_type, N> bucket_sizes{};
+        for (size_type i = 0; i < N; ++i)
+        {
+            sizes[i] = traits_type::length(keys[i]);
+            hashes[i] = detail::static_key_hash(keys[i], sizes[i]);
+            ++bucket_sizes[size_type(hashes[i] % N)];
+        }
+
+        // the largest buckets go first, while there are many free slots
+        std::array<size_type, N> buckets{};
+        for (size_type b = 0; b < N; ++b)
+            buckets[b] = b;
+
+        std::sort(buckets.begin(), buckets.end(), [&bucket_sizes](size_type a, size_type b)
+        {
+            return bucket_sizes[a] > bucket_sizes[b];
+        });
+
+        std::array<bool, N> taken{};
+        for (auto b : buckets)
+        {
+            if (!bucket_sizes[b])
+                break;
+
+            std::array<size_type, N> members{};
+            size_type count = 0;
+            for (size_type i = 0; i < N; ++i)
+            {
+                if (hashes[i] % N != b)
+                    continue;
+
+                for (size_type k = 0; k < count; ++k)
+                {
+                    auto const j = members[k];
+                    if (hashes[j] == hashes[i] && sizes[j] == sizes[i] && traits_type::compare(keys[j], keys[i], sizes[i]) == 0)
+                        throw std::invalid_argument("Duplicate key in basic_static_string_set");
+                }
+
+                members[count++] = i;
+            }
+
+            std::array<size_type, N> slots{};
+            for (std::uint32_t seed = 1;; ++seed)
+            {
+                if (seed > MaxSeed)
+                    throw std::logic_error("No perfect hash found for basic_static_string_set");
+
+                bool ok = true;
+                for (size_type k = 0; k < count && ok; ++k)
+                {
+                    slots[k] = detail::static_key_slot(hashes[members[k]], seed, N);
+                    ok = !taken[slots[k]] && std::find(slots.begin(), slots.begin() + k, slots[k]) == slots.begin() + k;
+                }
+
+                if (!ok)
+                    continue;
+
+                m_seeds[b] = seed;
+                for (size_type k = 0; k < count; ++k)
+                {
+                    auto const i = members[k];
+                    taken[slots[k]] = true;
+                    m_entries[slots[k]] = _entry{ keys[i], sizes[i], (sizes[i] <= WordChars) ? detail::load_key_word(keys[i], sizes[i]) : 0 };
+                }
+
+                break;
+            }
+        }
+    }
+
+    std::array<_entry, N> m_entries{};
+    std::array<std::uint32_t, N> m_seeds{}; // per bucket
+};
+
+
+// basic_static_string_set with a value per key; the values are stored by slot
+template <class V, class StringT, std::size_t N>
+class basic_static_string_map final
+{
+public:
+    using set_type = basic_static_string_set<StringT, N>;
+    using string_type = StringT;
+    using value_type = typename StringT::value_type;
+    using mapped_type = V;
+    using size_type = std::size_t;
+    using view_type = typename set_type::view_type;
+
+    static constexpr size_type npos = set_type::npos;
+
+    // throws (i.e. fails to compile) on duplicate keys
+    consteval explicit basic_static_string_map(const std::pair<const value_type*, V> (&entries)[N])
+    {
+        std::array<const value_type*, N> keys{};
+        for (size_type i = 0; i < N; ++i)
+            keys[i] = entries[i].first;
+
+        m_keys._build(keys.data());
+        for (size_type i = 0; i < N; ++i)
+            m_values[m_keys.index_of(view_type(entries[i].first))] = entries[i].second;
+    }
+
+    [[nodiscard]] static constexpr size_type size() noexcept
+    {
+        return N;
+    }
+
+    [[nodiscard]] constexpr const set_type& keys() const noexcept
+    {
+        return m_keys;
+    }
+
+    template <class KeyT>
+    [[nodiscard]] constexpr size_type index_of(const KeyT& key) const noexcept
+    {
+        return m_keys.index_of(key);
+    }
+
+    template <class KeyT>
+    [[nodiscard]] constexpr bool contains(const KeyT& key) const noexcept
+    {
+        return m_keys.index_of(key) != npos;
+    }
+
+    // nullptr if there's no such key
+    template <class KeyT>
+    [[nodiscard]] constexpr const V* find(const KeyT& key) const noexcept
+    {
+        auto const i = m_keys.index_of(key);
+        return (i != npos) ? &m_values[i] : nullptr;
+    }
+
+    template <class KeyT>
+    [[nodiscard]] constexpr const V& at(const KeyT& key) const
+    {
+        auto const v = find(key);
+        if (!v)
+            throw std::out_of_range("Key not found in basic_static_string_map");
+
+        return *v;
+    }
+
+    [[nodiscard]] string_type key_at(size_type index) const noexcept
+    {
+        return m_keys.key_at(index);
+    }
+
+    [[nodiscard]] constexpr const V& value_at(size_type index) const noexcept
+    {
+        assert(index < N);
+        return m_values[index];
+    }
+
+private:
+    set_type m_keys;
+    std::array<V, N> m_values{};
+};
+
+
+// constexpr auto verbs = ims::make_static_set({ "GET", "PUT", "POST" });
+template <class StringT = immutable_string, std::size_t N>
+[[nodiscard]] consteval basic_static_string_set<StringT, N> make_static_set(const typename StringT::value_type* const (&keys)[N])
+{
+    return basic_static_string_set<StringT, N>(keys);
+}
+
+// constexpr auto codes = ims::make_static_map<int>({ { "GET", 1 }, { "PUT", 2 } });
+template <class V, class StringT = immutable_string, std::size_t N>
+[[nodiscard]] consteval basic_static_string_map<V, StringT, N> make_static_map(const std::pair<const typename StringT::value_type*, V> (&entries)[N])
+{
+    return basic_static_string_map<V, StringT, N>(entries);
+}
+
+} // namespace ims {}
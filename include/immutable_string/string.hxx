@@ -1,12 +1,36 @@
 #pragma once
 
 
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
 #include <exception>
+#include <functional>
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <memory_resource>
+#include <new>
+#include <ranges>
+#include <stdexcept>
 #include <string>
 #include <vector>
+#include <version>
+
+#if __has_include(<format>)
+#include <format>
+#endif
+
+#if !defined(IMS_SSE2) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define IMS_SSE2 1
+#endif
+
+#if defined(IMS_SSE2)
+#include <emmintrin.h>
+#endif
 
 namespace ims
 {
@@ -131,6 +155,22 @@ concept IsStringViewish =
 };
 
 
+template <class T>
+concept IsCharacter =
+    std::is_same_v<T, char> ||
+    std::is_same_v<T, wchar_t> ||
+    std::is_same_v<T, char8_t> ||
+    std::is_same_v<T, char16_t> ||
+    std::is_same_v<T, char32_t>;
+
+// anything std::to_chars() accepts, except for bool and character types
+template <class T>
+concept IsNumber =
+    (std::is_integral_v<T> || std::is_floating_point_v<T>) &&
+    !std::is_same_v<std::remove_cv_t<T>, bool> &&
+    !IsCharacter<std::remove_cv_t<T>>;
+
+
 template <typename T, class TraitsT = std::char_traits<T>, typename AllocatorT = std::allocator<T>>
     requires (!std::is_array_v<T>) && std::is_trivial_v<T> && std::is_standard_layout_v<T>
 class shared_data final
@@ -162,19 +202,32 @@ public:
 
     [[nodiscard]] constexpr T const* data() const noexcept
     {
+        if (is_adopted()) [[unlikely]]
+            return _adopted()->data;
+
         auto start = reinterpret_cast<const std::byte*>(this);
         return reinterpret_cast<const T*>(start + padded_header_size());
     }
 
     [[nodiscard]] constexpr T* data() noexcept
     {
+        if (is_adopted()) [[unlikely]]
+            return _adopted()->data;
+
         auto start = reinterpret_cast<std::byte*>(this);
         return reinterpret_cast<T*>(start + padded_header_size());
     }
 
+    // no spare room in an adopted buffer, so nothing is ever appended in place
     [[nodiscard]] constexpr size_type capacity() const noexcept
     {
-        return m_capacity;
+        return is_adopted() ? m_size : m_capacity;
+    }
+
+    // the characters are somebody else's buffer, released through its own deleter
+    [[nodiscard]] constexpr bool is_adopted() const noexcept
+    {
+        return m_capacity == AdoptedCapacity;
     }
 
     [[nodiscard]] constexpr size_type size() const noexcept
@@ -193,8 +246,7 @@ public:
             throw std::length_error("Cannot create string this long");
 
         _raw_allocator a = allocator;
-        size_type allocation_size = sizeof(value_type) * (capacity + 1) + padded_header_size();
-        auto raw = a.allocate(allocation_size);
+        auto raw = a.allocate(_blocks_for(_allocation_size(capacity)));
         if (!raw) [[unlikely]]
             return nullptr; // allocator decides whether to throw or not
 
@@ -204,30 +256,106 @@ public:
         return result;
     }
 
+    // Takes ownership of [source, source + size); 'deleter(source)' runs on the last release().
+    // The deleter is kept in the same allocation as the header. If that allocation fails, the buffer is deleted at once.
+    template <class DeleterT>
+        requires std::is_invocable_v<DeleterT&, value_type*> && std::is_nothrow_move_constructible_v<DeleterT>
+    [[nodiscard]] static shared_data* adopt(value_type* source, size_type size, DeleterT deleter, const allocator_type& allocator = allocator_type())
+    {
+        using control_type = _adopted_block<DeleterT>;
+        static_assert(alignof(control_type) <= alignof(_block), "Deleter is overaligned");
+
+        assert(source || !size);
+        if (size > max_size())
+        {
+            deleter(source);
+            throw std::length_error("Cannot create string this long");
+        }
+
+        _raw_allocator a = allocator;
+        auto const blocks = _blocks_for(_adopted_offset() + sizeof(control_type));
+        _block* raw = nullptr;
+        try
+        {
+            raw = a.allocate(blocks);
+        }
+        catch (...)
+        {
+            deleter(source);
+            throw;
+        }
+
+        if (!raw) [[unlikely]]
+        {
+            deleter(source);
+            return nullptr;
+        }
+
+        auto result = new (static_cast<void*>(raw)) shared_data(std::move(a), AdoptedCapacity, nullptr, 0);
+        result->m_size = size;
+        new (static_cast<void*>(reinterpret_cast<std::byte*>(raw) + _adopted_offset())) control_type(source, blocks, std::move(deleter));
+        return result;
+    }
+
     [[nodiscard]] static constexpr size_type max_size() noexcept
     {
-        return (std::numeric_limits<size_type>::max() - padded_header_size()) / sizeof(value_type) - 1; // for '\0'
+        return (std::numeric_limits<size_type>::max() - padded_header_size() - sizeof(_block)) / sizeof(value_type) - 1; // for '\0'
+    }
+
+    // true if the caller holds the only reference, i.e. nobody else can observe changes to the buffer
+    [[nodiscard]] bool unique() const noexcept
+    {
+        return m_refs.load(std::memory_order_acquire) == 1;
+    }
+
+    // a snapshot, only meaningful while no other thread copies or releases the strings sharing the buffer
+    [[nodiscard]] size_type use_count() const noexcept
+    {
+        return m_refs.load(std::memory_order_acquire);
     }
 
-    [[nodiscard]] constexpr void add_ref() const noexcept
+    // the whole block, header included; an adopted buffer counts along with its control block
+    [[nodiscard]] size_type allocated_bytes() const noexcept
     {
-        m_refs++;
+        if (is_adopted())
+            return _adopted()->blocks * sizeof(_block) + m_size * sizeof(value_type);
+
+        return allocated_bytes_for(m_capacity);
+    }
+
+    // what a block created for 'capacity' characters takes, header included
+    [[nodiscard]] static constexpr size_type allocated_bytes_for(size_type capacity) noexcept
+    {
+        return _blocks_for(_allocation_size(capacity)) * sizeof(_block);
     }
 
-    size_type release() noexcept
+    constexpr void add_ref(size_type count = 1) const noexcept
     {
-        auto prev_refs = m_refs.fetch_sub(1, std::memory_order_acq_rel);
-        assert(prev_refs > 0);
-        if (prev_refs == 1)
+        m_refs.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    size_type release(size_type count = 1) noexcept
+    {
+        auto prev_refs = m_refs.fetch_sub(count, std::memory_order_acq_rel);
+        assert(prev_refs >= count);
+        if (prev_refs == count)
         {
             // that was the last reference
-            size_type allocation_size = sizeof(value_type) * m_capacity + padded_header_size();
+            auto blocks = _blocks_for(_allocation_size(m_capacity));
+            if (is_adopted())
+            {
+                auto const control = _adopted();
+                blocks = control->blocks;
+                control->destroy(control);
+            }
 
-            // no dtors called
-            m_allocator.deallocate(reinterpret_cast<std::byte*>(this), allocation_size);
+            // the allocator lives in the block being freed, so take it out first
+            _raw_allocator a(std::move(m_allocator));
+            this->~shared_data();
+            a.deallocate(reinterpret_cast<_block*>(this), blocks);
         }
 
-        return prev_refs - 1;
+        return prev_refs - count;
     }
 
     void append(const value_type* source, size_type size)
@@ -235,7 +363,7 @@ public:
         if (size) [[likely]]
         {
             assert(source);
-            if (size > m_capacity - m_size)
+            if (size > capacity() - m_size) // no room at all in an adopted buffer
                 throw std::length_error("Not enough room left");
 
             traits_type::copy(data() + m_size, source, size);
@@ -245,14 +373,81 @@ public:
         }
     }
 
+    // account for characters already written past the end, i.e. into [data() + size(), data() + capacity())
+    void commit(size_type size) noexcept
+    {
+        assert(!is_adopted()); // the terminator would go past a foreign buffer
+        assert(size <= capacity() - m_size);
+        m_size += size;
+        *(data() + m_size) = value_type{}; // always null-terminate
+    }
+
 private:
     template <class Al, class U>
     using _rebind_alloc = typename std::allocator_traits<Al>::template rebind_alloc<U>;
 
-    using _raw_allocator = _rebind_alloc<allocator_type, std::byte>;
+    // the unit of allocation; allocators honouring alignof() (e.g. std::pmr ones) would misalign the header otherwise
+    struct alignas(std::max_align_t) _block
+    {
+        std::byte raw[alignof(std::max_align_t)];
+    };
+
+    using _raw_allocator = _rebind_alloc<allocator_type, _block>;
+
+    [[nodiscard]] static constexpr size_type _blocks_for(size_type bytes) noexcept
+    {
+        return (bytes + sizeof(_block) - 1) / sizeof(_block);
+    }
 
     static constexpr size_type padded_header_size() noexcept;
 
+    [[nodiscard]] static constexpr size_type _allocation_size(size_type capacity) noexcept
+    {
+        return sizeof(value_type) * (capacity + 1) + padded_header_size();
+    }
+
+    // never a real capacity, see max_size()
+    static constexpr size_type AdoptedCapacity = std::numeric_limits<size_type>::max();
+
+    // follows the header of an adopted buffer instead of the characters
+    struct _adopted_control
+    {
+        value_type* data;
+        size_type blocks;
+        void (*destroy)(_adopted_control*) noexcept;
+    };
+
+    template <class DeleterT>
+    struct _adopted_block final
+        : _adopted_control
+    {
+        [[no_unique_address]] DeleterT deleter;
+
+        _adopted_block(value_type* source, size_type blocks, DeleterT&& d) noexcept(std::is_nothrow_move_constructible_v<DeleterT>)
+            : _adopted_control{ source, blocks, &_destroy }
+            , deleter(std::move(d))
+        {
+        }
+
+        static void _destroy(_adopted_control* control) noexcept
+        {
+            auto self = static_cast<_adopted_block*>(control);
+            self->deleter(self->data);
+            self->~_adopted_block();
+        }
+    };
+
+    [[nodiscard]] static constexpr size_type _adopted_offset() noexcept
+    {
+        return (padded_header_size() + sizeof(_block) - 1) / sizeof(_block) * sizeof(_block);
+    }
+
+    [[nodiscard]] _adopted_control* _adopted() const noexcept
+    {
+        auto start = reinterpret_cast<std::byte*>(const_cast<shared_data*>(this));
+        return std::launder(reinterpret_cast<_adopted_control*>(start + _adopted_offset()));
+    }
+
     ~shared_data() = default;
 
     constexpr shared_data(_raw_allocator&& allocator, size_type capacity, const value_type* source, size_type size) noexcept
@@ -271,7 +466,11 @@ private:
         }
     }
 
-    _raw_allocator m_allocator;
+    // stateful allocators (e.g. std::pmr::polymorphic_allocator) are stored in every buffer,
+    // so that all the strings sharing it release it through the originating resource
+    static_assert(sizeof(_raw_allocator) <= sizeof(void*), "Allocator must be a pointer-sized handle");
+
+    [[no_unique_address]] _raw_allocator m_allocator;
     mutable std::atomic<size_type> m_refs;
     size_type m_capacity;
     size_type m_size;
@@ -427,6 +626,190 @@ struct sso_storage
 };
 
 
+// fast non-cryptographic hash; consumes 8 bytes per step
+inline constexpr std::uint64_t HashSeed = 0x9e3779b97f4a7c15ull;
+
+[[nodiscard]] constexpr std::uint64_t hash_round(std::uint64_t h, std::uint64_t word) noexcept
+{
+    h ^= word * 0x87c37b91114253d5ull;
+    h = (h << 31) | (h >> 33);
+    return h * 0x4cf5ad432745937full;
+}
+
+[[nodiscard]] constexpr std::uint64_t hash_finalize(std::uint64_t h) noexcept
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+// the rest of hash_bytes() once 'h' has consumed the words before 'data'
+[[nodiscard]] inline std::uint64_t hash_bytes_from(std::uint64_t h, const void* data, std::size_t size) noexcept
+{
+    auto p = static_cast<const unsigned char*>(data);
+    while (size >= sizeof(std::uint64_t))
+    {
+        std::uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        h = hash_round(h, word);
+
+        p += sizeof(word);
+        size -= sizeof(word);
+    }
+
+    if (size)
+    {
+        std::uint64_t word = 0;
+        std::memcpy(&word, p, size);
+        h = hash_round(h, word);
+    }
+
+    return hash_finalize(h);
+}
+
+[[nodiscard]] inline std::uint64_t hash_bytes(const void* data, std::size_t size) noexcept
+{
+    return hash_bytes_from(HashSeed ^ size, data, size);
+}
+
+
+// the first 'size' bytes at 'p' (size <= 8) in the low bytes of a little-endian word, the rest are zeros;
+// overlapping loads instead of a variable-length memcpy
+[[nodiscard]] inline std::uint64_t load_partial_word(const void* p, std::size_t size) noexcept
+{
+    assert(size <= sizeof(std::uint64_t));
+    auto const b = static_cast<const unsigned char*>(p);
+    if (size >= 4)
+    {
+        std::uint32_t lo, hi;
+        std::memcpy(&lo, b, sizeof(lo));
+        std::memcpy(&hi, b + size - 4, sizeof(hi));
+        return lo | (std::uint64_t(hi) << (8 * (size - 4)));
+    }
+
+    if (size >= 2)
+    {
+        std::uint16_t lo, hi;
+        std::memcpy(&lo, b, sizeof(lo));
+        std::memcpy(&hi, b + size - 2, sizeof(hi));
+        return lo | (std::uint64_t(hi) << (8 * (size - 2)));
+    }
+
+    return size ? b[0] : 0;
+}
+
+[[nodiscard]] constexpr std::uint64_t low_bytes_mask(std::size_t size) noexcept
+{
+    return size >= sizeof(std::uint64_t) ? ~std::uint64_t(0) : (std::uint64_t(1) << (8 * size)) - 1;
+}
+
+// ASCII whitespace only: ' ', '\t', '\n', '\v', '\f', '\r'
+template <typename CharT>
+[[nodiscard]] constexpr bool is_space(CharT c) noexcept
+{
+    return c == CharT(' ') || (c >= CharT('\t') && c <= CharT('\r'));
+}
+
+#if defined(IMS_SSE2)
+
+// one bit per byte, set for the bytes of whitespace characters
+template <typename CharT>
+[[nodiscard]] inline unsigned space_mask(const CharT* p) noexcept
+{
+    auto const v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i r;
+    if constexpr (sizeof(CharT) == 1)
+        r = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('\t' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('\r' + 1))));
+    else if constexpr (sizeof(CharT) == 2)
+        r = _mm_or_si128(_mm_cmpeq_epi16(v, _mm_set1_epi16(' ')), _mm_and_si128(_mm_cmpgt_epi16(v, _mm_set1_epi16('\t' - 1)), _mm_cmplt_epi16(v, _mm_set1_epi16('\r' + 1))));
+    else
+        r = _mm_or_si128(_mm_cmpeq_epi32(v, _mm_set1_epi32(' ')), _mm_and_si128(_mm_cmpgt_epi32(v, _mm_set1_epi32('\t' - 1)), _mm_cmplt_epi32(v, _mm_set1_epi32('\r' + 1))));
+
+    return unsigned(_mm_movemask_epi8(r));
+}
+
+#endif
+
+// the number of whitespace characters at the start of [s, s + size)
+template <typename CharT>
+[[nodiscard]] constexpr std::size_t leading_spaces(const CharT* s, std::size_t size) noexcept
+{
+    // the usual case: nothing to trim
+    if (!size || !is_space(s[0]))
+        return 0;
+
+    std::size_t i = 0;
+#if defined(IMS_SSE2)
+    if (!std::is_constant_evaluated())
+    {
+        constexpr std::size_t PerVector = 16 / sizeof(CharT);
+        for (; i + PerVector <= size; i += PerVector)
+        {
+            auto const other = ~space_mask(s + i) & 0xffffu;
+            if (other)
+                return i + std::size_t(std::countr_zero(other)) / sizeof(CharT);
+        }
+    }
+#endif
+
+    while (i < size && is_space(s[i]))
+        ++i;
+
+    return i;
+}
+
+// the number of whitespace characters at the end of [s, s + size)
+template <typename CharT>
+[[nodiscard]] constexpr std::size_t trailing_spaces(const CharT* s, std::size_t size) noexcept
+{
+    if (!size || !is_space(s[size - 1]))
+        return 0;
+
+    std::size_t end = size;
+#if defined(IMS_SSE2)
+    if (!std::is_constant_evaluated())
+    {
+        constexpr std::size_t PerVector = 16 / sizeof(CharT);
+        for (; end >= PerVector; end -= PerVector)
+        {
+            auto const other = ~space_mask(s + end - PerVector) & 0xffffu;
+            if (other)
+                return size - (end - PerVector + (std::size_t(std::bit_width(other)) - 1) / sizeof(CharT) + 1);
+        }
+    }
+#endif
+
+    while (end && is_space(s[end - 1]))
+        --end;
+
+    return size - end;
+}
+
+
+} // namespace detail {}
+
+
+template <class StringT>
+class basic_compact_string;
+
+namespace detail
+{
+
+// the buffer behind a string, for helpers that report or manage memory
+template <class StringT>
+struct buffer_access
+{
+    using shared_data_type = typename StringT::_shared_data;
+
+    [[nodiscard]] static const shared_data_type* shared(const StringT& str) noexcept
+    {
+        return str._get_shared_no_add_ref();
+    }
+};
+
 } // namespace detail {}
 
 
@@ -434,6 +817,12 @@ template <class CharT, class TraitsT = std::char_traits<CharT>, class AllocatorT
 class basic_immutable_string final
 {
 private:
+    template <class StringT>
+    friend class basic_compact_string;
+
+    template <class StringT>
+    friend struct detail::buffer_access;
+
     static_assert(std::is_same_v<CharT, typename TraitsT::char_type>);
 
     template <class Al, class U>
@@ -448,6 +837,16 @@ public:
     struct FromStringLiteralT {};
     static constexpr FromStringLiteralT FromStringLiteral = {}; // this implies null terminator presence
 
+    // the characters are owned by the caller and outlive the string, its copies and substrings
+    // (static tables, read-only mapped files etc.); they need not be null-terminated
+    struct FromStaticStorageT {};
+    static constexpr FromStaticStorageT FromStaticStorage = {};
+
+    // the characters come in a buffer allocated by somebody else (malloc(), a decompression or RPC library etc.),
+    // the string takes it over along with the function that frees it
+    struct AdoptT {};
+    static constexpr AdoptT Adopt = {};
+
     using traits_type = TraitsT;
     using allocator_type = AllocatorT;
 
@@ -489,6 +888,12 @@ private:
             ptrs.initialize(nullptr, src, size, true);
         }
 
+        constexpr _universal_string_storage(const value_type* src, size_type size, bool null_terminated, FromStaticStorageT) noexcept
+        {
+            assert(src);
+            ptrs.initialize(nullptr, src, size, null_terminated);
+        }
+
         _universal_string_storage(const value_type* src, size_type size, const allocator_type& al)
         {
             assert((size == 0) || !!src);
@@ -568,11 +973,46 @@ public:
     {
     }
 
+    // borrows [source, source + size), no allocation; so do substr() and split() of it
+    constexpr basic_immutable_string(const_pointer source, size_type size, FromStaticStorageT) noexcept
+        : m_storage(size ? source : &_e, size, !size, FromStaticStorage)
+    {
+    }
+
+    // same, for storage known to hold a '\0' at source[size]; c_str() returns it without copying
+    constexpr basic_immutable_string(const_pointer source, size_type size, bool null_terminated, FromStaticStorageT) noexcept
+        : m_storage(source, size, null_terminated, FromStaticStorage)
+    {
+    }
+
     basic_immutable_string(const_pointer source, size_type size = size_type(-1), const allocator_type& a = allocator_type())
         : m_storage(source, size, a)
     {
     }
 
+    // No copy: 'deleter(source)' runs once the last string sharing the buffer is gone.
+    // Short strings are copied into SSO and the buffer is deleted right away.
+    template <class DeleterT>
+        requires std::is_invocable_v<DeleterT&, value_type*> && std::is_nothrow_move_constructible_v<DeleterT>
+    basic_immutable_string(value_type* source, size_type size, AdoptT, DeleterT deleter, const allocator_type& a = allocator_type())
+        : m_storage()
+    {
+        if (size <= _sso_max_size())
+        {
+            if (size)
+                m_storage.sso.initialize(source, size);
+
+            deleter(source);
+            return;
+        }
+
+        auto sd = _shared_data::adopt(source, size, std::move(deleter), a);
+        if (!sd) [[unlikely]]
+            throw std::bad_alloc();
+
+        m_storage.ptrs.initialize(sd, source, size, false);
+    }
+
     template <detail::IsStringViewish<value_type> StringViewT>
     basic_immutable_string(const StringViewT& str, const allocator_type& a = allocator_type())
         : basic_immutable_string(str.data(), str.size(), a)
@@ -702,11 +1142,151 @@ public:
         if (!len) [[unlikely]]
             return basic_immutable_string();
 
+        // a suffix keeps the terminator, if any
+        auto const null_terminated = (start + len == sz) && _has_null_terminator();
         auto stg = _get_shared_add_ref();
         if (!stg)
-            return basic_immutable_string(data() + start, len);
+        {
+            if (_is_short())
+                return basic_immutable_string(data() + start, len);
 
-        return basic_immutable_string(stg, data() + start, len, false);
+            // literals and static storage outlive us anyway
+            return basic_immutable_string(data() + start, len, null_terminated, FromStaticStorage);
+        }
+
+        return basic_immutable_string(stg, data() + start, len, null_terminated);
+    }
+
+    // Returns this string followed by 'str'.
+    // If this string is the sole owner of its buffer, ends where the buffer contents end and there is enough spare capacity,
+    // the buffer is extended in place; otherwise the contents move to a new buffer with 1.5x growth,
+    // so that s = std::move(s).with_appended(x) takes amortized O(1) per appended character.
+    template <detail::IsStringViewish<value_type> StringViewT>
+    [[nodiscard]] basic_immutable_string with_appended(const StringViewT& str) &&
+    {
+        auto const add_sz = size_type(str.size());
+        if (!add_sz) [[unlikely]]
+            return std::move(*this);
+
+        auto const sz = size();
+        if (add_sz > _size_and_pointers_max_size() - sz) [[unlikely]]
+            throw std::length_error("Cannot create string this long");
+
+        auto sd = _get_shared_no_add_ref();
+        if (sd && sd->unique() && (data() + sz == sd->data() + sd->size()) && (add_sz <= sd->capacity() - sd->size()))
+        {
+            traits_type::copy(sd->data() + sd->size(), str.data(), add_sz);
+            sd->commit(add_sz);
+
+            m_storage.ptrs.initialize(sd, data(), sz + add_sz, true); // still owns the reference
+            return std::move(*this);
+        }
+
+        if (sz + add_sz <= _sso_max_size())
+            return _concat(str.data(), add_sz);
+
+        auto const new_cap = std::max(sz + add_sz, std::min(sz + sz / 2, _size_and_pointers_max_size()));
+        typename _shared_data::ptr new_sd(_shared_data::create(new_cap, data(), sz, get_allocator()));
+        if (!new_sd) [[unlikely]]
+            throw std::bad_alloc();
+
+        new_sd->append(str.data(), add_sz);
+
+        auto d = new_sd->data();
+        return basic_immutable_string(new_sd.release(), d, sz + add_sz, true);
+    }
+
+    // copies into an exact-size buffer, 'this' is left untouched
+    template <detail::IsStringViewish<value_type> StringViewT>
+    [[nodiscard]] basic_immutable_string with_appended(const StringViewT& str) const&
+    {
+        auto const add_sz = size_type(str.size());
+        if (!add_sz) [[unlikely]]
+            return *this;
+
+        if (add_sz > _size_and_pointers_max_size() - size()) [[unlikely]]
+            throw std::length_error("Cannot create string this long");
+
+        return _concat(str.data(), add_sz);
+    }
+
+    [[nodiscard]] basic_immutable_string with_appended(const value_type* str) &&
+    {
+        return std::move(*this).with_appended(std::basic_string_view<value_type, traits_type>(str));
+    }
+
+    [[nodiscard]] basic_immutable_string with_appended(const value_type* str) const&
+    {
+        return with_appended(std::basic_string_view<value_type, traits_type>(str));
+    }
+
+    // Writes the substrings of [first, last) separated by 'delimiter' to 'out', in order;
+    // a delimiter at the very end does not start another (empty) substring.
+    // Substrings share the buffer like substr() does, but references to it are taken in batches
+    // rather than with one atomic increment per substring, so threads splitting the same string don't contend.
+    template <class OutputIt>
+    OutputIt split(value_type delimiter, OutputIt out, bool skip_empty = true, size_type first = 0, size_type last = npos) const
+    {
+        auto const sz = size();
+        if (last > sz)
+            last = sz;
+
+        if (first > last) [[unlikely]]
+            throw std::out_of_range("Start position for basic_immutable_string::split() exceeds string length");
+
+        auto const sd = _get_shared_no_add_ref();
+        auto const d = data();
+
+        // references taken but not handed out yet
+        size_type refs = 0;
+        try
+        {
+            while (first < last)
+            {
+                auto found = traits_type::find(d + first, last - first, delimiter);
+                auto const end = found ? size_type(found - d) : last;
+                auto const len = end - first;
+
+                if (len)
+                {
+                    if (!sd)
+                    {
+                        *out++ = substr(first, len);
+                    }
+                    else
+                    {
+                        if (!refs)
+                        {
+                            sd->add_ref(SplitRefBatch);
+                            refs = SplitRefBatch;
+                        }
+
+                        basic_immutable_string str(sd, d + first, len, end == sz && _has_null_terminator());
+                        --refs;
+
+                        *out++ = std::move(str);
+                    }
+                }
+                else if (!skip_empty)
+                {
+                    *out++ = basic_immutable_string();
+                }
+
+                first = end + 1;
+            }
+        }
+        catch (...)
+        {
+            if (refs)
+                sd->release(refs);
+
+            throw;
+        }
+
+        if (refs)
+            sd->release(refs);
+
+        return out;
     }
 
     [[nodiscard]] constexpr const_iterator begin() const noexcept
@@ -749,7 +1329,7 @@ public:
         return rend();
     }
 
-    [[nodiscard]] constexpr bool operator==(const basic_immutable_string& o) noexcept
+    [[nodiscard]] constexpr bool operator==(const basic_immutable_string& o) const noexcept
     {
         auto asz = size();
         auto bsz = o.size();
@@ -770,7 +1350,7 @@ public:
     [[nodiscard]] constexpr const_reference operator[](size_type index) const noexcept
     {
         assert(index < size());
-        return data() + index;
+        return data()[index];
     }
 
     constexpr size_type copy(pointer dest, size_type count, size_type pos = 0) const
@@ -796,7 +1376,7 @@ public:
     [[nodiscard]] constexpr size_type find(const StringViewT& what, size_type start_pos = 0) const noexcept
     {
         assert(what.data());
-        return _traits_find(data(), size(), start_pos, what.data(), what().size());
+        return _traits_find(data(), size(), start_pos, what.data(), what.size());
     }
 
     [[nodiscard]] constexpr size_type find(const value_type* what, size_type start_pos = 0) const noexcept
@@ -815,7 +1395,7 @@ public:
     [[nodiscard]] constexpr size_type rfind(const StringViewT& what, size_type start_pos = npos) const noexcept
     {
         assert(what.data());
-        return _traits_rfind(data(), size(), start_pos, what.data(), what().size());
+        return _traits_rfind(data(), size(), start_pos, what.data(), what.size());
     }
 
     [[nodiscard]] constexpr size_type rfind(const value_type* what, size_type start_pos = npos) const noexcept
@@ -830,22 +1410,176 @@ public:
         return _traits_rfind_ch(data(), size(), start_pos, ch);
     }
 
-    class builder final
+    template <detail::IsStringViewish<value_type> StringViewT>
+    [[nodiscard]] constexpr bool starts_with(const StringViewT& prefix) const noexcept
     {
-    public:
-        ~builder() = default;
+        return _starts_with(prefix.data(), size_type(prefix.size()));
+    }
 
-        builder(size_type reserve = 4096, const allocator_type& a = allocator_type())
-            : m_storage(_shared_data::create(std::max(reserve, MinReserve), nullptr, 0, a))
+    [[nodiscard]] constexpr bool starts_with(const value_type* prefix) const noexcept
+    {
+        assert(prefix);
+        return _starts_with(prefix, traits_type::length(prefix));
+    }
 
-        {
-        }
+    [[nodiscard]] constexpr bool starts_with(value_type ch) const noexcept
+    {
+        return !empty() && traits_type::eq(data()[0], ch);
+    }
+
+    template <detail::IsStringViewish<value_type> StringViewT>
+    [[nodiscard]] constexpr bool ends_with(const StringViewT& suffix) const noexcept
+    {
+        return _ends_with(suffix.data(), size_type(suffix.size()));
+    }
+
+    [[nodiscard]] constexpr bool ends_with(const value_type* suffix) const noexcept
+    {
+        assert(suffix);
+        return _ends_with(suffix, traits_type::length(suffix));
+    }
+
+    [[nodiscard]] constexpr bool ends_with(value_type ch) const noexcept
+    {
+        return !empty() && traits_type::eq(data()[size() - 1], ch);
+    }
+
+    template <detail::IsStringViewish<value_type> StringViewT>
+    [[nodiscard]] constexpr bool contains(const StringViewT& what) const noexcept
+    {
+        return find(what) != npos;
+    }
+
+    [[nodiscard]] constexpr bool contains(const value_type* what) const noexcept
+    {
+        return find(what) != npos;
+    }
+
+    [[nodiscard]] constexpr bool contains(value_type ch) const noexcept
+    {
+        return find(ch) != npos;
+    }
+
+    // Unlike std::string_view, these return the shortened string and leave this one as it is.
+    // The result shares the buffer, like substr() does.
+    [[nodiscard]] constexpr basic_immutable_string remove_prefix(size_type count) const
+    {
+        if (!count)
+            return *this;
+
+        return substr(count);
+    }
+
+    [[nodiscard]] constexpr basic_immutable_string remove_suffix(size_type count) const
+    {
+        auto const sz = size();
+        if (count > sz) [[unlikely]]
+            throw std::out_of_range("Suffix length for basic_immutable_string::remove_suffix() exceeds string length");
+
+        if (!count)
+            return *this;
+
+        return substr(0, sz - count);
+    }
+
+    // Strip ASCII whitespace. The result shares the buffer, like substr() does;
+    // a string with nothing to strip is returned as it is.
+    [[nodiscard]] constexpr basic_immutable_string trim() const
+    {
+        auto const sz = size();
+        auto const left = detail::leading_spaces(data(), sz);
+        auto const right = (left < sz) ? detail::trailing_spaces(data() + left, sz - left) : 0;
+        return _trimmed(left, right);
+    }
+
+    [[nodiscard]] constexpr basic_immutable_string trim_left() const
+    {
+        return _trimmed(detail::leading_spaces(data(), size()), 0);
+    }
+
+    [[nodiscard]] constexpr basic_immutable_string trim_right() const
+    {
+        return _trimmed(0, detail::trailing_spaces(data(), size()));
+    }
+
+    class builder final
+    {
+    public:
+        // what str() does with the spare capacity of the buffer
+        enum class shrink_policy
+        {
+            keep,               // share the buffer as is
+            fit_if_wasteful,    // copy into an exact-size buffer if more than a half of it is spare
+            fit                 // always copy into an exact-size buffer
+        };
+
+        using value_type = typename basic_immutable_string::value_type;
+        using traits_type = typename basic_immutable_string::traits_type;
+
+        ~builder() = default;
+
+        static constexpr size_type DefaultReserve = 4096;
+
+        // nothing is allocated until the contents outgrow the inline buffer, 'reserve' is the size of the first allocation
+        builder(size_type reserve = DefaultReserve, const allocator_type& a = allocator_type())
+            : m_allocator(a)
+            , m_reserve(reserve)
+        {
+        }
 
         builder(const builder&) = delete;
         builder& operator=(const builder&) = delete;
         builder(builder&&) = default;
         builder& operator=(builder&&) = default;
 
+        class output_iterator final
+        {
+        public:
+            using iterator_category = std::output_iterator_tag;
+            using value_type = void;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = void;
+
+            constexpr output_iterator() noexcept = default;
+
+            explicit constexpr output_iterator(builder& b) noexcept
+                : m_builder(&b)
+            {
+            }
+
+            output_iterator& operator=(CharT ch)
+            {
+                assert(m_builder);
+                m_builder->append(ch);
+                return *this;
+            }
+
+            [[nodiscard]] constexpr output_iterator& operator*() noexcept
+            {
+                return *this;
+            }
+
+            constexpr output_iterator& operator++() noexcept
+            {
+                return *this;
+            }
+
+            constexpr output_iterator operator++(int) noexcept
+            {
+                return *this;
+            }
+
+        private:
+            builder* m_builder = nullptr;
+        };
+
+        // suitable for std::format_to(), std::copy() etc.; characters go straight into the builder's buffer
+        [[nodiscard]] output_iterator out() noexcept
+        {
+            return output_iterator(*this);
+        }
+
         template <detail::IsStringViewish<value_type> StringT>
         builder& append(const StringT& str)
         {
@@ -853,44 +1587,225 @@ public:
             if (!add_sz) [[unlikely]]
                 return *this;
 
-            auto my_sz = m_storage->size();
-            auto my_cap = m_storage->capacity();
-            auto new_sz = my_sz + add_sz;
-            if (new_sz <= my_cap) [[likely]]
+            traits_type::copy(_make_room(add_sz), str.data(), add_sz);
+            _commit(add_sz);
+
+            return *this;
+        }
+
+        builder& append(const char* str)
+        {
+            return append(std::basic_string_view<value_type, traits_type>(str));
+        }
+
+        // lets 'op' write up to 'max_count' characters right into the buffer, 
+        // 'op(value_type* dest, size_type max_count)' returns the number of characters actually written
+        template <class OpT>
+        builder& append_with(size_type max_count, OpT&& op)
+        {
+            auto dest = _make_room(max_count);
+            size_type written = op(dest, max_count);
+            assert(written <= max_count);
+            _commit(written);
+            return *this;
+        }
+
+        builder& append(value_type ch)
+        {
+            *_make_room(1) = ch;
+            _commit(1);
+            return *this;
+        }
+
+        // formats the number with std::to_chars() right into the spare capacity; while the builder is still inline,
+        // into a stack buffer first, so that a short number never costs an allocation
+        template <detail::IsNumber NumberT>
+        builder& append(NumberT value)
+        {
+            if constexpr (std::is_integral_v<NumberT>)
             {
-                m_storage->append(str.data(), add_sz);
+                // sign + all the digits
+                return _append_chars(std::numeric_limits<NumberT>::digits10 + 2, [value](char* first, char* last) { return std::to_chars(first, last, value); });
             }
             else
             {
-                size_type new_cap = std::max(new_sz, my_cap + my_cap / 2);
-                typename _shared_data::ptr new_storage(_shared_data::create(new_cap, m_storage->data(), my_sz, m_storage->get_allocator()));
-                new_storage->append(str.data(), add_sz);
-                m_storage.swap(new_storage);
+                // sign + mantissa digits + '.' + 'e' + exponent sign + exponent digits
+                return _append_chars(std::numeric_limits<NumberT>::max_digits10 + 10, [value](char* first, char* last) { return std::to_chars(first, last, value); });
             }
+        }
 
-            return *this;
+        template <detail::IsNumber NumberT>
+            requires std::is_integral_v<NumberT>
+        builder& append(NumberT value, int base)
+        {
+            // sign + binary digits is the worst case
+            return _append_chars(std::numeric_limits<NumberT>::digits + 2, [value, base](char* first, char* last) { return std::to_chars(first, last, value, base); });
         }
 
-        builder& append(const char* str)
+        template <detail::IsNumber NumberT>
+            requires std::is_floating_point_v<NumberT>
+        builder& append(NumberT value, std::chars_format fmt, int precision)
         {
-            return append(std::basic_string_view<value_type, traits_type>(str));
+            // just a guess, it gets doubled if too small
+            size_type estimate = std::numeric_limits<NumberT>::max_digits10 + 10 + size_type(std::max(precision, 0));
+            return _append_chars(estimate, [value, fmt, precision](char* first, char* last) { return std::to_chars(first, last, value, fmt, precision); });
         }
 
-        basic_immutable_string str() const
+        [[nodiscard]] size_type size() const noexcept
         {
+            return m_storage ? m_storage->size() : m_small_size;
+        }
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return size() == 0;
+        }
+
+        // short results always go to SSO, long ones share the buffer unless 'policy' says otherwise;
+        // while any of the shared results is alive, the next append copies the buffer first
+        basic_immutable_string str(shrink_policy policy = shrink_policy::fit_if_wasteful) const
+        {
+            if (!m_storage)
+                return basic_immutable_string(m_small, m_small_size, m_allocator);
+
+            auto const sz = m_storage->size();
+            auto const spare = m_storage->capacity() - sz;
+            if ((sz <= _sso_max_size()) || (policy == shrink_policy::fit) || (policy == shrink_policy::fit_if_wasteful && spare > sz))
+                return basic_immutable_string(m_storage->data(), sz, m_storage->get_allocator());
+
             m_storage->add_ref();
-            return basic_immutable_string(m_storage.get(), m_storage->data(), m_storage->size(), true);
+            return basic_immutable_string(m_storage.get(), m_storage->data(), sz, true);
         }
 
     private:
-        static const size_type MinReserve = 1024;
-        _shared_data::ptr m_storage;
+        // makes sure there is room for 'add_sz' more characters and returns a pointer to the current end
+        value_type* _make_room(size_type add_sz)
+        {
+            if (!m_storage)
+            {
+                if (add_sz <= InlineCapacity - m_small_size) [[likely]]
+                    return m_small + m_small_size;
+
+                if (add_sz > _shared_data::max_size() - m_small_size)
+                    throw std::length_error("Cannot create string this long");
+
+                // spill the inline buffer
+                m_storage.reset(_shared_data::create(std::max(m_small_size + add_sz, m_reserve), m_small, m_small_size, m_allocator));
+                if (!m_storage) [[unlikely]]
+                    throw std::bad_alloc();
+
+                return m_storage->data() + m_small_size;
+            }
+
+            auto my_sz = m_storage->size();
+            auto my_cap = m_storage->capacity();
+            auto const fits = add_sz <= my_cap - my_sz;
+
+            // strings returned by str() may share the buffer; they must not see it change, so copy on write
+            if (!fits || !m_storage->unique()) [[unlikely]]
+            {
+                if (add_sz > _shared_data::max_size() - my_sz)
+                    throw std::length_error("Cannot create string this long");
+
+                size_type new_cap = fits ? my_cap : std::max(my_sz + add_sz, my_cap + my_cap / 2);
+                typename _shared_data::ptr new_storage(_shared_data::create(new_cap, m_storage->data(), my_sz, m_storage->get_allocator()));
+                if (!new_storage) [[unlikely]]
+                    throw std::bad_alloc();
+
+                m_storage.swap(new_storage);
+            }
+
+            return m_storage->data() + my_sz;
+        }
+
+        // accounts for characters written to the pointer _make_room() returned
+        void _commit(size_type count) noexcept
+        {
+            if (m_storage)
+                m_storage->commit(count);
+            else
+                m_small_size += count;
+        }
+
+        template <class ToCharsF>
+        builder& _append_chars(size_type room, ToCharsF&& to_chars)
+        {
+            for (;; room *= 2)
+            {
+                bool done;
+                if constexpr (std::is_same_v<value_type, char>)
+                {
+                    // the worst-case width must not spill the inline buffer when the result is a few characters
+                    if (m_storage || room <= InlineCapacity - m_small_size)
+                        done = _to_chars_in_place(room, to_chars);
+                    else
+                        done = _to_chars_via_local(room, to_chars);
+                }
+                else
+                {
+                    // std::to_chars() only speaks char, so the output gets widened
+                    done = _to_chars_via_local(room, to_chars);
+                }
+
+                if (done) [[likely]]
+                    return *this;
+
+                if (room > _shared_data::max_size() / 2) [[unlikely]]
+                    throw std::length_error("Cannot create string this long");
+            }
+        }
+
+        template <class ToCharsF>
+        bool _to_chars_in_place(size_type room, ToCharsF& to_chars)
+        {
+            auto first = _make_room(room);
+            auto result = to_chars(first, first + room);
+            if (result.ec != std::errc{}) [[unlikely]]
+                return false;
+
+            _commit(size_type(result.ptr - first));
+            return true;
+        }
+
+        // formats into a local buffer, then makes room for exactly as many characters as there are
+        template <class ToCharsF>
+        bool _to_chars_via_local(size_type room, ToCharsF& to_chars)
+        {
+            char local[128];
+            std::unique_ptr<char[]> heap;
+            auto first = local;
+            if (room > sizeof(local))
+            {
+                heap.reset(new char[room]);
+                first = heap.get();
+            }
+
+            auto result = to_chars(first, first + room);
+            if (result.ec != std::errc{}) [[unlikely]]
+                return false;
+
+            auto count = size_type(result.ptr - first);
+            auto dest = _make_room(count);
+            for (size_type i = 0; i < count; ++i)
+                dest[i] = value_type(first[i]);
+
+            _commit(count);
+            return true;
+        }
+
+        static constexpr size_type InlineCapacity = _universal_string_storage::sso_storage_t::MaxSize;
+
+        allocator_type m_allocator;
+        size_type m_reserve;
+        typename _shared_data::ptr m_storage;
+        size_type m_small_size = 0;
+        value_type m_small[InlineCapacity];
     };
 
     template <class StringT>
     [[nodiscard]] friend builder operator+(const basic_immutable_string& a, StringT&& b)
     {
-        builder bld;
+        builder bld(builder::DefaultReserve, a.get_allocator());
         bld.append(a).append(std::forward<StringT>(b));
         return bld;
     }
@@ -907,6 +1822,122 @@ public:
     {
     }
 
+    // Creates a string of exactly 'size' characters written by 'fill(pointer dest)', with at most one allocation.
+    // Short strings end up in SSO.
+    template <class FillT>
+    [[nodiscard]] static basic_immutable_string create(size_type size, FillT&& fill, const allocator_type& a = allocator_type())
+    {
+        if (!size) [[unlikely]]
+            return basic_immutable_string();
+
+        if (size <= _sso_max_size())
+        {
+            value_type buffer[_sso_max_size()];
+            fill(static_cast<pointer>(buffer));
+            return basic_immutable_string(buffer, size, a);
+        }
+
+        if (size > _size_and_pointers_max_size()) [[unlikely]]
+            throw std::length_error("Cannot create string this long");
+
+        typename _shared_data::ptr sd(_shared_data::create(size, nullptr, 0, a));
+        if (!sd) [[unlikely]]
+            throw std::bad_alloc();
+
+        fill(sd->data());
+        sd->commit(size);
+
+        auto d = sd->data();
+        return basic_immutable_string(sd.release(), d, size, true);
+    }
+
+    // Materializes a string for every view in 'views' with at most one allocation:
+    // short ones go to SSO, the rest become substrings of a single shared block, laid out contiguously.
+    // With 'null_terminate' each of them gets its own '\0', so c_str() never allocates.
+    template <std::ranges::forward_range RangeT, class OutputIt>
+        requires detail::IsStringViewish<std::ranges::range_value_t<RangeT>, value_type>
+    static OutputIt create_batch(const RangeT& views, OutputIt out, bool null_terminate = true, const allocator_type& a = allocator_type())
+    {
+        size_type const terminator = null_terminate ? 1 : 0;
+        size_type total = 0;
+        size_type shared_count = 0;
+        for (auto& v : views)
+        {
+            auto sz = size_type(v.size());
+            if (sz > _sso_max_size())
+            {
+                if (sz > _size_and_pointers_max_size() || total + sz + terminator < total) [[unlikely]]
+                    throw std::length_error("Cannot create string this long");
+
+                total += sz + terminator;
+                ++shared_count;
+            }
+        }
+
+        if (!shared_count)
+        {
+            for (auto& v : views)
+                *out++ = basic_immutable_string(v.data(), v.size(), a);
+
+            return out;
+        }
+
+        auto sd = _shared_data::create(total, nullptr, 0, a);
+        if (!sd) [[unlikely]]
+            throw std::bad_alloc();
+
+        // every shared string owns one reference
+        sd->add_ref(shared_count - 1);
+
+        auto dest = sd->data();
+        for (auto& v : views)
+        {
+            auto sz = size_type(v.size());
+            if (sz > _sso_max_size())
+            {
+                traits_type::copy(dest, v.data(), sz);
+                if (null_terminate)
+                    dest[sz] = value_type{};
+
+                dest += sz + terminator;
+            }
+        }
+
+        sd->commit(total);
+
+        // references not handed out yet
+        auto remaining = shared_count;
+        try
+        {
+            dest = sd->data();
+            for (auto& v : views)
+            {
+                auto sz = size_type(v.size());
+                if (sz > _sso_max_size())
+                {
+                    basic_immutable_string str(sd, dest, sz, null_terminate);
+                    --remaining;
+
+                    *out++ = std::move(str);
+                    dest += sz + terminator;
+                }
+                else
+                {
+                    *out++ = basic_immutable_string(v.data(), sz, a);
+                }
+            }
+        }
+        catch (...)
+        {
+            if (remaining)
+                sd->release(remaining);
+
+            throw;
+        }
+
+        return out;
+    }
+
     template <class OStreamT>
     friend OStreamT& operator<<(OStreamT& stream, const basic_immutable_string& str)
     {
@@ -915,6 +1946,18 @@ public:
     }
 
 private:
+    static constexpr size_type SplitRefBatch = 256;
+
+    [[nodiscard]] static constexpr size_type _sso_max_size() noexcept
+    {
+        return _universal_string_storage::sso_storage_t::MaxSize;
+    }
+
+    [[nodiscard]] static constexpr size_type _size_and_pointers_max_size() noexcept
+    {
+        return _universal_string_storage::size_and_pointers_t::MaxSize;
+    }
+
     constexpr basic_immutable_string(_shared_data* stg, const_pointer str, size_type sz, bool null_terminated) noexcept
         : m_storage(stg, str, sz, null_terminated) //  no add_ref()
     {
@@ -934,6 +1977,16 @@ private:
         return ptr;
     }
 
+    [[nodiscard]] basic_immutable_string _concat(const value_type* str, size_type add_sz) const
+    {
+        auto const sz = size();
+        return create(sz + add_sz, [this, sz, str, add_sz](pointer dest)
+        {
+            traits_type::copy(dest, data(), sz);
+            traits_type::copy(dest + sz, str, add_sz);
+        }, get_allocator());
+    }
+
     [[nodiscard]] _shared_data* _make_cstr() const
     {
         auto len = size();
@@ -984,6 +2037,70 @@ private:
         }
     }
 
+    // std::char_traits compare bytes, so characters may be compared a word at a time
+    static constexpr bool _bitwise_traits = std::is_same_v<traits_type, std::char_traits<value_type>> && (std::endian::native == std::endian::little);
+
+    [[nodiscard]] constexpr bool _starts_with(const_pointer what, size_type what_size) const noexcept
+    {
+        auto const sz = size();
+        if (what_size > sz)
+            return false;
+
+        auto const bytes = what_size * sizeof(value_type);
+        if (_bitwise_traits && !std::is_constant_evaluated() && _is_short() && bytes <= sizeof(std::uint64_t))
+        {
+            // 8 bytes from the start of SSO data are still inside this object
+            std::uint64_t word;
+            std::memcpy(&word, data(), sizeof(word));
+            return ((word ^ detail::load_partial_word(what, bytes)) & detail::low_bytes_mask(bytes)) == 0;
+        }
+
+        return traits_type::compare(data(), what, what_size) == 0;
+    }
+
+    [[nodiscard]] constexpr bool _ends_with(const_pointer what, size_type what_size) const noexcept
+    {
+        auto const sz = size();
+        if (what_size > sz)
+            return false;
+
+        if (!what_size)
+            return true;
+
+        auto const bytes = what_size * sizeof(value_type);
+        if (_bitwise_traits && !std::is_constant_evaluated() && _is_short() && bytes <= sizeof(std::uint64_t))
+        {
+            auto const string_bytes = sz * sizeof(value_type);
+            auto const needle = detail::load_partial_word(what, bytes);
+            std::uint64_t word;
+            if (string_bytes >= sizeof(word))
+            {
+                // the last 8 bytes, the suffix in the high ones
+                std::memcpy(&word, reinterpret_cast<const char*>(data() + sz) - sizeof(word), sizeof(word));
+                auto const shift = 8 * (sizeof(word) - bytes);
+                return ((word ^ (needle << shift)) >> shift) == 0;
+            }
+
+            // the whole string fits into the first 8 bytes of SSO data
+            std::memcpy(&word, data(), sizeof(word));
+            return (((word >> (8 * (string_bytes - bytes))) ^ needle) & detail::low_bytes_mask(bytes)) == 0;
+        }
+
+        return traits_type::compare(data() + sz - what_size, what, what_size) == 0;
+    }
+
+    [[nodiscard]] constexpr basic_immutable_string _trimmed(size_type left, size_type right) const
+    {
+        if (!left && !right)
+            return *this;
+
+        auto const sz = size();
+        if (left + right >= sz)
+            return basic_immutable_string();
+
+        return substr(left, sz - left - right);
+    }
+
     static constexpr size_type _traits_find_ch(const_pointer haystack, size_type hay_size, size_type start_pos, value_type ch) noexcept
     {
         // search [haystack, haystack + hay_size) for ch, at/after start_pos
@@ -1058,5 +2175,65 @@ private:
 
 using immutable_string = basic_immutable_string<char, std::char_traits<char>, std::allocator<char>>;
 using immutable_wstring = basic_immutable_string<wchar_t, std::char_traits<wchar_t>, std::allocator<wchar_t>>;
+using immutable_u8string = basic_immutable_string<char8_t, std::char_traits<char8_t>, std::allocator<char8_t>>;
+using immutable_u16string = basic_immutable_string<char16_t, std::char_traits<char16_t>, std::allocator<char16_t>>;
+using immutable_u32string = basic_immutable_string<char32_t, std::char_traits<char32_t>, std::allocator<char32_t>>;
+
+namespace detail
+{
+
+template <class T>
+struct is_immutable_string
+    : std::false_type
+{
+};
+
+template <class CharT, class TraitsT, class AllocatorT>
+struct is_immutable_string<basic_immutable_string<CharT, TraitsT, AllocatorT>>
+    : std::true_type
+{
+};
+
+template <class T>
+concept IsImmutableString = is_immutable_string<std::remove_cvref_t<T>>::value;
+
+} // namespace detail {}
+
+namespace pmr
+{
+
+// Buffers are allocated from the std::pmr::memory_resource passed to the constructor (the default resource otherwise);
+// copies and substrings share the buffer and release it through that same resource.
+// SSO strings and string literals allocate nothing, so their get_allocator() returns the default one.
+using immutable_string = basic_immutable_string<char, std::char_traits<char>, std::pmr::polymorphic_allocator<char>>;
+using immutable_wstring = basic_immutable_string<wchar_t, std::char_traits<wchar_t>, std::pmr::polymorphic_allocator<wchar_t>>;
+
+} // namespace pmr {}
+
+} // namespace ims {}
+
+
+template <class CharT, class TraitsT, class AllocatorT>
+struct std::hash<ims::basic_immutable_string<CharT, TraitsT, AllocatorT>>
+{
+    [[nodiscard]] std::size_t operator()(const ims::basic_immutable_string<CharT, TraitsT, AllocatorT>& str) const noexcept
+    {
+        return static_cast<std::size_t>(ims::detail::hash_bytes(str.data(), str.size() * sizeof(CharT)));
+    }
+};
+
+
+#if defined(__cpp_lib_format)
+
+template <class CharT, class TraitsT, class AllocatorT>
+struct std::formatter<ims::basic_immutable_string<CharT, TraitsT, AllocatorT>, CharT>
+    : std::formatter<std::basic_string_view<CharT>, CharT>
+{
+    template <class FormatContextT>
+    auto format(const ims::basic_immutable_string<CharT, TraitsT, AllocatorT>& str, FormatContextT& ctx) const
+    {
+        return std::formatter<std::basic_string_view<CharT>, CharT>::format(std::basic_string_view<CharT>(str.data(), str.size()), ctx);
+    }
+};
 
-} // namespace ims {}
\ No newline at end of file
+#endif // __cpp_lib_format
\ No newline at end of file
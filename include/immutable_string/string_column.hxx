@@ -0,0 +1,365 @@
+#pragma once
+
+
+#include <immutable_string/string.hxx>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace ims
+{
+
+// Column of strings stored as one character buffer (an immutable string itself) plus packed offsets,
+// i.e. sizeof(OffsetT) bytes per element instead of sizeof(basic_immutable_string) + a refcount touch per copy.
+// operator[] returns a zero-copy substring of the buffer; view() and iteration yield string views
+// and involve no refcounting at all.
+// Appends extend the buffer in place while the column is its sole owner (see basic_immutable_string::with_appended()),
+// so strings obtained with operator[] or slices sharing the buffer make the next append copy it.
+// Slices share the buffer and copy only their offsets.
+template <class StringT = immutable_string, class OffsetT = std::uint32_t>
+class basic_string_column final
+{
+public:
+    using string_type = StringT;
+    using value_type = typename StringT::value_type;
+    using traits_type = typename StringT::traits_type;
+    using allocator_type = typename StringT::allocator_type;
+    using size_type = std::size_t;
+    using offset_type = OffsetT;
+    using view_type = std::basic_string_view<value_type, traits_type>;
+
+    static_assert(std::is_unsigned_v<offset_type>);
+
+    static constexpr size_type npos = size_type(-1);
+
+    class const_iterator final
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = view_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = view_type;
+
+        constexpr const_iterator() noexcept = default;
+
+        constexpr const_iterator(const typename StringT::value_type* chars, const offset_type* offset) noexcept
+            : m_chars(chars)
+            , m_offset(offset)
+        {
+        }
+
+        [[nodiscard]] constexpr view_type operator*() const noexcept
+        {
+            return view_type(m_chars + m_offset[0], m_offset[1] - m_offset[0]);
+        }
+
+        [[nodiscard]] constexpr view_type operator[](difference_type n) const noexcept
+        {
+            return *(*this + n);
+        }
+
+        constexpr const_iterator& operator++() noexcept
+        {
+            ++m_offset;
+            return *this;
+        }
+
+        constexpr const_iterator operator++(int) noexcept
+        {
+            auto tmp = *this;
+            ++m_offset;
+            return tmp;
+        }
+
+        constexpr const_iterator& operator--() noexcept
+        {
+            --m_offset;
+            return *this;
+        }
+
+        constexpr const_iterator operator--(int) noexcept
+        {
+            auto tmp = *this;
+            --m_offset;
+            return tmp;
+        }
+
+        constexpr const_iterator& operator+=(difference_type n) noexcept
+        {
+            m_offset += n;
+            return *this;
+        }
+
+        constexpr const_iterator& operator-=(difference_type n) noexcept
+        {
+            m_offset -= n;
+            return *this;
+        }
+
+        [[nodiscard]] friend constexpr const_iterator operator+(const_iterator it, difference_type n) noexcept
+        {
+            return it += n;
+        }
+
+        [[nodiscard]] friend constexpr const_iterator operator+(difference_type n, const_iterator it) noexcept
+        {
+            return it += n;
+        }
+
+        [[nodiscard]] friend constexpr const_iterator operator-(const_iterator it, difference_type n) noexcept
+        {
+            return it -= n;
+        }
+
+        [[nodiscard]] friend constexpr difference_type operator-(const const_iterator& a, const const_iterator& b) noexcept
+        {
+            return a.m_offset - b.m_offset;
+        }
+
+        [[nodiscard]] constexpr bool operator==(const const_iterator& o) const noexcept
+        {
+            return m_offset == o.m_offset;
+        }
+
+        [[nodiscard]] constexpr auto operator<=>(const const_iterator& o) const noexcept
+        {
+            return m_offset <=> o.m_offset;
+        }
+
+    private:
+        const typename StringT::value_type* m_chars = nullptr;
+        const offset_type* m_offset = nullptr;
+    };
+
+    using iterator = const_iterator;
+
+    explicit basic_string_column(const allocator_type& a = allocator_type())
+        : m_allocator(a)
+        , m_offsets(1, offset_type(0), _offset_allocator(a))
+    {
+    }
+
+    template <std::ranges::input_range RangeT>
+        requires detail::IsStringViewish<std::ranges::range_value_t<RangeT>, value_type>
+    explicit basic_string_column(const RangeT& strings, const allocator_type& a = allocator_type())
+        : basic_string_column(a)
+    {
+        append(strings);
+    }
+
+    [[nodiscard]] size_type size() const noexcept
+    {
+        return m_offsets.size() - 1;
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    // no refcounting; valid until the column is modified
+    [[nodiscard]] view_type view(size_type i) const noexcept
+    {
+        assert(i < size());
+        return view_type(m_chars.data() + m_offsets[i], m_offsets[i + 1] - m_offsets[i]);
+    }
+
+    // zero-copy substring of the buffer
+    [[nodiscard]] string_type operator[](size_type i) const
+    {
+        assert(i < size());
+        return m_chars.substr(m_offsets[i], m_offsets[i + 1] - m_offsets[i]);
+    }
+
+    [[nodiscard]] string_type at(size_type i) const
+    {
+        if (i >= size())
+            throw std::out_of_range("basic_string_column index out of range");
+
+        return (*this)[i];
+    }
+
+    [[nodiscard]] const_iterator begin() const noexcept
+    {
+        return const_iterator(m_chars.data(), m_offsets.data());
+    }
+
+    [[nodiscard]] const_iterator end() const noexcept
+    {
+        return const_iterator(m_chars.data(), m_offsets.data() + size());
+    }
+
+    // the characters of all the elements back to back
+    [[nodiscard]] const string_type& chars() const noexcept
+    {
+        return m_chars;
+    }
+
+    template <detail::IsStringViewish<value_type> StringViewT>
+    void push_back(const StringViewT& str)
+    {
+        auto const sz = size_type(str.size());
+        _check_room(sz);
+
+        // the offset goes first, so that the characters are the last thing that can fail
+        m_offsets.push_back(offset_type(m_chars.size() + sz));
+        try
+        {
+            _append_chars(view_type(str.data(), sz));
+        }
+        catch (...)
+        {
+            m_offsets.pop_back();
+            throw;
+        }
+    }
+
+    void push_back(const value_type* str)
+    {
+        push_back(view_type(str));
+    }
+
+    template <std::ranges::input_range RangeT>
+        requires detail::IsStringViewish<std::ranges::range_value_t<RangeT>, value_type>
+    void append(const RangeT& strings)
+    {
+        if constexpr (std::ranges::forward_range<RangeT>)
+        {
+            // check the whole batch at once, so that a failure leaves the column intact
+            size_type total = 0;
+            size_type count = 0;
+            for (auto& s : strings)
+            {
+                total += size_type(s.size());
+                ++count;
+            }
+
+            _check_room(total);
+            _reserve_offsets(count);
+        }
+
+        for (auto& s : strings)
+            push_back(s);
+    }
+
+    // appends all the elements of 'other'
+    void append(const basic_string_column& other)
+    {
+        if (other.empty())
+            return;
+
+        _check_room(other.m_chars.size());
+        _reserve_offsets(other.size());
+
+        auto const base = offset_type(m_chars.size());
+        _append_chars(view_type(other.m_chars.data(), other.m_chars.size()));
+        for (size_type i = 1; i < other.m_offsets.size(); ++i)
+            m_offsets.push_back(offset_type(base + other.m_offsets[i]));
+    }
+
+    // concatenation with a single buffer allocation
+    [[nodiscard]] friend basic_string_column operator+(const basic_string_column& a, const basic_string_column& b)
+    {
+        basic_string_column result(a.m_allocator);
+        result._check_room(a.m_chars.size() + b.m_chars.size());
+
+        auto const a_size = a.m_chars.size();
+        auto const b_size = b.m_chars.size();
+        result.m_chars = string_type::create(a_size + b_size, [&a, &b, a_size, b_size](value_type* dest)
+        {
+            traits_type::copy(dest, a.m_chars.data(), a_size);
+            traits_type::copy(dest + a_size, b.m_chars.data(), b_size);
+        }, a.m_allocator);
+
+        result.m_offsets.reserve(a.m_offsets.size() + b.size());
+        result.m_offsets.assign(a.m_offsets.begin(), a.m_offsets.end());
+        for (size_type i = 1; i < b.m_offsets.size(); ++i)
+            result.m_offsets.push_back(offset_type(a_size + b.m_offsets[i]));
+
+        return result;
+    }
+
+    // 'count' elements starting at 'first'; shares the buffer, copies the offsets
+    [[nodiscard]] basic_string_column slice(size_type first, size_type count = npos) const
+    {
+        if (first > size())
+            throw std::out_of_range("Start position for basic_string_column::slice() exceeds column size");
+
+        count = std::min(count, size() - first);
+
+        basic_string_column result(m_allocator);
+        if (!count)
+            return result;
+
+        auto const base = m_offsets[first];
+        result.m_chars = m_chars.substr(base, m_offsets[first + count] - base);
+
+        result.m_offsets.resize(count + 1);
+        for (size_type i = 0; i <= count; ++i)
+            result.m_offsets[i] = offset_type(m_offsets[first + i] - base);
+
+        return result;
+    }
+
+    // what the column takes in memory, including spare capacity of the buffer and the offsets;
+    // a buffer shared with a slice is counted as a whole
+    [[nodiscard]] size_type memory_usage() const noexcept
+    {
+        auto const sd = detail::buffer_access<string_type>::shared(m_chars);
+        return sizeof(*this) + (sd ? sd->allocated_bytes() : 0) + m_offsets.capacity() * sizeof(offset_type);
+    }
+
+private:
+    using _offset_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<offset_type>;
+
+    void _check_room(size_type add) const
+    {
+        if (add > size_type(std::numeric_limits<offset_type>::max()) - m_chars.size())
+            throw std::length_error("basic_string_column buffer exceeds the offset type range");
+    }
+
+    // keeps the growth geometric when appended to in small batches
+    void _reserve_offsets(size_type add)
+    {
+        auto const needed = m_offsets.size() + add;
+        if (needed > m_offsets.capacity())
+            m_offsets.reserve(std::max(needed, m_offsets.capacity() * 2));
+    }
+
+    void _append_chars(view_type str)
+    {
+        if (str.empty())
+            return;
+
+        if (m_chars.get_allocator() == m_allocator)
+        {
+            // in place if possible, 1.5x growth otherwise
+            m_chars = std::move(m_chars).with_appended(str);
+        }
+        else
+        {
+            // SSO contents don't know the allocator yet
+            auto const sz = m_chars.size();
+            m_chars = string_type::create(sz + str.size(), [this, sz, str](value_type* dest)
+            {
+                traits_type::copy(dest, m_chars.data(), sz);
+                traits_type::copy(dest + sz, str.data(), str.size());
+            }, m_allocator);
+        }
+    }
+
+    allocator_type m_allocator;
+    string_type m_chars;
+    std::vector<offset_type, _offset_allocator> m_offsets; // size() + 1 entries, the first one is always 0
+};
+
+
+using string_column = basic_string_column<immutable_string>;
+
+} // namespace ims {}
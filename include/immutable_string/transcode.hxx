@@ -0,0 +1,370 @@
+#pragma once
+
+
+#include <immutable_string/string.hxx>
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace ims
+{
+
+namespace detail
+{
+
+// the encoding is implied by the code unit width: 1 byte is UTF-8, 2 bytes is UTF-16, 4 bytes is UTF-32;
+// so wchar_t strings are UTF-16 on Windows and UTF-32 elsewhere
+template <class CharT>
+[[nodiscard]] constexpr std::uint32_t code_unit(CharT ch) noexcept
+{
+    return static_cast<typename raw_from_char<CharT>::raw_type>(ch);
+}
+
+// length of the leading run of ASCII characters
+template <class CharT>
+[[nodiscard]] inline std::size_t ascii_run(const CharT* src, std::size_t size) noexcept
+{
+    std::size_t i = 0;
+
+#if defined(IMS_SSE2)
+    constexpr std::size_t PerVector = 16 / sizeof(CharT);
+    for (; i + PerVector <= size; i += PerVector)
+    {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        unsigned non_ascii;
+        if constexpr (sizeof(CharT) == 1)
+        {
+            non_ascii = unsigned(_mm_movemask_epi8(v));
+        }
+        else
+        {
+            // any bit above the lowest 7 set
+            __m128i is_ascii;
+            if constexpr (sizeof(CharT) == 2)
+                is_ascii = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(short(0xff80))), _mm_setzero_si128());
+            else
+                is_ascii = _mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(int(0xffffff80))), _mm_setzero_si128());
+
+            non_ascii = ~unsigned(_mm_movemask_epi8(is_ascii)) & 0xffff;
+        }
+
+        if (non_ascii)
+            return i + unsigned(std::countr_zero(non_ascii)) / sizeof(CharT);
+    }
+#else
+    if constexpr (sizeof(CharT) == 1)
+    {
+        for (; i + 8 <= size; i += 8)
+        {
+            std::uint64_t w;
+            std::memcpy(&w, src + i, 8);
+            if (w & 0x8080808080808080ull)
+                break;
+        }
+    }
+#endif
+
+    while (i < size && code_unit(src[i]) < 0x80)
+        ++i;
+
+    return i;
+}
+
+// widens or narrows ASCII characters
+template <class ToT, class FromT>
+inline void copy_ascii(ToT* dest, const FromT* src, std::size_t size) noexcept
+{
+    if constexpr (sizeof(ToT) == sizeof(FromT))
+    {
+        std::memcpy(dest, src, size * sizeof(FromT));
+        return;
+    }
+
+    std::size_t i = 0;
+
+#if defined(IMS_SSE2)
+    auto const zero = _mm_setzero_si128();
+    if constexpr (sizeof(FromT) == 1)
+    {
+        for (; i + 16 <= size; i += 16)
+        {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            auto lo = _mm_unpacklo_epi8(v, zero);
+            auto hi = _mm_unpackhi_epi8(v, zero);
+            if constexpr (sizeof(ToT) == 2)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), lo);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 8), hi);
+            }
+            else
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_unpacklo_epi16(lo, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 4), _mm_unpackhi_epi16(lo, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 8), _mm_unpacklo_epi16(hi, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 12), _mm_unpackhi_epi16(hi, zero));
+            }
+        }
+    }
+    else if constexpr (sizeof(ToT) == 1)
+    {
+        // all the values are below 0x80, so saturating packs are exact
+        for (; i + 16 <= size; i += 16)
+        {
+            auto s = reinterpret_cast<const __m128i*>(src + i);
+            __m128i lo, hi;
+            if constexpr (sizeof(FromT) == 2)
+            {
+                lo = _mm_loadu_si128(s);
+                hi = _mm_loadu_si128(s + 1);
+            }
+            else
+            {
+                lo = _mm_packs_epi32(_mm_loadu_si128(s), _mm_loadu_si128(s + 1));
+                hi = _mm_packs_epi32(_mm_loadu_si128(s + 2), _mm_loadu_si128(s + 3));
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packus_epi16(lo, hi));
+        }
+    }
+#endif
+
+    // UTF-16 <-> UTF-32 is a plain loop the compiler vectorizes by itself
+    for (; i < size; ++i)
+        dest[i] = static_cast<ToT>(code_unit(src[i]));
+}
+
+[[noreturn]] inline void invalid_encoding()
+{
+    throw std::range_error("Invalid Unicode sequence");
+}
+
+// decodes one code point and advances 'src'; throws std::range_error on malformed input
+template <class CharT>
+[[nodiscard]] inline char32_t decode(const CharT*& src, const CharT* end)
+{
+    auto const u = code_unit(*src);
+    if constexpr (sizeof(CharT) == 1)
+    {
+        std::uint32_t cp;
+        std::uint32_t min;
+        std::ptrdiff_t length;
+        if (u < 0x80)
+        {
+            ++src;
+            return char32_t(u);
+        }
+        else if ((u & 0xe0) == 0xc0)
+        {
+            cp = u & 0x1f;
+            min = 0x80;
+            length = 2;
+        }
+        else if ((u & 0xf0) == 0xe0)
+        {
+            cp = u & 0x0f;
+            min = 0x800;
+            length = 3;
+        }
+        else if ((u & 0xf8) == 0xf0)
+        {
+            cp = u & 0x07;
+            min = 0x10000;
+            length = 4;
+        }
+        else
+        {
+            invalid_encoding();
+        }
+
+        if (end - src < length)
+            invalid_encoding();
+
+        for (std::ptrdiff_t k = 1; k < length; ++k)
+        {
+            auto c = code_unit(src[k]);
+            if ((c & 0xc0) != 0x80)
+                invalid_encoding();
+
+            cp = (cp << 6) | (c & 0x3f);
+        }
+
+        // overlong forms, surrogates and out of range values
+        if (cp < min || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff))
+            invalid_encoding();
+
+        src += length;
+        return char32_t(cp);
+    }
+    else if constexpr (sizeof(CharT) == 2)
+    {
+        if (u < 0xd800 || u > 0xdfff)
+        {
+            ++src;
+            return char32_t(u);
+        }
+
+        if (u > 0xdbff || end - src < 2)
+            invalid_encoding();
+
+        auto low = code_unit(src[1]);
+        if (low < 0xdc00 || low > 0xdfff)
+            invalid_encoding();
+
+        src += 2;
+        return char32_t(0x10000 + ((u - 0xd800) << 10) + (low - 0xdc00));
+    }
+    else
+    {
+        if (u > 0x10ffff || (u >= 0xd800 && u <= 0xdfff))
+            invalid_encoding();
+
+        ++src;
+        return char32_t(u);
+    }
+}
+
+template <class CharT>
+[[nodiscard]] constexpr std::size_t encoded_size(char32_t cp) noexcept
+{
+    if constexpr (sizeof(CharT) == 1)
+        return (cp < 0x80) ? 1 : (cp < 0x800) ? 2 : (cp < 0x10000) ? 3 : 4;
+    else if constexpr (sizeof(CharT) == 2)
+        return (cp < 0x10000) ? 1 : 2;
+    else
+        return 1;
+}
+
+template <class CharT>
+inline CharT* encode(char32_t cp, CharT* dest) noexcept
+{
+    auto const c = std::uint32_t(cp);
+    if constexpr (sizeof(CharT) == 1)
+    {
+        if (c < 0x80)
+        {
+            *dest++ = CharT(c);
+        }
+        else if (c < 0x800)
+        {
+            *dest++ = CharT(0xc0 | (c >> 6));
+            *dest++ = CharT(0x80 | (c & 0x3f));
+        }
+        else if (c < 0x10000)
+        {
+            *dest++ = CharT(0xe0 | (c >> 12));
+            *dest++ = CharT(0x80 | ((c >> 6) & 0x3f));
+            *dest++ = CharT(0x80 | (c & 0x3f));
+        }
+        else
+        {
+            *dest++ = CharT(0xf0 | (c >> 18));
+            *dest++ = CharT(0x80 | ((c >> 12) & 0x3f));
+            *dest++ = CharT(0x80 | ((c >> 6) & 0x3f));
+            *dest++ = CharT(0x80 | (c & 0x3f));
+        }
+    }
+    else if constexpr (sizeof(CharT) == 2)
+    {
+        if (c < 0x10000)
+        {
+            *dest++ = CharT(c);
+        }
+        else
+        {
+            *dest++ = CharT(0xd800 + ((c - 0x10000) >> 10));
+            *dest++ = CharT(0xdc00 + ((c - 0x10000) & 0x3ff));
+        }
+    }
+    else
+    {
+        *dest++ = CharT(c);
+    }
+
+    return dest;
+}
+
+// validates the input and returns the size of its transcoded form
+template <class ToT, class FromT>
+[[nodiscard]] std::size_t transcoded_size(const FromT* src, std::size_t size)
+{
+    auto const end = src + size;
+    std::size_t total = 0;
+    while (src < end)
+    {
+        if (code_unit(*src) < 0x80)
+        {
+            auto run = ascii_run(src, std::size_t(end - src));
+            total += run;
+            src += run;
+        }
+        else
+        {
+            total += encoded_size<ToT>(decode(src, end));
+        }
+    }
+
+    return total;
+}
+
+// the input must have been validated by transcoded_size()
+template <class ToT, class FromT>
+void transcode_to(ToT* dest, const FromT* src, std::size_t size)
+{
+    auto const end = src + size;
+    while (src < end)
+    {
+        if (code_unit(*src) < 0x80)
+        {
+            auto run = ascii_run(src, std::size_t(end - src));
+            copy_ascii(dest, src, run);
+            dest += run;
+            src += run;
+        }
+        else
+        {
+            dest = encode(decode(src, end), dest);
+        }
+    }
+}
+
+} // namespace detail {}
+
+
+// Converts 'str' (an immutable string, a std::basic_string[_view] etc.) between UTF-8, UTF-16 and UTF-32,
+// e.g. transcode<immutable_u8string>(u16), transcode<immutable_wstring>(utf8).
+// The output size is computed first, so there is exactly one allocation (none if the result fits into SSO);
+// runs of ASCII characters are checked and widened/narrowed 16 bytes at a time.
+// Malformed input (broken sequences, overlong forms, lone surrogates, values above U+10FFFF) throws std::range_error.
+// Converting a string to its own type is a no-op that shares the buffer.
+template <detail::IsImmutableString ToStringT, class FromT>
+[[nodiscard]] ToStringT transcode(const FromT& str, const typename ToStringT::allocator_type& a = typename ToStringT::allocator_type())
+{
+    using from_type = std::remove_cv_t<std::remove_pointer_t<decltype(str.data())>>;
+    using to_type = typename ToStringT::value_type;
+    static_assert(detail::IsCharacter<from_type>, "Input must be a string of characters");
+
+    if constexpr (std::is_same_v<std::remove_cvref_t<FromT>, ToStringT>)
+    {
+        return str;
+    }
+    else
+    {
+        auto const src = str.data();
+        auto const size = std::size_t(str.size());
+
+        // pure ASCII needs no further validation, its size never changes
+        auto const ascii = detail::ascii_run(src, size);
+        auto const total = (ascii == size) ? size : ascii + detail::transcoded_size<to_type>(src + ascii, size - ascii);
+
+        return ToStringT::create(total, [src, size, ascii](to_type* dest)
+        {
+            detail::copy_ascii(dest, src, ascii);
+            detail::transcode_to(dest + ascii, src + ascii, size - ascii);
+        }, a);
+    }
+}
+
+} // namespace ims {}
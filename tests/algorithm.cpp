@@ -0,0 +1,121 @@
+#include "common.h"
+
+#include <immutable_string/algorithm.hxx>
+
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace ims;
+
+static const char* const LONG_STRING = "Some very long string, can not fit into SSO buf";
+
+
+TEST(algorithm, join)
+{
+    // empty range
+    {
+        std::vector<immutable_string> v;
+        auto r = join(v, ", ");
+        EXPECT_TRUE(r.empty());
+    }
+
+    // single element shares its buffer
+    {
+        std::vector<immutable_string> v{ immutable_string(LONG_STRING) };
+        auto r = join(v, ", ");
+        EXPECT_EQ(r.data(), v[0].data());
+    }
+
+    // short result goes to SSO
+    {
+        std::vector<immutable_string> v{ immutable_string("a"), immutable_string("b"), immutable_string() , immutable_string("c") };
+        auto r = join(v, ',');
+        EXPECT_TRUE(r._is_short());
+        EXPECT_STREQ(r.c_str(), "a,b,,c");
+    }
+
+    // long result, any forward range of views
+    {
+        std::list<std::string_view> v{ "first part of the result", "second part of the result", "third" };
+        auto r = join<immutable_string>(v, std::string(" | "));
+        EXPECT_TRUE(r._is_shared());
+        EXPECT_TRUE(r._has_null_terminator());
+        EXPECT_STREQ(r.c_str(), "first part of the result | second part of the result | third");
+
+        auto r2 = join<immutable_string>(v, "");
+        EXPECT_STREQ(r2.c_str(), "first part of the resultsecond part of the resultthird");
+    }
+}
+
+TEST(algorithm, concat)
+{
+    immutable_string a(LONG_STRING);
+    immutable_string empty;
+
+    // the only non-empty part is returned as is
+    {
+        auto r = concat(empty, a, "", std::string_view());
+        EXPECT_EQ(r.data(), a.data());
+    }
+
+    {
+        auto r = concat(immutable_string("x"), '=', std::string_view("42"));
+        EXPECT_TRUE(r._is_short());
+        EXPECT_STREQ(r.c_str(), "x=42");
+    }
+
+    {
+        auto r = concat(a, ' ', std::string("and"), " ", a);
+        EXPECT_TRUE(r._is_shared());
+        EXPECT_EQ(std::string(r.c_str()), std::string(LONG_STRING) + " and " + LONG_STRING);
+    }
+
+    {
+        auto r = concat<immutable_wstring>(L"wide ", std::wstring_view(L"string that does not fit into SSO"));
+        EXPECT_EQ(std::wstring_view(r.data(), r.size()), L"wide string that does not fit into SSO");
+    }
+}
+
+TEST(algorithm, replace_all)
+{
+    immutable_string src("one two three two one two");
+
+    // nothing to replace, same buffer
+    {
+        auto r = replace_all(src, "four", "4");
+        EXPECT_EQ(r.data(), src.data());
+
+        r = replace_all(src, "", "4");
+        EXPECT_EQ(r.data(), src.data());
+    }
+
+    {
+        auto r = replace_all(src, "two", "2");
+        EXPECT_TRUE(r._is_short());
+        EXPECT_STREQ(r.c_str(), "one 2 three 2 one 2");
+    }
+
+    {
+        auto r = replace_all(src, "two", "twenty two");
+        EXPECT_STREQ(r.c_str(), "one twenty two three twenty two one twenty two");
+    }
+
+    {
+        auto r = replace_all(src, ' ', "");
+        EXPECT_STREQ(r.c_str(), "onetwothreetwoonetwo");
+    }
+
+    // non-overlapping, left to right
+    {
+        auto r = replace_all(immutable_string("aaaaa"), "aa", "b");
+        EXPECT_STREQ(r.c_str(), "bba");
+    }
+
+    // substring source
+    {
+        auto sub = src.substr(4, 9); // "two three"
+        auto r = replace_all(sub, "three", "3");
+        EXPECT_STREQ(r.c_str(), "two 3");
+    }
+}
@@ -0,0 +1,115 @@
+#include "common.h"
+
+#include <immutable_string/atomic_string.hxx>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ims;
+
+static const char* const LONG_STRING = "Some very long string, can not fit into SSO buf";
+
+
+TEST(atomic_immutable_string, basic)
+{
+    atomic_immutable_string a;
+    EXPECT_TRUE(a.load().empty());
+
+    // inline
+    a.store(immutable_string("abcde"));
+    EXPECT_STREQ(a.load().c_str(), "abcde");
+
+    // node
+    immutable_string long_string(LONG_STRING);
+    a = long_string;
+    auto loaded = a.load();
+    EXPECT_EQ(loaded.data(), long_string.data()); // shares the buffer
+
+    auto old = a.exchange(immutable_string("x"));
+    EXPECT_EQ(old.data(), long_string.data());
+    EXPECT_STREQ(immutable_string(a).c_str(), "x");
+
+    // compare by contents
+    immutable_string expected("y");
+    EXPECT_FALSE(a.compare_exchange(expected, long_string));
+    EXPECT_STREQ(expected.c_str(), "x");
+    EXPECT_TRUE(a.compare_exchange(expected, long_string));
+    EXPECT_EQ(a.load().data(), long_string.data());
+
+    expected = immutable_string(std::string(LONG_STRING));
+    EXPECT_TRUE(a.compare_exchange(expected, immutable_string("z")));
+    EXPECT_STREQ(a.load().c_str(), "z");
+}
+
+TEST(atomic_immutable_string, many_loads)
+{
+    // enough to top the tickets up a few times
+    atomic_immutable_string a{ immutable_string(LONG_STRING) };
+    for (int i = 0; i < 100000; ++i)
+        ASSERT_EQ(a.load().size(), std::strlen(LONG_STRING));
+
+    a.store(immutable_string());
+    EXPECT_TRUE(a.load().empty());
+}
+
+TEST(atomic_immutable_string, concurrent)
+{
+    std::vector<immutable_string> values;
+    for (int i = 0; i < 16; ++i)
+        values.emplace_back(std::string(LONG_STRING) + std::to_string(i));
+
+    values.emplace_back("abc"); // inline
+
+    atomic_immutable_string a(values[0]);
+    std::atomic<bool> stop = false;
+    std::atomic<unsigned> bad = 0;
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t)
+    {
+        readers.emplace_back([&]()
+        {
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                auto s = a.load();
+                auto found = std::find(values.begin(), values.end(), s) != values.end();
+                if (!found)
+                    ++bad;
+            }
+        });
+    }
+
+    std::thread writer([&]()
+    {
+        for (int i = 0; i < 20000; ++i)
+        {
+            auto& v = values[i % values.size()];
+            switch (i % 3)
+            {
+            case 0:
+                a.store(v);
+                break;
+            case 1:
+                (void)a.exchange(v);
+                break;
+            default:
+                {
+                    auto expected = a.load();
+                    a.compare_exchange(expected, v);
+                }
+                break;
+            }
+        }
+
+        stop = true;
+    });
+
+    writer.join();
+    for (auto& r : readers)
+        r.join();
+
+    EXPECT_EQ(bad.load(), 0u);
+}
@@ -0,0 +1,126 @@
+#include "common.h"
+#include "benchmark.h"
+
+#include <immutable_string/atomic_string.hxx>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+namespace
+{
+
+constexpr std::size_t LoadsPerThread = 1000000;
+
+// 'threads' readers load the value over and over while one writer keeps replacing it
+template <class LoadF, class StoreF>
+uint64_t run_readers(const RStringVector& values, unsigned threads, LoadF load, StoreF store)
+{
+    std::atomic<bool> stop = false;
+    std::thread writer([&values, &store, &stop]()
+    {
+        for (std::size_t i = 0; !stop.load(std::memory_order_relaxed); ++i)
+        {
+            store(values[i % values.size()]);
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    std::vector<std::thread> readers;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        readers.emplace_back([&load]()
+        {
+            uint64_t total = 0;
+            for (std::size_t i = 0; i < LoadsPerThread; ++i)
+                total += load().size();
+
+            if (!total)
+                std::cout << "ERROR: nothing loaded\n";
+        });
+    }
+
+    for (auto& r : readers)
+        r.join();
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    stop = true;
+    writer.join();
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+}
+
+template <class RunF>
+void run_scaling(const char* title, RunF run, unsigned runs, bool silent)
+{
+    if (!silent)
+        std::cout << title << "\n";
+
+    auto const max_threads = std::max(4u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+    {
+        uint64_t time = 0;
+        for (unsigned r = 0; r < runs; r++)
+            time += run(threads);
+
+        if (!silent)
+            std::cout << "Threads: " << std::setw(3) << threads << "  Loads/thread: " << LoadsPerThread << "  Time (ms): " << std::setw(8) << time / runs << "\n";
+    }
+
+    if (!silent)
+        std::cout << "--------------------------------------------------------------\n";
+}
+
+} // namespace {}
+
+
+void run_benchmark_atomic_string(const RStringVector& words, unsigned runs, bool silent)
+{
+    // long enough to need a shared buffer
+    RStringVector values;
+    for (std::size_t i = 0; i < 16 && i < words.size(); ++i)
+        values.push_back(RString(std::string(words[i].data(), words[i].size()) + " is a value long enough to be shared"));
+
+    if (values.empty())
+        return;
+
+    run_scaling("Loading ims::atomic_immutable_string...", [&values](unsigned threads)
+    {
+        basic_atomic_immutable_string<RString> value(values[0]);
+        return run_readers(values, threads, [&value]() { return value.load(); }, [&value](const RString& s) { value.store(s); });
+    }, runs, silent);
+
+    run_scaling("Loading immutable_string under std::mutex...", [&values](unsigned threads)
+    {
+        RString value(values[0]);
+        std::mutex mutex;
+        return run_readers(values, threads,
+            [&value, &mutex]() { std::lock_guard l(mutex); return value; },
+            [&value, &mutex](const RString& s) { std::lock_guard l(mutex); value = s; });
+    }, runs, silent);
+
+    run_scaling("Loading immutable_string under std::shared_mutex...", [&values](unsigned threads)
+    {
+        RString value(values[0]);
+        std::shared_mutex mutex;
+        return run_readers(values, threads,
+            [&value, &mutex]() { std::shared_lock l(mutex); return value; },
+            [&value, &mutex](const RString& s) { std::unique_lock l(mutex); value = s; });
+    }, runs, silent);
+
+#if defined(__cpp_lib_atomic_shared_ptr)
+    run_scaling("Loading std::atomic<std::shared_ptr<immutable_string>>...", [&values](unsigned threads)
+    {
+        std::atomic<std::shared_ptr<const RString>> value(std::make_shared<const RString>(values[0]));
+        return run_readers(values, threads,
+            [&value]() { return *value.load(); },
+            [&value](const RString& s) { value.store(std::make_shared<const RString>(s)); });
+    }, runs, silent);
+#endif
+}
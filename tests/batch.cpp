@@ -0,0 +1,110 @@
+#include "common.h"
+
+#include <immutable_string/batch.hxx>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace ims;
+
+namespace
+{
+
+// SSO and heap strings of every length up to a few hash words, in no particular order
+std::vector<immutable_string> make_strings(std::size_t count)
+{
+    std::vector<immutable_string> result;
+    for (std::size_t i = 0; i < count; ++i)
+        result.emplace_back(std::string(i * 7 % 53, char('a' + i % 26)) + std::to_string(i));
+
+    return result;
+}
+
+} // namespace {}
+
+
+TEST(batch, hash_many)
+{
+    auto const strings = make_strings(1000);
+    std::vector<std::size_t> hashes(strings.size());
+    hash_many(strings, hashes);
+    for (std::size_t i = 0; i < strings.size(); ++i)
+        EXPECT_EQ(hashes[i], std::hash<immutable_string>()(strings[i])) << i;
+
+    // string views of the same characters hash the same
+    std::vector<std::string_view> views;
+    for (auto& s : strings)
+        views.emplace_back(s.data(), s.size());
+
+    std::vector<std::size_t> view_hashes(views.size());
+    hash_many(views, view_hashes);
+    EXPECT_EQ(view_hashes, hashes);
+
+    std::vector<immutable_u32string> const wide = { U"", U"\x4e16", U"a wide string long enough not to fit into SSO" };
+    std::size_t wide_hashes[3];
+    hash_many(wide, wide_hashes);
+    EXPECT_EQ(wide_hashes[2], std::hash<immutable_u32string>()(wide[2]));
+
+    EXPECT_THROW(hash_many(strings, std::span<std::size_t>(hashes.data(), 10)), std::length_error);
+}
+
+TEST(batch, equal_many)
+{
+    auto const a = make_strings(1000);
+    auto b = a;
+    for (std::size_t i = 0; i < b.size(); i += 3)
+        b[i] = immutable_string(std::string(b[i].data(), b[i].size())); // equal, not shared
+
+    for (std::size_t i = 1; i < b.size(); i += 5)
+        b[i] = immutable_string(std::string(b[i].data(), b[i].size()) + "x");
+
+    for (std::size_t i = 2; i < b.size(); i += 7)
+        b[i] = b[i].substr(0, b[i].size() - 1) + immutable_string("?");
+
+    std::vector<char> expected(a.size());
+    std::size_t expected_count = 0;
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        expected[i] = (a[i] == b[i]);
+        expected_count += expected[i];
+    }
+
+    auto equal = std::make_unique<bool[]>(a.size());
+    EXPECT_EQ(equal_many(a, b, std::span<bool>(equal.get(), a.size())), expected_count);
+    for (std::size_t i = 0; i < a.size(); ++i)
+        EXPECT_EQ(equal[i], bool(expected[i])) << i;
+
+    EXPECT_THROW(equal_many(a, std::span<const immutable_string>(b.data(), 10), std::span<bool>(equal.get(), a.size())), std::invalid_argument);
+}
+
+TEST(batch, find_many)
+{
+    auto const strings = make_strings(5000);
+
+    std::vector<immutable_string> needles =
+    {
+        strings[4999], strings[0], immutable_string("missing"), strings[1234], strings[0], strings[77]
+    };
+
+    std::size_t positions[6];
+    EXPECT_EQ(find_many(strings, needles, positions), 5u);
+    EXPECT_EQ(positions[0], 4999u);
+    EXPECT_EQ(positions[1], 0u);
+    EXPECT_EQ(positions[2], std::size_t(-1));
+    EXPECT_EQ(positions[3], 1234u);
+    EXPECT_EQ(positions[4], 0u);
+    EXPECT_EQ(positions[5], 77u);
+
+    // the first occurrence counts
+    std::vector<std::string_view> const views = { "b", "a", "b", "c" };
+    std::vector<std::string_view> const what = { "b", "c", "d" };
+    EXPECT_EQ(find_many(views, what, positions), 2u);
+    EXPECT_EQ(positions[0], 0u);
+    EXPECT_EQ(positions[1], 3u);
+    EXPECT_EQ(positions[2], std::size_t(-1));
+
+    EXPECT_EQ(find_many(views, std::vector<std::string_view>(), positions), 0u);
+    EXPECT_THROW(find_many(strings, needles, std::span<std::size_t>(positions, 2)), std::length_error);
+}
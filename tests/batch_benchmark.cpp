@@ -0,0 +1,145 @@
+#include "common.h"
+#include "benchmark.h"
+
+#include <immutable_string/batch.hxx>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
+#include <unordered_map>
+
+namespace
+{
+
+template <class RunF>
+uint64_t measure(RunF run, unsigned runs, uint64_t& result)
+{
+    uint64_t time = 0;
+    for (unsigned r = 0; r < runs; r++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        result = run();
+        auto end = std::chrono::high_resolution_clock::now();
+        time += std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    }
+
+    return time / runs;
+}
+
+void report(const char* title, uint64_t time, uint64_t result, std::size_t count)
+{
+    std::cout << title << "\n";
+    std::cout << "Time (ms):          " << std::setw(12) << time << "\n";
+    std::cout << "Strings per us:     " << std::setw(12) << (time ? count / (time * 1000) : 0) << "\n";
+    std::cout << "Result:             " << std::setw(12) << result << "\n";
+    std::cout << "--------------------------------------------------------------\n";
+}
+
+// heap strings, in an order that has nothing to do with where their payloads are
+RStringVector make_strings(const std::vector<std::string_view>& words, std::size_t count, unsigned seed)
+{
+    RStringVector result;
+    result.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto const w = words[i % words.size()];
+        StdString s(w.data(), w.size());
+        s.append(" / ").append(std::to_string(i)).append(" / long enough for the heap");
+        result.emplace_back(s.data(), s.size());
+    }
+
+    std::shuffle(result.begin(), result.end(), std::mt19937(seed));
+    return result;
+}
+
+} // namespace {}
+
+
+// 10 strings per word, i.e. 10M elements with --size 1000000
+void run_benchmark_batch(const std::vector<std::string_view>& words, unsigned runs, bool silent)
+{
+    auto const count = words.size() * 10;
+    auto const a = make_strings(words, count, 1);
+    auto const b = make_strings(words, count, 1); // equal to a, but in buffers of their own
+
+    uint64_t result = 0;
+    auto time = measure([&a]()
+    {
+        uint64_t sum = 0;
+        for (auto& s : a)
+            sum += std::hash<RString>()(s);
+
+        return sum;
+    }, runs, result);
+
+    if (!silent)
+        report("Hashing with std::hash in a loop...", time, result, count);
+
+    std::vector<std::size_t> hashes(count);
+    time = measure([&a, &hashes]()
+    {
+        hash_many(a, hashes);
+        uint64_t sum = 0;
+        for (auto h : hashes)
+            sum += h;
+
+        return sum;
+    }, runs, result);
+
+    if (!silent)
+        report("Hashing with ims::hash_many()...", time, result, count);
+
+    time = measure([&a, &b]()
+    {
+        uint64_t equal = 0;
+        for (std::size_t i = 0; i < a.size(); ++i)
+            equal += (a[i] == b[i]);
+
+        return equal;
+    }, runs, result);
+
+    if (!silent)
+        report("Comparing with operator== in a loop...", time, result, count);
+
+    auto equal = std::make_unique<bool[]>(count);
+    time = measure([&a, &b, &equal, count]() { return uint64_t(equal_many(a, b, std::span<bool>(equal.get(), count))); }, runs, result);
+
+    if (!silent)
+        report("Comparing with ims::equal_many()...", time, result, count);
+
+    // needles near the end, so that most of the vector is scanned
+    RStringVector needles;
+    for (std::size_t i = 0; i < 1000; ++i)
+        needles.push_back(a[count - 1 - i * 37 % (count / 10)]);
+
+    time = measure([&a, &needles]()
+    {
+        std::unordered_map<RString, std::size_t> wanted;
+        for (auto& n : needles)
+            wanted.emplace(n, std::size_t(-1));
+
+        uint64_t found = 0;
+        for (std::size_t i = 0; i < a.size() && found < wanted.size(); ++i)
+        {
+            auto it = wanted.find(a[i]);
+            if (it != wanted.end() && it->second == std::size_t(-1))
+            {
+                it->second = i;
+                ++found;
+            }
+        }
+
+        return found;
+    }, runs, result);
+
+    if (!silent)
+        report("Finding 1000 strings with an unordered_map lookup per element...", time, result, count);
+
+    std::vector<std::size_t> positions(needles.size());
+    time = measure([&a, &needles, &positions]() { return uint64_t(find_many(a, needles, positions)); }, runs, result);
+
+    if (!silent)
+        report("Finding 1000 strings with ims::find_many()...", time, result, count);
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <immutable_string/string.hxx>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace ims;
+
+inline const char SEPARATOR = '\n';
+inline const char* const SSEPARATOR = "\n";
+
+class allocator_base
+{
+public:
+    void* allocate(size_t size)
+    {
+        auto p = std::malloc(size);
+        if (!p)
+            throw std::bad_alloc();
+
+        ++_allocations;
+        _allocated_bytes += size;
+        _live_bytes += size;
+
+        if (_verbose)
+            std::cout << "a " << size << "\n";
+
+        return p;
+    }
+
+    void deallocate(void* p, size_t size)
+    {
+        std::free(p);
+        _live_bytes -= size;
+
+        if (_verbose)
+            std::cout << "r " << size << "\n";
+    }
+
+    static inline uint64_t _allocations = 0;
+    static inline uint64_t _allocated_bytes = 0;
+    static inline uint64_t _live_bytes = 0;
+    static inline bool _verbose = false;
+};
+
+template <class _Ty>
+class BenchAllocator
+    : public allocator_base
+{
+public:
+    using value_type = _Ty;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    constexpr BenchAllocator() noexcept {}
+
+    constexpr BenchAllocator(const BenchAllocator&) noexcept = default;
+    
+    template <class _Other>
+    constexpr BenchAllocator(const BenchAllocator<_Other>&) noexcept {}
+    
+    constexpr ~BenchAllocator() = default;
+    constexpr BenchAllocator& operator=(const BenchAllocator&) = default;
+
+    constexpr void deallocate(_Ty* const _Ptr, const size_t _Count) 
+    {
+        allocator_base::deallocate(_Ptr, sizeof(_Ty) * _Count);
+    }
+
+    constexpr _Ty* allocate(const size_t _Count) 
+    {
+        return static_cast<_Ty*>(allocator_base::allocate(sizeof(_Ty) * _Count));
+    }
+
+    friend constexpr bool operator==(const BenchAllocator&, const BenchAllocator&) noexcept
+    {
+        return true;
+    }
+};
+
+using StdString = std::basic_string<char, std::char_traits<char>, BenchAllocator<char>>;
+using RString = basic_immutable_string<char, std::char_traits<char>, BenchAllocator<char>>;
+using OStringStream = std::basic_ostringstream<char, std::char_traits<char>, BenchAllocator<char>>;
+
+template <class StringT, class ContainerT>
+void split2(const StringT& source, ContainerT& receiver)
+{
+    size_t start = 0;
+
+    while (start < source.size())
+    {
+        const auto delim = source.find(SEPARATOR, start);
+        const auto end = (delim == StringT::npos) ? source.size() : delim;
+
+        if (start != end)
+        {
+            receiver.push_back(source.substr(start, end - start));
+        }
+        
+        if (delim == StringT::npos)
+            break;
+
+        start = delim + 1;
+    }
+}
+
+inline std::string format_memsize(uint64_t bytes)
+{
+    std::ostringstream stream;
+    if (bytes < 1024 * 10)
+    {
+        stream << bytes << " bytes";
+    }
+    else
+    {
+        stream << std::fixed << std::setprecision(3);
+        double v = bytes / 1024.0;
+        if (v < 1024 * 10)
+        {
+            stream << v << " Kb";
+        }
+        else
+        {
+            v /= 1024.0;
+            if (v < 1024 * 10)
+            {
+                stream << v << " Mb";
+            }
+            else
+            {
+                v /= 1024.0;
+                stream << v << " Gb";
+            }
+        }
+    }
+
+    return stream.str();
+}
+
+inline uint64_t elapsed_ms(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+inline uint64_t elapsed_us(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+
+using RStringVector = std::vector<RString, BenchAllocator<RString>>;
+
+void run_benchmark_atomic_string(const RStringVector& words, unsigned runs, bool silent);
+void run_benchmark_batch(const std::vector<std::string_view>& words, unsigned runs, bool silent);
+void run_benchmark_cold_string(const RString& source, unsigned runs, bool silent);
+void run_benchmark_compact_string(const std::vector<std::string_view>& words, unsigned runs, bool silent);
+void run_benchmark_escape(const std::vector<std::string_view>& words, unsigned runs, bool silent);
+void run_benchmark_line_index(const RString& source, unsigned runs, bool silent);
+void run_benchmark_concurrent_map(const RStringVector& words, unsigned runs, bool silent);
+void run_benchmark_numeric(std::size_t count, unsigned runs, bool silent);
+void run_benchmark_parallel(const RString& source, unsigned runs, bool silent);
+void run_benchmark_radix_tree(const RStringVector& words, unsigned runs, bool silent);
+void run_benchmark_static_map(const std::vector<std::string_view>& words, unsigned runs, bool silent);
+void run_benchmark_pmr(const std::vector<std::string_view>& words, unsigned runs, bool silent);
+void run_benchmark_string_column(const std::vector<std::string_view>& words, unsigned runs, bool silent);
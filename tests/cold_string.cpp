@@ -0,0 +1,180 @@
+#include "common.h"
+
+#include <immutable_string/cold_string.hxx>
+
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ims;
+
+namespace
+{
+
+// words from a small vocabulary, like most text
+std::string make_text(std::size_t size, unsigned seed)
+{
+    static const char* const words[] = { "immutable", "string", "cache", "entry", "cold", "payload", "the", "of", "and", "compressed" };
+
+    std::mt19937 gen(seed);
+    std::string text;
+    while (text.size() < size)
+    {
+        text += words[gen() % std::size(words)];
+        text += (gen() % 8) ? ' ' : '\n';
+    }
+
+    text.resize(size);
+    return text;
+}
+
+} // namespace {}
+
+
+TEST(cold_string, round_trip)
+{
+    std::vector<std::string> sources =
+    {
+        make_text(1024, 1), make_text(5000, 2), make_text(300000, 3),
+        std::string(100000, 'a'),        // a run: overlapping matches at offset 1
+        std::string(70000, '\0') + "x",   // and more than 64K of it
+    };
+
+    std::string pattern;
+    for (int i = 0; i < 20000; ++i)
+        pattern += std::to_string(i % 7) + "ab";
+
+    sources.push_back(pattern);         // short offsets
+
+    for (auto& source : sources)
+    {
+        cold_string cold{ immutable_string(source) };
+        ASSERT_TRUE(cold.compress()) << source.size();
+        EXPECT_TRUE(cold.is_compressed());
+        EXPECT_LT(cold.compressed_size(), source.size() / 2);
+        EXPECT_EQ(cold.size(), source.size());
+
+        auto const s = cold.get();
+        ASSERT_EQ(std::string_view(s.data(), s.size()), source);
+
+        // decompressed once, then shared
+        EXPECT_EQ(cold.get().data(), s.data());
+    }
+}
+
+TEST(cold_string, not_worth_it)
+{
+    // too short
+    cold_string small{ immutable_string("a short string") };
+    EXPECT_FALSE(small.compress());
+    EXPECT_FALSE(small.is_incompressible());
+    EXPECT_EQ(small.get(), "a short string");
+
+    // random bytes don't compress
+    std::mt19937 gen(5);
+    std::string noise(100000, ' ');
+    for (auto& c : noise)
+        c = char(gen());
+
+    immutable_string const str(noise);
+    cold_string cold{ str };
+    EXPECT_FALSE(cold.is_incompressible());
+    EXPECT_FALSE(cold.compress());
+    EXPECT_FALSE(cold.is_compressed());
+    EXPECT_TRUE(cold.is_incompressible());
+    EXPECT_EQ(cold.get().data(), str.data());
+
+    // later sweeps don't try again
+    EXPECT_FALSE(cold.compress_if_cold(std::chrono::seconds(0)));
+    EXPECT_FALSE(cold.is_compressed());
+
+    EXPECT_FALSE(cold_string().compress());
+    EXPECT_TRUE(cold_string().get().empty());
+}
+
+TEST(cold_string, cold_policy)
+{
+    auto const text = make_text(100000, 7);
+    cold_string cold{ immutable_string(text) };
+
+    // just created, i.e. just touched
+    EXPECT_FALSE(cold.compress_if_cold(std::chrono::hours(1)));
+    EXPECT_FALSE(cold.is_compressed());
+
+    auto const hot = cold.memory_usage();
+    EXPECT_TRUE(cold.compress_if_cold(std::chrono::seconds(0)));
+    EXPECT_TRUE(cold.is_compressed());
+    auto const compressed = cold.memory_usage();
+    EXPECT_LT(compressed * 2, hot);
+
+    EXPECT_EQ(cold.get(), immutable_string(text));
+    EXPECT_GT(cold.memory_usage(), hot);
+
+    // the decompressed copy goes once it's cold again
+    EXPECT_FALSE(cold.compress_if_cold(std::chrono::hours(1)));
+    EXPECT_TRUE(cold.compress_if_cold(std::chrono::seconds(0)));
+    EXPECT_EQ(cold.memory_usage(), compressed);
+}
+
+TEST(cold_string, move)
+{
+    auto const text = make_text(50000, 11);
+    std::vector<cold_string> cache;
+    for (int i = 0; i < 10; ++i)
+    {
+        cache.emplace_back(immutable_string(text));
+        if (i % 2)
+        {
+            ASSERT_TRUE(cache.back().compress());
+        }
+    }
+
+    // the vector moved the entries while growing
+    for (std::size_t i = 0; i < cache.size(); ++i)
+    {
+        EXPECT_EQ(cache[i].is_compressed(), i % 2 == 1);
+        EXPECT_EQ(cache[i].get(), immutable_string(text));
+    }
+
+    cold_string moved(std::move(cache[1]));
+    EXPECT_TRUE(moved.is_compressed());
+    EXPECT_TRUE(cache[1].empty());
+    EXPECT_FALSE(cache[1].is_compressed());
+    EXPECT_TRUE(cache[1].get().empty());
+
+    cache[0] = std::move(moved);
+    EXPECT_TRUE(cache[0].is_compressed());
+    EXPECT_EQ(cache[0].get(), immutable_string(text));
+    EXPECT_TRUE(moved.empty());
+    EXPECT_TRUE(moved.get().empty());
+}
+
+TEST(cold_string, wide)
+{
+    auto const text = make_text(20000, 9);
+    std::u32string const wide(text.begin(), text.end());
+    basic_cold_string<immutable_u32string> cold{ immutable_u32string(wide) };
+    ASSERT_TRUE(cold.compress());
+    EXPECT_EQ(cold.get(), immutable_u32string(wide));
+}
+
+TEST(cold_string, concurrent_readers)
+{
+    auto const text = make_text(200000, 11);
+    cold_string cold{ immutable_string(text) };
+    ASSERT_TRUE(cold.compress());
+
+    std::vector<immutable_string> results(4);
+    {
+        std::vector<std::jthread> readers;
+        for (std::size_t i = 0; i < results.size(); ++i)
+            readers.emplace_back([&cold, &results, i]() { results[i] = cold.get(); });
+    }
+
+    for (auto& r : results)
+        EXPECT_EQ(std::string_view(r.data(), r.size()), text);
+
+    // everybody gets the cached copy from now on
+    EXPECT_EQ(cold.get().data(), cold.get().data());
+}
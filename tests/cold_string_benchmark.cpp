@@ -0,0 +1,96 @@
+#include "common.h"
+#include "benchmark.h"
+
+#include <immutable_string/cold_string.hxx>
+
+#include <chrono>
+#include <memory>
+
+namespace
+{
+
+using cold_type = basic_cold_string<RString>;
+constexpr std::size_t EntrySize = 64 * 1024;
+
+// 'source' cut into 64K cache entries
+void run(const char* title, const RString& source, unsigned runs, bool silent)
+{
+    uint64_t compress_time = 0;
+    uint64_t cold_time = 0;
+    uint64_t hot_time = 0;
+    uint64_t plain_size = 0;
+    uint64_t compressed_size = 0;
+    uint64_t checksum = 0;
+    std::size_t count = 0;
+    for (unsigned r = 0; r < runs; r++)
+    {
+        std::vector<std::unique_ptr<cold_type>> entries;
+        for (std::size_t pos = 0; pos < source.size(); pos += EntrySize)
+        {
+            auto const len = std::min(EntrySize, source.size() - pos);
+            entries.push_back(std::make_unique<cold_type>(RString(source.data() + pos, len))); // a buffer of its own
+        }
+
+        count = entries.size();
+        plain_size = 0;
+        compressed_size = 0;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (auto& e : entries)
+            e->compress();
+
+        compress_time += elapsed_us(start);
+
+        for (auto& e : entries)
+        {
+            plain_size += e->size();
+            compressed_size += e->is_compressed() ? e->compressed_size() : e->size();
+        }
+
+        // the first read decompresses, the next ones get the cached copy
+        checksum = 0;
+        start = std::chrono::high_resolution_clock::now();
+        for (auto& e : entries)
+            checksum += e->get()[e->size() / 2];
+
+        cold_time += elapsed_us(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        for (auto& e : entries)
+            checksum += e->get()[e->size() / 2];
+
+        hot_time += elapsed_us(start);
+    }
+
+    if (!silent && count)
+    {
+        std::cout << title << " (" << count << " cache entries of " << EntrySize / 1024 << "K)...\n";
+        std::cout << "Compression ratio:           " << std::setw(12) << std::setprecision(3) << double(plain_size) / double(compressed_size) << " (" << plain_size << " -> " << compressed_size << " bytes)\n";
+        std::cout << "Compression (us per entry):  " << std::setw(12) << compress_time / runs / count << "\n";
+        std::cout << "First read (us per entry):   " << std::setw(12) << cold_time / runs / count << "\n";
+        std::cout << "Cached read (ns per entry):  " << std::setw(12) << hot_time * 1000 / runs / count << "\n";
+        std::cout << "Checksum:                    " << std::setw(12) << checksum << "\n";
+        std::cout << "--------------------------------------------------------------\n";
+    }
+}
+
+} // namespace {}
+
+
+void run_benchmark_cold_string(const RString& source, unsigned runs, bool silent)
+{
+    // random letters have nothing for LZ to find, so they are left as they are
+    run("Compressing the benchmark text", source, runs, silent);
+
+    // what caches usually hold: records with the same field names over and over
+    OStringStream records;
+    std::size_t id = 0;
+    for (std::size_t pos = 0; pos < source.size() && id < 500000; ++id)
+    {
+        auto const end = std::min(source.find(SEPARATOR, pos), source.size());
+        records << "{\"id\":" << id << ",\"name\":\"" << std::string_view(source.data() + pos, end - pos) << "\",\"kind\":\"user\",\"active\":" << ((id % 3) ? "true" : "false") << "}\n";
+        pos = end + 1;
+    }
+
+    run("Compressing JSON records made of the benchmark words", RString(records.str()), runs, silent);
+}
@@ -0,0 +1,113 @@
+#include "common.h"
+
+#include <immutable_string/compact_string.hxx>
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace ims;
+
+
+TEST(compact_string, layout)
+{
+    static_assert(sizeof(compact_string) == 16);
+    static_assert(sizeof(basic_compact_string<immutable_u32string>) == 16);
+
+    compact_string empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty.view(), "");
+
+    compact_string const inl("twelve chars");
+    EXPECT_EQ(inl.size(), 12u);
+    EXPECT_EQ(inl.view(), "twelve chars");
+    EXPECT_EQ(static_cast<const void*>(inl.data()), static_cast<const void*>(reinterpret_cast<const char*>(&inl) + 4));
+
+    compact_string const heap(std::string_view("thirteen char"));
+    EXPECT_EQ(heap.view(), "thirteen char");
+
+    basic_compact_string<immutable_u16string> const u16(std::u16string_view(u"wide string here"));
+    EXPECT_EQ(u16.view(), u"wide string here");
+    EXPECT_EQ(u16.str(), std::u16string_view(u"wide string here"));
+}
+
+TEST(compact_string, zero_copy_conversion)
+{
+    immutable_string const buffer(std::string(100000, 'x') + "the end");
+
+    // shares the buffer both ways
+    auto const head = buffer.substr(0, 50);
+    compact_string const c1(head);
+    EXPECT_EQ(c1.data(), head.data());
+    auto const back = c1.str();
+    EXPECT_EQ(back.data(), head.data());
+    EXPECT_EQ(back, head);
+
+    // null termination is preserved
+    compact_string const whole(buffer);
+    EXPECT_EQ(whole.str().c_str(), buffer.data());
+
+    // too far into the buffer to encode the offset
+    auto const tail = buffer.substr(buffer.size() - 20);
+    compact_string const c2(tail);
+    EXPECT_NE(c2.data(), tail.data());
+    EXPECT_EQ(c2.view(), tail);
+
+    // literals are borrowed
+    immutable_string const lit("a string literal", immutable_string::FromStringLiteral);
+    compact_string const c3(lit);
+    EXPECT_EQ(c3.data(), lit.data());
+    EXPECT_EQ(c3.str().data(), lit.data());
+
+    // SSO and inline ones get copied
+    immutable_string const sso("sso string of 20 chr");
+    compact_string const c4(sso);
+    EXPECT_EQ(c4.view(), sso);
+    EXPECT_EQ(compact_string(immutable_string("short")).str(), "short");
+
+    // the copies keep the buffer alive
+    compact_string c5;
+    {
+        immutable_string const temp(std::string(40, 't'));
+        c5 = compact_string(temp);
+    }
+
+    auto c6 = c5;
+    EXPECT_EQ(c6.view(), std::string(40, 't'));
+}
+
+TEST(compact_string, comparison)
+{
+    std::vector<std::string> strings = {
+        "", "a", "ab", std::string("ab\0", 3), "abc", "abcd", "abcde", "abcdefghijkl", "abcdefghijklm",
+        "abcdefghijklmn", "abcdefghijklmo", "abce", "b", "\xff", "\xff\xfe", "\x01\x02\x03\x04xxxxxxxxxxxxxx",
+        "long string sharing a prefix 1", "long string sharing a prefix 2", "long"
+    };
+
+    std::vector<compact_string> compact;
+    for (auto& s : strings)
+        compact.emplace_back(s);
+
+    for (std::size_t i = 0; i < strings.size(); ++i)
+    {
+        for (std::size_t j = 0; j < strings.size(); ++j)
+        {
+            EXPECT_EQ(compact[i] == compact[j], strings[i] == strings[j]) << i << " " << j;
+            EXPECT_EQ(compact[i] <=> compact[j], strings[i] <=> strings[j]) << i << " " << j;
+        }
+    }
+
+    // equal contents in different buffers
+    compact_string const a(std::string_view("same long contents here"));
+    compact_string const b(std::string_view("same long contents here"));
+    EXPECT_NE(a.data(), b.data());
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(std::hash<compact_string>()(a), std::hash<immutable_string>()(immutable_string("same long contents here")));
+
+    std::sort(compact.begin(), compact.end());
+    std::sort(strings.begin(), strings.end());
+    for (std::size_t i = 0; i < strings.size(); ++i)
+        EXPECT_EQ(compact[i].view(), strings[i]);
+}
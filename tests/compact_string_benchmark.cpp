@@ -0,0 +1,81 @@
+#include "common.h"
+#include "benchmark.h"
+
+#include <immutable_string/compact_string.hxx>
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+
+namespace
+{
+
+using RCompactString = basic_compact_string<RString>;
+
+template <class StringT>
+struct less
+{
+    bool operator()(const StringT& a, const StringT& b) const noexcept
+    {
+        if constexpr (std::is_same_v<StringT, RString>)
+            return std::string_view(a.data(), a.size()) < std::string_view(b.data(), b.size());
+        else
+            return a < b;
+    }
+};
+
+template <class StringT>
+void run(const char* title, const std::vector<std::string_view>& words, unsigned runs, bool silent)
+{
+    auto const live_before = allocator_base::_live_bytes;
+
+    std::vector<StringT> strings;
+    strings.reserve(words.size());
+    for (auto w : words)
+        strings.emplace_back(w);
+
+    auto const live = allocator_base::_live_bytes - live_before + strings.capacity() * sizeof(StringT);
+
+    uint64_t sort_time = 0;
+    uint64_t join_time = 0;
+    uint64_t matches = 0;
+    for (unsigned r = 0; r < runs; r++)
+    {
+        auto sorted = strings;
+        auto start = std::chrono::high_resolution_clock::now();
+        std::sort(sorted.begin(), sorted.end(), less<StringT>());
+        sort_time += elapsed_ms(start);
+
+        // build on the even words, probe with all of them
+        start = std::chrono::high_resolution_clock::now();
+        std::unordered_set<StringT> table;
+        table.reserve(strings.size() / 2);
+        for (std::size_t i = 0; i < strings.size(); i += 2)
+            table.insert(strings[i]);
+
+        matches = 0;
+        for (auto& s : strings)
+            matches += table.count(s);
+
+        join_time += elapsed_ms(start);
+    }
+
+    if (!silent)
+    {
+        std::cout << title << "\n";
+        std::cout << "Memory:              " << std::setw(12) << format_memsize(live) << "\n";
+        std::cout << "Sort time (ms):      " << std::setw(12) << sort_time / runs << "\n";
+        std::cout << "Join matches:        " << std::setw(12) << matches << "\n";
+        std::cout << "Join time (ms):      " << std::setw(12) << join_time / runs << "\n";
+        std::cout << "--------------------------------------------------------------\n";
+    }
+}
+
+} // namespace {}
+
+
+void run_benchmark_compact_string(const std::vector<std::string_view>& words, unsigned runs, bool silent)
+{
+    run<RString>("Sorting and joining ims::immutable_string...", words, runs, silent);
+    run<RCompactString>("Sorting and joining ims::compact_string...", words, runs, silent);
+}
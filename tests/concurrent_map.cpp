@@ -0,0 +1,115 @@
+#include "common.h"
+
+#include <immutable_string/concurrent_map.hxx>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ims;
+
+namespace
+{
+
+immutable_string make_key(int i)
+{
+    // long enough not to fit into SSO
+    return immutable_string(std::string("concurrent_string_map key #") + std::to_string(i));
+}
+
+} // namespace {}
+
+
+TEST(concurrent_string_map, insert_find)
+{
+    concurrent_string_map<int> map(4);
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find(immutable_string("missing")), nullptr);
+
+    // grows many times
+    for (int i = 0; i < 10000; ++i)
+    {
+        auto r = map.try_emplace(make_key(i), i);
+        ASSERT_TRUE(r.second);
+        ASSERT_EQ(*r.first, i);
+    }
+
+    EXPECT_EQ(map.size(), 10000);
+
+    for (int i = 0; i < 10000; ++i)
+    {
+        auto v = map.find(make_key(i));
+        ASSERT_NE(v, nullptr);
+        EXPECT_EQ(*v, i);
+    }
+
+    // existing value is left untouched
+    auto r = map.try_emplace(make_key(5), -1);
+    EXPECT_FALSE(r.second);
+    EXPECT_EQ(*r.first, 5);
+    EXPECT_EQ(map.size(), 10000);
+
+    // lookup by view
+    auto key = std::string("concurrent_string_map key #42");
+    auto v = map.find(std::string_view(key));
+    ASSERT_NE(v, nullptr);
+    EXPECT_EQ(*v, 42);
+    EXPECT_EQ(map.find(std::string_view("concurrent_string_map key #-1")), nullptr);
+
+    // short keys
+    map.try_emplace(immutable_string("a"), 1);
+    map.try_emplace(immutable_string(""), 2);
+    ASSERT_NE(map.find(immutable_string("a")), nullptr);
+    EXPECT_EQ(*map.find(immutable_string("a")), 1);
+    ASSERT_NE(map.find(immutable_string()), nullptr);
+    EXPECT_EQ(*map.find(immutable_string()), 2);
+
+    std::size_t visited = 0;
+    long long sum = 0;
+    map.for_each([&](const immutable_string&, int value) { ++visited; sum += value; });
+    EXPECT_EQ(visited, map.size());
+    EXPECT_EQ(sum, 10000LL * 9999 / 2 + 3);
+}
+
+TEST(concurrent_string_map, concurrent_counters)
+{
+    const int Threads = 4;
+    const int Keys = 5000;
+    const int Rounds = 3;
+
+    std::vector<immutable_string> keys;
+    for (int i = 0; i < Keys; ++i)
+        keys.push_back(make_key(i));
+
+    concurrent_string_map<std::atomic<int>> map;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < Threads; ++t)
+    {
+        workers.emplace_back([&map, &keys, t]()
+        {
+            for (int r = 0; r < Rounds; ++r)
+            {
+                for (int i = 0; i < Keys; ++i)
+                {
+                    auto& key = keys[(i + t * 997) % Keys];
+                    map.try_emplace(key).first->fetch_add(1);
+
+                    // lock-free lookups run alongside inserts and growth
+                    auto v = map.find(key);
+                    ASSERT_NE(v, nullptr);
+                }
+            }
+        });
+    }
+
+    for (auto& w : workers)
+        w.join();
+
+    EXPECT_EQ(map.size(), Keys);
+    for (int i = 0; i < Keys; ++i)
+    {
+        auto v = map.find(keys[i]);
+        ASSERT_NE(v, nullptr);
+        EXPECT_EQ(v->load(), Threads * Rounds);
+    }
+}
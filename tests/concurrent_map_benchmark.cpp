@@ -0,0 +1,118 @@
+#include "common.h"
+#include "benchmark.h"
+
+#include <immutable_string/concurrent_map.hxx>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace
+{
+
+template <class InsertF, class LookupF>
+void run_threads(const RStringVector& words, unsigned threads, InsertF inserter, LookupF lookup, uint64_t& time_insert, uint64_t& time_lookup)
+{
+    std::vector<std::thread> workers;
+
+    // every thread counts its share of words
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&words, &inserter, t, threads]()
+        {
+            for (std::size_t i = t; i < words.size(); i += threads)
+                inserter(words[i]);
+        });
+    }
+
+    for (auto& w : workers)
+        w.join();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    time_insert += std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    // every thread looks up all the words
+    workers.clear();
+    start = std::chrono::high_resolution_clock::now();
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&words, &lookup, t]()
+        {
+            uint64_t found = 0;
+            for (std::size_t i = 0; i < words.size(); ++i)
+                found += lookup(words[(i + t * 7919) % words.size()]);
+
+            if (found != words.size())
+                std::cout << "ERROR: lost words\n";
+        });
+    }
+
+    for (auto& w : workers)
+        w.join();
+
+    end = std::chrono::high_resolution_clock::now();
+    time_lookup += std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+}
+
+void print_results(unsigned threads, uint64_t time_insert, uint64_t time_lookup, unsigned runs)
+{
+    std::cout << "Threads: " << std::setw(3) << threads << "  Insert (ms): " << std::setw(8) << time_insert / runs << "  Lookup (ms): " << std::setw(8) << time_lookup / runs << "\n";
+}
+
+} // namespace {}
+
+
+void run_benchmark_concurrent_map(const RStringVector& words, unsigned runs, bool silent)
+{
+    auto const max_threads = std::max(4u, std::thread::hardware_concurrency());
+
+    if (!silent)
+        std::cout << "Counting words with ims::concurrent_string_map...\n";
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+    {
+        uint64_t time_insert = 0;
+        uint64_t time_lookup = 0;
+        for (unsigned r = 0; r < runs; r++)
+        {
+            concurrent_string_map<std::atomic<uint64_t>, RString> map;
+            run_threads(words, threads,
+                [&map](const RString& w) { map.try_emplace(w).first->fetch_add(1, std::memory_order_relaxed); },
+                [&map](const RString& w) { return map.find(w) ? 1 : 0; },
+                time_insert, time_lookup);
+        }
+
+        if (!silent)
+            print_results(threads, time_insert, time_lookup, runs);
+    }
+
+    if (!silent)
+    {
+        std::cout << "--------------------------------------------------------------\n";
+        std::cout << "Counting words with std::unordered_map under std::mutex...\n";
+    }
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+    {
+        uint64_t time_insert = 0;
+        uint64_t time_lookup = 0;
+        for (unsigned r = 0; r < runs; r++)
+        {
+            std::unordered_map<RString, uint64_t> map;
+            std::mutex mutex;
+            run_threads(words, threads,
+                [&map, &mutex](const RString& w) { std::lock_guard l(mutex); ++map[w]; },
+                [&map, &mutex](const RString& w) { std::lock_guard l(mutex); return map.find(w) != map.end() ? 1 : 0; },
+                time_insert, time_lookup);
+        }
+
+        if (!silent)
+            print_results(threads, time_insert, time_lookup, runs);
+    }
+
+    if (!silent)
+        std::cout << "--------------------------------------------------------------\n";
+}
@@ -0,0 +1,112 @@
+#include "common.h"
+
+#include <immutable_string/deduplicate.hxx>
+
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace ims;
+
+namespace
+{
+
+std::string value(int i)
+{
+    return "a value long enough to need a buffer #" + std::to_string(i);
+}
+
+} // namespace {}
+
+
+TEST(deduplicate, duplicates)
+{
+    std::vector<immutable_string> strings;
+    for (int copy = 0; copy < 10; ++copy)
+    {
+        for (int i = 0; i < 10; ++i)
+            strings.emplace_back(value(i));
+    }
+
+    strings.emplace_back("short");
+    strings.emplace_back("short");
+
+    auto const keep = strings[0]; // referenced from outside
+    auto const report = deduplicate(strings);
+    EXPECT_EQ(report.strings, 102u);
+    EXPECT_EQ(report.duplicates, 90u); // SSO strings are left alone
+    EXPECT_EQ(report.buffers_released, 89u);
+    EXPECT_GE(report.bytes_released, 89 * value(0).size());
+    EXPECT_EQ(report.detached, 0u);
+    EXPECT_EQ(report.bytes_allocated, 0u);
+
+    for (std::size_t i = 0; i < 100; ++i)
+    {
+        EXPECT_EQ(strings[i], value(int(i % 10)));
+        EXPECT_EQ(strings[i].data(), strings[i % 10].data());
+    }
+
+    // the buffer referenced from outside is the one to keep
+    EXPECT_EQ(keep, strings[0]);
+
+    // nothing left to do
+    auto const again = deduplicate(strings);
+    EXPECT_EQ(again.duplicates, 0u);
+    EXPECT_EQ(again.buffers_released, 0u);
+}
+
+TEST(deduplicate, detach)
+{
+    std::list<immutable_string> strings;
+    {
+        immutable_string const chunk(std::string(1024 * 1024, 'c') + value(1) + value(2));
+        strings.push_back(chunk.substr(1024 * 1024, value(1).size()));
+        strings.push_back(chunk.substr(1024 * 1024 + value(1).size()));
+        strings.push_back(immutable_string(value(2))); // the smaller buffer wins
+    }
+
+    deduplicate_options options;
+    options.min_buffer_usage = 0.5;
+    options.threads = 2;
+
+    auto const report = deduplicate(strings, options);
+    EXPECT_EQ(report.detached, 1u);
+    EXPECT_EQ(report.duplicates, 1u);
+    EXPECT_EQ(report.buffers_released, 1u);
+    EXPECT_GE(report.bytes_released, 1024u * 1024u);
+    EXPECT_GE(report.bytes_allocated, value(1).size());
+
+    auto it = strings.begin();
+    EXPECT_EQ(*it, value(1));
+    EXPECT_EQ(*++it, value(2));
+    EXPECT_EQ(it->data(), std::next(it)->data());
+}
+
+TEST(deduplicate, detach_once)
+{
+    std::vector<immutable_string> strings;
+    {
+        immutable_string const chunk(std::string(64 * 1024, 'c') + value(1));
+        strings.push_back(chunk.substr(64 * 1024));
+    }
+
+    // exact-size buffers, only the header and the rounding are spare
+    for (int i = 2; i < 10; ++i)
+        strings.emplace_back(value(i));
+
+    deduplicate_options options;
+    options.min_buffer_usage = 0.9;
+
+    auto const report = deduplicate(strings, options);
+    EXPECT_EQ(report.detached, 1u);
+    EXPECT_EQ(report.buffers_released, 1u);
+
+    // the second run finds every string in a buffer of its own size
+    auto const again = deduplicate(strings, options);
+    EXPECT_EQ(again.detached, 0u);
+    EXPECT_EQ(again.bytes_allocated, 0u);
+    EXPECT_EQ(again.bytes_released, 0u);
+
+    for (int i = 1; i < 10; ++i)
+        EXPECT_EQ(strings[i - 1], value(i));
+}
@@ -0,0 +1,197 @@
+#include "common.h"
+
+#include <immutable_string/escape.hxx>
+
+#include <string>
+#include <string_view>
+
+using namespace ims;
+
+namespace
+{
+
+const char LongClean[] = "a string long enough not to fit into SSO, with nothing to escape in it";
+
+// the straightforward way, to check the vectorized scanning against
+std::string reference_json_escape(std::string_view s)
+{
+    std::string r;
+    for (char c : s)
+    {
+        switch (c)
+        {
+        case '"': r += "\\\""; break;
+        case '\\': r += "\\\\"; break;
+        case '\b': r += "\\b"; break;
+        case '\f': r += "\\f"; break;
+        case '\n': r += "\\n"; break;
+        case '\r': r += "\\r"; break;
+        case '\t': r += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04X", unsigned(c));
+                r += buf;
+            }
+            else
+            {
+                r += c;
+            }
+        }
+    }
+
+    return r;
+}
+
+} // namespace {}
+
+
+TEST(escape, json)
+{
+    immutable_string const clean(LongClean);
+    auto const same = json_escape(clean);
+    EXPECT_EQ(same.data(), clean.data());
+    EXPECT_EQ(json_unescape(clean).data(), clean.data());
+
+    // non-ASCII is kept as it is
+    immutable_string const utf8("\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82, \xe4\xb8\x96\xe7\x95\x8c \xf0\x9f\x98\x80");
+    EXPECT_EQ(json_escape(utf8).data(), utf8.data());
+
+    immutable_string const dirty("say \"hi\"\n\tpath\\to\x01\x1f end");
+    auto const escaped = json_escape(dirty);
+    EXPECT_EQ(escaped, "say \\\"hi\\\"\\n\\tpath\\\\to\\u0001\\u001F end");
+    EXPECT_EQ(json_unescape(escaped), dirty);
+
+    EXPECT_EQ(json_unescape(immutable_string("\\/\\b\\f\\r")), "/\b\f\r");
+    EXPECT_EQ(json_unescape(immutable_string("\\u0041\\u00e9\\u4e16\\uD83D\\uDE00")), "A\xc3\xa9\xe4\xb8\x96\xf0\x9f\x98\x80");
+
+    EXPECT_THROW((void)json_unescape(immutable_string("trailing \\")), std::invalid_argument);
+    EXPECT_THROW((void)json_unescape(immutable_string("\\x41")), std::invalid_argument);
+    EXPECT_THROW((void)json_unescape(immutable_string("\\u00G1")), std::invalid_argument);
+    EXPECT_THROW((void)json_unescape(immutable_string("\\u004")), std::invalid_argument);
+    EXPECT_THROW((void)json_unescape(immutable_string("\\uD83D")), std::invalid_argument);
+    EXPECT_THROW((void)json_unescape(immutable_string("\\uD83D\\u0041")), std::invalid_argument);
+    EXPECT_THROW((void)json_unescape(immutable_string("\\uDE00")), std::invalid_argument);
+}
+
+TEST(escape, json_every_position)
+{
+    // special characters before, at and after 16-character boundaries
+    for (std::size_t size : { 1, 15, 16, 17, 31, 32, 33, 70 })
+    {
+        for (std::size_t pos = 0; pos < size; ++pos)
+        {
+            for (char special : { '"', '\\', '\n', '\x7f', '\x1f', '\x80' })
+            {
+                std::string s(size, 'x');
+                s[pos] = special;
+                s[size - 1 - pos / 2] = special;
+
+                immutable_string const str(s);
+                auto const escaped = json_escape(str);
+                EXPECT_EQ(std::string_view(escaped.data(), escaped.size()), reference_json_escape(s)) << size << " " << pos;
+                EXPECT_EQ(json_unescape(escaped), str);
+            }
+        }
+    }
+}
+
+TEST(escape, wide)
+{
+    immutable_wstring const dirty(L"\x4e16 \"\x754c\"\n");
+    auto const escaped = json_escape(dirty);
+    EXPECT_EQ(escaped, L"\x4e16 \\\"\x754c\\\"\\n");
+    EXPECT_EQ(json_unescape(escaped), dirty);
+
+    // a surrogate pair is one code point, however it's encoded
+    auto const smile = json_unescape(immutable_wstring(L"\\uD83D\\uDE00"));
+    EXPECT_EQ(smile.size(), sizeof(wchar_t) == 2 ? 2u : 1u);
+    EXPECT_EQ(json_unescape(immutable_u32string(U"\\uD83D\\uDE00")), U"\U0001F600");
+
+    immutable_wstring const field(L"a,b");
+    EXPECT_EQ(csv_escape(field), L"\"a,b\"");
+    EXPECT_EQ(csv_unescape(csv_escape(field)), field);
+}
+
+TEST(escape, csv)
+{
+    immutable_string const clean(LongClean);
+    EXPECT_EQ(csv_escape(clean, ';').data(), clean.data());
+    EXPECT_EQ(csv_unescape(clean).data(), clean.data());
+
+    EXPECT_EQ(csv_escape(immutable_string("a,b")), "\"a,b\"");
+    EXPECT_EQ(csv_escape(immutable_string("a,b"), ';'), "a,b");
+    EXPECT_EQ(csv_escape(immutable_string("a;b"), ';'), "\"a;b\"");
+    EXPECT_EQ(csv_escape(immutable_string("line\nbreak")), "\"line\nbreak\"");
+    EXPECT_EQ(csv_escape(immutable_string("cr\r")), "\"cr\r\"");
+    EXPECT_EQ(csv_escape(immutable_string("say \"hi\"")), "\"say \"\"hi\"\"\"");
+    EXPECT_EQ(csv_escape(immutable_string("\"")), "\"\"\"\"");
+
+    EXPECT_EQ(csv_unescape(immutable_string("\"say \"\"hi\"\"\"")), "say \"hi\"");
+    EXPECT_EQ(csv_unescape(immutable_string("\"\"\"\"")), "\"");
+    EXPECT_EQ(csv_unescape(immutable_string("\"\"")), "");
+    EXPECT_EQ(csv_unescape(immutable_string("\"")), "\"");
+
+    // a quoted field with no quotes inside is a substring
+    immutable_string const quoted("\"a long quoted field, with a comma that made it quoted\"");
+    auto const unquoted = csv_unescape(quoted);
+    EXPECT_EQ(unquoted, "a long quoted field, with a comma that made it quoted");
+    EXPECT_EQ(unquoted.data(), quoted.data() + 1);
+
+    EXPECT_THROW((void)csv_unescape(immutable_string("\"lone \" quote\"")), std::invalid_argument);
+    EXPECT_THROW((void)csv_unescape(immutable_string("\"lone quote at the end\"\"")), std::invalid_argument);
+}
+
+TEST(escape, url)
+{
+    immutable_string const clean("unreserved-characters_only.in~this~string.0123456789");
+    EXPECT_EQ(url_escape(clean).data(), clean.data());
+    EXPECT_EQ(url_unescape(clean).data(), clean.data());
+
+    EXPECT_EQ(url_escape(immutable_string("a b&c=d/e?f")), "a%20b%26c%3Dd%2Fe%3Ff");
+    EXPECT_EQ(url_escape(immutable_string("\xc3\xa9t\xc3\xa9")), "%C3%A9t%C3%A9");
+    EXPECT_EQ(url_escape(immutable_string("@[`{/:")), "%40%5B%60%7B%2F%3A");
+
+    EXPECT_EQ(url_unescape(immutable_string("a%20b%26c%3dd+e")), "a b&c=d+e");
+    EXPECT_EQ(url_unescape(immutable_string("%C3%A9t%C3%A9")), "\xc3\xa9t\xc3\xa9");
+    EXPECT_EQ(url_unescape(immutable_string("%00")), immutable_string(std::string_view("\0", 1)));
+
+    EXPECT_THROW((void)url_unescape(immutable_string("100%")), std::invalid_argument);
+    EXPECT_THROW((void)url_unescape(immutable_string("%4")), std::invalid_argument);
+    EXPECT_THROW((void)url_unescape(immutable_string("%4g")), std::invalid_argument);
+
+    // every byte survives the round trip
+    std::string all;
+    for (int c = 0; c < 256; ++c)
+        all += char(c);
+
+    immutable_string const bytes(all);
+    auto const escaped = url_escape(bytes);
+    EXPECT_EQ(escaped.size(), 66 + 190 * 3);
+    EXPECT_EQ(url_unescape(escaped), bytes);
+}
+
+TEST(escape, builder)
+{
+    immutable_string::builder b;
+    b.append("{\"name\":\"");
+    json_escape_to(b, std::string_view("O'Neil \"Jr\""));
+    b.append("\",\"path\":\"");
+    json_escape_to(b, immutable_string("C:\\temp"));
+    b.append("\"}");
+    EXPECT_EQ(b.str(), "{\"name\":\"O'Neil \\\"Jr\\\"\",\"path\":\"C:\\\\temp\"}");
+
+    immutable_string::builder row;
+    csv_escape_to(row, std::string_view("plain"));
+    row.append(',');
+    csv_escape_to(row, std::string_view("with,comma"));
+    row.append(',');
+    csv_escape_to(row, std::string_view("with \"quotes\""));
+    EXPECT_EQ(row.str(), "plain,\"with,comma\",\"with \"\"quotes\"\"\"");
+
+    immutable_string::builder url;
+    url.append("/search?q=");
+    url_escape_to(url, std::string_view("immutable strings & more"));
+    EXPECT_EQ(url.str(), "/search?q=immutable%20strings%20%26%20more");
+}
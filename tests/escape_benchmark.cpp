@@ -0,0 +1,95 @@
+#include "common.h"
+#include "benchmark.h"
+
+#include <immutable_string/escape.hxx>
+
+#include <chrono>
+
+namespace
+{
+
+// a copy every time, the usual way
+StdString std_string_json_escape(std::string_view s)
+{
+    StdString r;
+    r.reserve(s.size());
+    for (char c : s)
+    {
+        switch (c)
+        {
+        case '"': r += "\\\""; break;
+        case '\\': r += "\\\\"; break;
+        case '\n': r += "\\n"; break;
+        default: r += c;
+        }
+    }
+
+    return r;
+}
+
+template <class RunT>
+void run(const char* title, RunT escape_all, std::size_t count, unsigned runs, bool silent)
+{
+    uint64_t time = 0;
+    uint64_t allocations = 0;
+    uint64_t total = 0;
+    for (unsigned r = 0; r < runs; r++)
+    {
+        auto const allocs0 = allocator_base::_allocations;
+        auto start = std::chrono::high_resolution_clock::now();
+        total = escape_all();
+        auto end = std::chrono::high_resolution_clock::now();
+        time += std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        allocations += allocator_base::_allocations - allocs0;
+    }
+
+    if (!silent)
+    {
+        std::cout << title << "\n";
+        std::cout << "Escape time (ms):    " << std::setw(12) << time / runs << "\n";
+        std::cout << "Allocations:         " << std::setw(12) << allocations / runs << " (" << count << " strings)\n";
+        std::cout << "Escaped size:        " << std::setw(12) << total << "\n";
+        std::cout << "--------------------------------------------------------------\n";
+    }
+}
+
+} // namespace {}
+
+
+void run_benchmark_escape(const std::vector<std::string_view>& words, unsigned runs, bool silent)
+{
+    // one string in 20 needs escaping
+    RStringVector strings;
+    strings.reserve(words.size());
+    for (std::size_t i = 0; i < words.size(); ++i)
+    {
+        auto const w = words[i];
+        if (i % 20)
+        {
+            strings.emplace_back(w.data(), w.size());
+        }
+        else
+        {
+            auto const quoted = "\"" + std::string(w) + "\"";
+            strings.emplace_back(quoted.data(), quoted.size());
+        }
+    }
+
+    run("JSON-escaping words into std::strings...", [&strings]()
+    {
+        uint64_t total = 0;
+        for (auto& s : strings)
+            total += std_string_json_escape(std::string_view(s.data(), s.size())).size();
+
+        return total;
+    }, strings.size(), runs, silent);
+
+    run("JSON-escaping immutable_strings...", [&strings]()
+    {
+        uint64_t total = 0;
+        for (auto& s : strings)
+            total += json_escape(s).size();
+
+        return total;
+    }, strings.size(), runs, silent);
+}
@@ -0,0 +1,129 @@
+#include "common.h"
+
+#include <immutable_string/line_index.hxx>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace ims;
+
+namespace
+{
+
+// what std::getline() would return
+std::vector<std::string_view> reference_lines(std::string_view source, char delimiter = '\n')
+{
+    std::vector<std::string_view> result;
+    std::size_t start = 0;
+    while (start < source.size())
+    {
+        auto end = std::min(source.find(delimiter, start), source.size());
+        result.push_back(source.substr(start, end - start));
+        start = end + 1;
+    }
+
+    return result;
+}
+
+template <class IndexT>
+void check_lines(const IndexT& index, std::string_view source)
+{
+    auto const expected = reference_lines(source, index.delimiter());
+    ASSERT_EQ(index.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i)
+    {
+        ASSERT_EQ(index.view(i), expected[i]) << i;
+        EXPECT_EQ(index.offset(i), std::size_t(expected[i].data() - source.data())) << i;
+    }
+}
+
+} // namespace {}
+
+
+TEST(line_index, lines)
+{
+    immutable_string const log("first line\n\nthird line, long enough not to fit into SSO\nlast");
+    line_index const index(log);
+    ASSERT_EQ(index.size(), 4u);
+    EXPECT_EQ(index[0], "first line");
+    EXPECT_TRUE(index[1].empty());
+    EXPECT_EQ(index[2], "third line, long enough not to fit into SSO");
+    EXPECT_EQ(index[2].data(), log.data() + 12); // shares the buffer
+    EXPECT_EQ(index.at(3), "last");
+    EXPECT_EQ(index.offset(3), log.size() - 4);
+    EXPECT_THROW((void)index.at(4), std::out_of_range);
+
+    // a trailing delimiter doesn't start another line
+    EXPECT_EQ(line_index(immutable_string("a\nb\n")).size(), 2u);
+    EXPECT_EQ(line_index(immutable_string("\n")).size(), 1u);
+    EXPECT_EQ(line_index(immutable_string()).size(), 0u);
+    EXPECT_TRUE(line_index().empty());
+
+    // any delimiter, any character type
+    basic_line_index<immutable_u16string> const records(immutable_u16string(u"a;bb;\x4e16;"), u';');
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[2], u"\x4e16");
+
+    // delimiters at every position within and across vectors, lines of any length
+    std::string source;
+    for (int i = 0; source.size() < 10000; ++i)
+    {
+        source.append(std::size_t(i * 7 % 37), char('a' + i % 26));
+        source.push_back('\n');
+    }
+
+    check_lines(line_index(immutable_string(source)), source);
+    check_lines(line_index(immutable_string(source), 'a'), source);
+}
+
+TEST(line_index, parallel)
+{
+    std::string source;
+    for (int i = 0; source.size() < 1024 * 1024; ++i)
+    {
+        source.append(std::size_t(i % 23), char('a' + i % 26));
+        source.push_back('\n');
+    }
+
+    source.append(200 * 1024, 'z');
+    source.append("\n\nlast");
+
+    immutable_string const str(source);
+    line_index const index(str, '\n', 4);
+    check_lines(index, source);
+    EXPECT_LT(index.memory_usage(), index.size() * 5);
+
+    basic_line_index<immutable_u32string> const wide(immutable_u32string(std::u32string(source.begin(), source.end())), U'\n', 4);
+    EXPECT_EQ(wide.size(), index.size());
+    EXPECT_EQ(wide.view(wide.size() - 1), U"last");
+}
+
+TEST(line_index, growing)
+{
+    std::string source;
+    line_index index;
+    for (int i = 0; i < 1000; ++i)
+    {
+        // lines complete only in the next piece now and then
+        auto piece = "record " + std::to_string(i) + ((i % 3) ? "\n" : "; ");
+        source += piece;
+        index.append(std::string_view(piece));
+        ASSERT_EQ(index.source().size(), source.size());
+    }
+
+    check_lines(index, source);
+
+    // the same from outside: the index scans only what has been added
+    immutable_string log("a line\nan unfinished line");
+    line_index grown(log);
+    ASSERT_EQ(grown.size(), 2u);
+    log = std::move(log).with_appended(std::string_view(", now finished\nnext\n"));
+    grown.extend(log);
+    ASSERT_EQ(grown.size(), 3u);
+    EXPECT_EQ(grown[1], "an unfinished line, now finished");
+    EXPECT_EQ(grown[2], "next");
+
+    EXPECT_THROW(grown.extend(immutable_string("short")), std::invalid_argument);
+    EXPECT_EQ(grown.size(), 3u);
+}
@@ -0,0 +1,89 @@
+#include "common.h"
+#include "benchmark.h"
+
+#include <immutable_string/line_index.hxx>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+
+namespace
+{
+
+template <class RunF>
+uint64_t measure(RunF run, unsigned runs, uint64_t& result)
+{
+    uint64_t time = 0;
+    for (unsigned r = 0; r < runs; r++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        result = run();
+        auto end = std::chrono::high_resolution_clock::now();
+        time += std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    }
+
+    return time / runs;
+}
+
+} // namespace {}
+
+
+void run_benchmark_line_index(const RString& source, unsigned runs, bool silent)
+{
+    using index_type = basic_line_index<RString>;
+
+    auto const max_threads = std::max(4u, std::thread::hardware_concurrency());
+    index_type const probe(source, SEPARATOR);
+
+    // random lines, the way a log viewer asks for them
+    std::mt19937 gen(1);
+    std::vector<std::size_t> queries(200);
+    for (auto& q : queries)
+        q = gen() % probe.size();
+
+    uint64_t result = 0;
+    auto time = measure([&source, &queries]()
+    {
+        uint64_t total = 0;
+        for (auto q : queries)
+        {
+            // rescan from the start every time
+            std::size_t start = 0;
+            for (std::size_t line = 0; line < q; ++line)
+                start = source.find(SEPARATOR, start) + 1;
+
+            total += source.substr(start, source.find(SEPARATOR, start) - start).size();
+        }
+
+        return total;
+    }, runs, result);
+
+    if (!silent)
+    {
+        std::cout << "Fetching " << queries.size() << " random lines with find() from the start...\n";
+        std::cout << "Characters: " << std::setw(10) << result << "\n";
+        std::cout << "Time (ms):  " << std::setw(10) << time << "\n";
+        std::cout << "--------------------------------------------------------------\n";
+        std::cout << "Building ims::line_index (" << probe.size() << " lines, " << probe.memory_usage() << " bytes), then fetching the same lines...\n";
+    }
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+    {
+        time = measure([&source, &queries, threads]()
+        {
+            index_type const index(source, SEPARATOR, threads);
+            uint64_t total = 0;
+            for (auto q : queries)
+                total += index[q].size();
+
+            return total;
+        }, runs, result);
+
+        if (!silent)
+            std::cout << "Threads: " << std::setw(3) << threads << "  Characters: " << std::setw(10) << result << "  Time (ms): " << std::setw(8) << time << "\n";
+    }
+
+    if (!silent)
+        std::cout << "--------------------------------------------------------------\n";
+}
@@ -0,0 +1,212 @@
+#include "common.h"
+
+#include <immutable_string/numeric.hxx>
+
+#include <charconv>
+#include <cstring>
+#include <random>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace ims;
+
+namespace
+{
+
+template <class T>
+std::errc reference(std::string_view s, T& v)
+{
+    // the whole token must be a number
+    auto const r = std::from_chars(s.data(), s.data() + s.size(), v);
+    if (r.ptr != s.data() + s.size())
+        return std::errc::invalid_argument;
+
+    return r.ec;
+}
+
+// same results as a from_chars loop, errors included
+template <class T>
+void check_like_from_chars(const std::vector<std::string>& tokens)
+{
+    std::vector<T> values(tokens.size());
+    std::vector<std::errc> errors(tokens.size());
+    std::size_t failures;
+    if constexpr (std::is_floating_point_v<T>)
+        failures = parse_floats<T>(tokens, values, errors);
+    else
+        failures = parse_integers<T>(tokens, values, errors);
+
+    std::size_t expected_failures = 0;
+    for (std::size_t i = 0; i < tokens.size(); ++i)
+    {
+        T v{};
+        auto const e = reference(tokens[i], v);
+        EXPECT_EQ(int(errors[i]), int(e)) << tokens[i];
+        if (e == std::errc())
+        {
+            if constexpr (std::is_floating_point_v<T>)
+                EXPECT_EQ(std::memcmp(&values[i], &v, sizeof(T)), 0) << tokens[i] << " " << values[i] << " " << v;
+            else
+                EXPECT_EQ(values[i], v) << tokens[i];
+        }
+        else
+        {
+            ++expected_failures;
+            EXPECT_EQ(values[i], T{}) << tokens[i];
+        }
+    }
+
+    EXPECT_EQ(failures, expected_failures);
+}
+
+template <class T>
+concept can_parse_integers = requires(const std::vector<std::string_view>& tokens, std::span<T> values)
+{
+    parse_integers<T>(tokens, values);
+};
+
+} // namespace {}
+
+
+TEST(numeric, integers)
+{
+    std::vector<std::string> const tokens =
+    {
+        "0", "7", "-7", "12345678", "123456789", "-2147483648", "2147483647", "2147483648", "-2147483649",
+        "9223372036854775807", "-9223372036854775808", "9223372036854775808", "-9223372036854775809",
+        "18446744073709551615", "18446744073709551616", "99999999999999999999", "123456789012345678901234567890",
+        "0000000000000000000000000042", "-0", "00", "",
+        "-", "+1", " 1", "1 ", "12a", "1.0", "0x10", "--1", "1-", "123456789012345678901234567890x", "1e309x", "\xb1", ":", "/"
+    };
+
+    check_like_from_chars<int>(tokens);
+    check_like_from_chars<unsigned>(tokens);
+    check_like_from_chars<std::int64_t>(tokens);
+    check_like_from_chars<std::uint64_t>(tokens);
+    check_like_from_chars<std::int16_t>(tokens);
+    check_like_from_chars<std::uint8_t>(tokens);
+
+    std::mt19937_64 gen(42);
+    std::vector<std::string> random;
+    for (int i = 0; i < 10000; ++i)
+    {
+        auto const v = std::int64_t(gen()) >> (gen() % 64);
+        random.push_back(std::to_string(v));
+    }
+
+    check_like_from_chars<std::int64_t>(random);
+    check_like_from_chars<int>(random);
+}
+
+TEST(numeric, tokens)
+{
+    // any range of string-like tokens, with or without error reporting
+    immutable_string const line("10,-20,x,30");
+    std::vector<immutable_string> tokens;
+    line.split(',', std::back_inserter(tokens));
+
+    int values[4];
+    EXPECT_EQ(parse_integers<int>(tokens, values), 1u);
+    EXPECT_EQ(values[0], 10);
+    EXPECT_EQ(values[1], -20);
+    EXPECT_EQ(values[2], 0);
+    EXPECT_EQ(values[3], 30);
+
+    int short_values[3];
+    EXPECT_THROW(parse_integers<int>(tokens, short_values), std::length_error);
+
+    std::errc errors[2];
+    EXPECT_THROW(parse_integers<int>(tokens, values, errors), std::length_error);
+
+    std::vector<std::string_view> const views = { "1", "2" };
+    std::uint16_t small[2];
+    EXPECT_EQ(parse_integers<std::uint16_t>(views, small, errors), 0u);
+    EXPECT_EQ(small[1], 2);
+
+    // views yielding temporaries, and views that can't be iterated as const
+    std::vector<std::string> const owned = { "7", "bad", "-8" };
+    auto transformed = owned | std::views::transform([](const std::string& t) { return std::string_view(t); });
+    EXPECT_EQ(parse_integers<int>(transformed, values), 1u);
+    EXPECT_EQ(values[2], -8);
+
+    auto filtered = views | std::views::filter([](std::string_view t) { return t != "1"; });
+    std::int64_t decimals[1];
+    EXPECT_EQ(parse_decimals(filtered, 1, decimals), 0u);
+    EXPECT_EQ(decimals[0], 20);
+
+    static_assert(can_parse_integers<std::int8_t>);
+    static_assert(!can_parse_integers<bool>);
+    static_assert(!can_parse_integers<char>);
+    static_assert(!can_parse_integers<char16_t>);
+}
+
+TEST(numeric, decimals)
+{
+    std::vector<std::string_view> const tokens =
+    {
+        "12.34", "-12.34", "12", "12.", ".5", "-.5", "0.001", "1.239", "-0.0", "00012.3400",
+        "92233720368547758.07", "-92233720368547758.08", "92233720368547758.08", "1e5", "1.2.3", "", ".", "-", "1.23x", "+1.0"
+    };
+
+    std::vector<std::int64_t> values(tokens.size());
+    std::vector<std::errc> errors(tokens.size());
+    EXPECT_EQ(parse_decimals(tokens, 2, values, errors), 8u);
+
+    std::int64_t const expected[] = { 1234, -1234, 1200, 1200, 50, -50, 0, 123, 0, 1234, std::numeric_limits<std::int64_t>::max(), std::numeric_limits<std::int64_t>::min() };
+    for (std::size_t i = 0; i < std::size(expected); ++i)
+    {
+        EXPECT_EQ(int(errors[i]), 0) << tokens[i];
+        EXPECT_EQ(values[i], expected[i]) << tokens[i];
+    }
+
+    EXPECT_EQ(errors[12], std::errc::result_out_of_range);
+    for (std::size_t i = 13; i < tokens.size(); ++i)
+        EXPECT_EQ(errors[i], std::errc::invalid_argument) << tokens[i];
+
+    std::vector<std::string_view> const scaled = { "1", "0.000001", "-3.1415926535" };
+    std::int64_t micros[3];
+    EXPECT_EQ(parse_decimals(scaled, 6, micros), 0u);
+    EXPECT_EQ(micros[0], 1000000);
+    EXPECT_EQ(micros[1], 1);
+    EXPECT_EQ(micros[2], -3141592);
+
+    EXPECT_THROW(parse_decimals(scaled, 19, micros), std::invalid_argument);
+}
+
+TEST(numeric, floats)
+{
+    std::vector<std::string> const tokens =
+    {
+        "0", "-0", "1", "-1", "0.1", "1.5", "-2.25", "3.14159", "1e10", "1E-5", "1.5e+3", "123456789.123456789",
+        "9007199254740993", "9007199254740992", "1e22", "1e23", "1e-22", "1e-23", "4.9e-324", "1.7976931348623157e308",
+        "1e309", "1e-400", "0.000000000000000000000000000001", "12345678901234567890.5", "inf", "-inf", "nan",
+        "", "-", ".", "e5", "1e", "1e+", "+1", "1.2.3", "1,5", " 1", "0x1p3", "1e5x"
+    };
+
+    check_like_from_chars<double>(tokens);
+    check_like_from_chars<float>(tokens);
+
+    std::mt19937_64 gen(7);
+    std::vector<std::string> random;
+    for (int i = 0; i < 10000; ++i)
+    {
+        auto const mantissa = gen() % 100000000;
+        auto const decimals = int(gen() % 9);
+        auto s = std::to_string(mantissa);
+        if (decimals && std::size_t(decimals) < s.size())
+            s.insert(s.size() - decimals, ".");
+
+        if (gen() & 1)
+            s = "-" + s;
+
+        if (gen() % 4 == 0)
+            s += "e" + std::to_string(int(gen() % 40) - 20);
+
+        random.push_back(s);
+    }
+
+    check_like_from_chars<double>(random);
+    check_like_from_chars<float>(random);
+}
@@ -0,0 +1,93 @@
+#include "common.h"
+#include "benchmark.h"
+
+#include <immutable_string/numeric.hxx>
+
+#include <charconv>
+#include <chrono>
+#include <random>
+
+namespace
+{
+
+template <class T>
+void run(const char* title, const RStringVector& tokens, unsigned runs, bool silent)
+{
+    std::vector<T> values(tokens.size());
+    std::vector<std::errc> errors(tokens.size());
+
+    uint64_t loop_time = 0;
+    uint64_t batch_time = 0;
+    double loop_sum = 0;
+    double batch_sum = 0;
+    for (unsigned r = 0; r < runs; r++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (std::size_t i = 0; i < tokens.size(); ++i)
+        {
+            auto const& t = tokens[i];
+            auto const res = std::from_chars(t.data(), t.data() + t.size(), values[i]);
+            errors[i] = (res.ptr == t.data() + t.size()) ? res.ec : std::errc::invalid_argument;
+        }
+
+        loop_time += elapsed_ms(start);
+
+        loop_sum = 0;
+        for (auto v : values)
+            loop_sum += double(v);
+
+        start = std::chrono::high_resolution_clock::now();
+        if constexpr (std::is_floating_point_v<T>)
+            parse_floats<T>(tokens, values, errors);
+        else
+            parse_integers<T>(tokens, values, errors);
+
+        batch_time += elapsed_ms(start);
+
+        batch_sum = 0;
+        for (auto v : values)
+            batch_sum += double(v);
+    }
+
+    if (!silent)
+    {
+        std::cout << title << "\n";
+        std::cout << "from_chars loop (ms):   " << std::setw(12) << loop_time / runs << "\n";
+        std::cout << "Batch parser (ms):      " << std::setw(12) << batch_time / runs << "\n";
+        std::cout << "Checksums:              " << std::setw(12) << std::setprecision(6) << loop_sum << " / " << batch_sum << "\n";
+        std::cout << "--------------------------------------------------------------\n";
+    }
+}
+
+} // namespace {}
+
+
+void run_benchmark_numeric(std::size_t count, unsigned runs, bool silent)
+{
+    std::mt19937_64 gen(1);
+    OStringStream integers;
+    OStringStream decimals;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (i)
+        {
+            integers << SEPARATOR;
+            decimals << SEPARATOR;
+        }
+
+        // all magnitudes, not just the short ones
+        integers << (std::int64_t(gen()) >> (gen() % 64));
+        decimals << std::int64_t(gen() % 2000000) - 1000000 << '.' << std::setw(2) << std::setfill('0') << (gen() % 100);
+    }
+
+    RString const integer_source(integers.str());
+    RString const decimal_source(decimals.str());
+
+    RStringVector tokens;
+    split2(integer_source, tokens);
+    run<std::int64_t>("Parsing integers...", tokens, runs, silent);
+
+    tokens.clear();
+    split2(decimal_source, tokens);
+    run<double>("Parsing decimals as doubles...", tokens, runs, silent);
+}
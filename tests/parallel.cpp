@@ -0,0 +1,100 @@
+#include "common.h"
+
+#include <immutable_string/parallel.hxx>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace ims;
+
+namespace
+{
+
+// long enough for several partitions, with empty records and a record longer than a partition
+std::string make_source()
+{
+    std::string source;
+    for (int i = 0; source.size() < 1024 * 1024; ++i)
+    {
+        source.append(std::size_t(i % 23), char('a' + i % 26));
+        source.push_back('\n');
+    }
+
+    source.append(200 * 1024, 'z');
+    source.append("\n\nlast");
+    return source;
+}
+
+std::vector<std::string> reference_split(std::string_view source, char delimiter, bool skip_empty)
+{
+    std::vector<std::string> result;
+    std::size_t start = 0;
+    while (start < source.size())
+    {
+        auto end = std::min(source.find(delimiter, start), source.size());
+        if (end > start || !skip_empty)
+            result.emplace_back(source.substr(start, end - start));
+
+        start = end + 1;
+    }
+
+    return result;
+}
+
+} // namespace {}
+
+
+TEST(parallel, split)
+{
+    auto const source = make_source();
+    immutable_string str(source);
+
+    for (bool skip_empty : { true, false })
+    {
+        auto expected = reference_split(source, '\n', skip_empty);
+        for (unsigned threads : { 1u, 2u, 3u, 8u })
+        {
+            auto result = parallel_split(str, '\n', threads, skip_empty);
+            ASSERT_EQ(result.size(), expected.size()) << "threads=" << threads;
+            for (std::size_t i = 0; i < result.size(); ++i)
+                ASSERT_EQ(std::string_view(result[i].data(), result[i].size()), expected[i]) << "i=" << i;
+
+            // substrings of the source
+            EXPECT_EQ(result.back().data(), str.data() + str.size() - 4);
+        }
+    }
+
+    EXPECT_TRUE(parallel_split(immutable_string(), '\n').empty());
+}
+
+TEST(parallel, count_find_word_count)
+{
+    auto const source = make_source();
+    immutable_string str(source);
+    auto const words = reference_split(source, '\n', true).size();
+
+    for (unsigned threads : { 1u, 4u })
+    {
+        EXPECT_EQ(parallel_count(str, '\n', threads), std::size_t(std::count(source.begin(), source.end(), '\n')));
+        EXPECT_EQ(parallel_word_count(str, '\n', threads), words);
+
+        // overlapping matches, some of them crossing partition boundaries
+        std::vector<std::size_t> expected;
+        for (auto pos = source.find("zz"); pos != std::string::npos; pos = source.find("zz", pos + 1))
+            expected.push_back(pos);
+
+        EXPECT_EQ(parallel_find_all(str, std::string_view("zz"), threads), expected);
+
+        // a longer needle ending at the very end, and one that isn't there
+        auto const tail = source.substr(source.size() - 9);
+        expected.clear();
+        for (auto pos = source.find(tail); pos != std::string::npos; pos = source.find(tail, pos + 1))
+            expected.push_back(pos);
+
+        EXPECT_EQ(parallel_find_all(str, std::string_view(tail), threads), expected);
+        EXPECT_TRUE(parallel_find_all(str, std::string_view("#absent#"), threads).empty());
+    }
+
+    EXPECT_TRUE(parallel_find_all(str, std::string_view()).empty());
+}
@@ -0,0 +1,74 @@
+#include "common.h"
+#include "benchmark.h"
+
+#include <immutable_string/parallel.hxx>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+
+template <class RunF>
+uint64_t measure(RunF run, unsigned runs, uint64_t& result)
+{
+    uint64_t time = 0;
+    for (unsigned r = 0; r < runs; r++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        result = run();
+        auto end = std::chrono::high_resolution_clock::now();
+        time += std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    }
+
+    return time / runs;
+}
+
+} // namespace {}
+
+
+void run_benchmark_parallel(const RString& source, unsigned runs, bool silent)
+{
+    auto const max_threads = std::max(4u, std::thread::hardware_concurrency());
+    uint64_t result = 0;
+
+    auto time = measure([&source]()
+    {
+        RStringVector words;
+        split2(source, words);
+        return uint64_t(words.size());
+    }, runs, result);
+
+    if (!silent)
+    {
+        std::cout << "Splitting with split2()...\n";
+        std::cout << "Records:    " << std::setw(10) << result << "\n";
+        std::cout << "Time (ms):  " << std::setw(10) << time << "\n";
+        std::cout << "--------------------------------------------------------------\n";
+        std::cout << "Splitting with ims::parallel_split()...\n";
+    }
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+    {
+        time = measure([&source, threads]() { return uint64_t(parallel_split(source, SEPARATOR, threads).size()); }, runs, result);
+        if (!silent)
+            std::cout << "Threads: " << std::setw(3) << threads << "  Records: " << std::setw(10) << result << "  Time (ms): " << std::setw(8) << time << "\n";
+    }
+
+    if (!silent)
+    {
+        std::cout << "--------------------------------------------------------------\n";
+        std::cout << "Counting words with ims::parallel_word_count()...\n";
+    }
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+    {
+        time = measure([&source, threads]() { return uint64_t(parallel_word_count(source, SEPARATOR, threads)); }, runs, result);
+        if (!silent)
+            std::cout << "Threads: " << std::setw(3) << threads << "  Records: " << std::setw(10) << result << "  Time (ms): " << std::setw(8) << time << "\n";
+    }
+
+    if (!silent)
+        std::cout << "--------------------------------------------------------------\n";
+}
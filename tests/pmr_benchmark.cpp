@@ -0,0 +1,83 @@
+#include "common.h"
+#include "benchmark.h"
+
+#include <chrono>
+#include <memory_resource>
+#include <type_traits>
+
+namespace
+{
+
+constexpr std::size_t RequestSize = 1000; // words per request
+
+// materializes the request's words as strings and builds a reply out of them
+template <class StringT>
+uint64_t process_request(const std::vector<std::string_view>& words, std::size_t first, std::size_t last, const typename StringT::allocator_type& a)
+{
+    std::vector<StringT> strings;
+    strings.reserve(last - first);
+    for (auto i = first; i < last; ++i)
+        strings.emplace_back(words[i].data(), words[i].size(), a);
+
+    typename StringT::builder b(StringT::builder::DefaultReserve, a);
+    for (auto& s : strings)
+        b.append(s).append(SEPARATOR);
+
+    return b.str().size();
+}
+
+// every request gets a fresh ResourceT (if any), which is thrown away with everything allocated from it
+template <class StringT, class ResourceT>
+uint64_t process_requests(const std::vector<std::string_view>& words)
+{
+    uint64_t total = 0;
+    for (std::size_t first = 0; first < words.size(); first += RequestSize)
+    {
+        auto last = std::min(words.size(), first + RequestSize);
+        if constexpr (std::is_void_v<ResourceT>)
+        {
+            total += process_request<StringT>(words, first, last, typename StringT::allocator_type());
+        }
+        else
+        {
+            ResourceT resource;
+            total += process_request<StringT>(words, first, last, typename StringT::allocator_type(&resource));
+        }
+    }
+
+    return total;
+}
+
+template <class StringT, class ResourceT>
+void run(const char* title, const std::vector<std::string_view>& words, unsigned runs, bool silent)
+{
+    if (!silent)
+        std::cout << title << "\n";
+
+    uint64_t time = 0;
+    uint64_t total = 0;
+    for (unsigned r = 0; r < runs; r++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        total = process_requests<StringT, ResourceT>(words);
+        auto end = std::chrono::high_resolution_clock::now();
+        time += std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    }
+
+    if (!silent)
+    {
+        std::cout << "Bytes:      " << std::setw(10) << total << "\n";
+        std::cout << "Time (ms):  " << std::setw(10) << time / runs << "\n";
+        std::cout << "--------------------------------------------------------------\n";
+    }
+}
+
+} // namespace {}
+
+
+void run_benchmark_pmr(const std::vector<std::string_view>& words, unsigned runs, bool silent)
+{
+    run<immutable_string, void>("Processing requests with std::allocator...", words, runs, silent);
+    run<pmr::immutable_string, std::pmr::monotonic_buffer_resource>("Processing requests with std::pmr::monotonic_buffer_resource...", words, runs, silent);
+    run<pmr::immutable_string, std::pmr::unsynchronized_pool_resource>("Processing requests with std::pmr::unsynchronized_pool_resource...", words, runs, silent);
+}
@@ -0,0 +1,136 @@
+#include "common.h"
+
+#include <immutable_string/radix_tree.hxx>
+
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace ims;
+
+namespace
+{
+
+std::vector<std::pair<immutable_string, int>> collect(const radix_tree<int>& t, std::string_view prefix)
+{
+    std::vector<std::pair<immutable_string, int>> result;
+    t.for_each_prefix(prefix, [&result](const immutable_string& k, int v) { result.emplace_back(k, v); });
+    return result;
+}
+
+} // namespace {}
+
+
+TEST(radix_tree, basic)
+{
+    radix_tree<int> t;
+    EXPECT_TRUE(t.empty());
+    EXPECT_EQ(t.find("a"), nullptr);
+
+    immutable_string const source("/usr/local/bin /usr/local/lib /usr/lib /usr /var/log/messages.1");
+    std::vector<immutable_string> keys;
+    source.split(' ', std::back_inserter(keys));
+
+    for (std::size_t i = 0; i < keys.size(); ++i)
+        EXPECT_TRUE(t.try_emplace(keys[i], int(i)).second);
+
+    EXPECT_FALSE(t.try_emplace(keys[0], 100).second);
+    EXPECT_EQ(t.size(), keys.size());
+
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        ASSERT_NE(t.find(keys[i]), nullptr);
+        EXPECT_EQ(*t.find(keys[i]), int(i));
+    }
+
+    EXPECT_EQ(t.find("/usr/local"), nullptr);
+    EXPECT_EQ(t.find("/usr/lib/x"), nullptr);
+    EXPECT_EQ(t.find(""), nullptr);
+
+    // keys are shared, not copied
+    auto const usr = collect(t, "/usr/local/");
+    ASSERT_EQ(usr.size(), 2u);
+    EXPECT_EQ(usr[0].first, "/usr/local/bin");
+    EXPECT_EQ(usr[0].first.data(), keys[0].data());
+    EXPECT_EQ(usr[1].first, "/usr/local/lib");
+
+    EXPECT_EQ(collect(t, "/usr").size(), 4u);
+    EXPECT_EQ(collect(t, "").size(), 5u);
+    EXPECT_EQ(collect(t, "/usr/local/bin/x").size(), 0u);
+    EXPECT_EQ(collect(t, "/x").size(), 0u);
+
+    auto m = t.longest_prefix_match("/usr/local/share/doc");
+    ASSERT_NE(m, nullptr);
+    EXPECT_EQ(m->key, "/usr");
+    m = t.longest_prefix_match("/usr/lib/libc.so");
+    ASSERT_NE(m, nullptr);
+    EXPECT_EQ(m->key, "/usr/lib");
+    EXPECT_EQ(t.longest_prefix_match("/us"), nullptr);
+    EXPECT_EQ(t.longest_prefix_match("/var/log/messages.1")->value, 4);
+}
+
+TEST(radix_tree, random)
+{
+    // all node sizes, keys that are prefixes of other keys, binary bytes
+    std::mt19937 rng(42);
+    std::map<std::string, int> reference;
+    radix_tree<int> t;
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        std::string key(std::size_t(rng() % 6), '\0');
+        for (auto& c : key)
+            c = char(rng() % ((i % 3) ? 256 : 4));
+
+        auto const inserted = reference.emplace(key, i).second;
+        EXPECT_EQ(t.try_emplace(immutable_string(key), i).second, inserted);
+    }
+
+    ASSERT_EQ(t.size(), reference.size());
+
+    std::vector<std::string> order;
+    t.for_each([&order](const immutable_string& k, int) { order.emplace_back(k.data(), k.size()); });
+    ASSERT_EQ(order.size(), reference.size());
+    auto it = reference.begin();
+    for (auto& k : order)
+        EXPECT_EQ(k, (it++)->first);
+
+    // erase every other key, the rest must stay reachable
+    std::size_t n = 0;
+    for (auto r = reference.begin(); r != reference.end();)
+    {
+        if (n++ % 2)
+        {
+            EXPECT_TRUE(t.erase(r->first));
+            r = reference.erase(r);
+        }
+        else
+        {
+            ++r;
+        }
+    }
+
+    EXPECT_FALSE(t.erase("not there at all"));
+    ASSERT_EQ(t.size(), reference.size());
+    for (auto& [k, v] : reference)
+    {
+        auto found = t.find(k);
+        ASSERT_NE(found, nullptr);
+        EXPECT_EQ(*found, v);
+    }
+
+    std::size_t visited = 0;
+    t.for_each_prefix(std::string_view("\x01", 1), [&visited](const immutable_string& k, int) { EXPECT_EQ(k.data()[0], '\x01'); ++visited; });
+    std::size_t expected = 0;
+    for (auto& [k, v] : reference)
+        expected += (!k.empty() && k[0] == '\x01');
+
+    EXPECT_EQ(visited, expected);
+
+    for (auto& [k, v] : reference)
+        EXPECT_TRUE(t.erase(k));
+
+    EXPECT_TRUE(t.empty());
+}
@@ -0,0 +1,99 @@
+#include "common.h"
+#include "benchmark.h"
+
+#include <immutable_string/radix_tree.hxx>
+
+#include <chrono>
+#include <map>
+
+namespace
+{
+
+struct view_less
+{
+    bool operator()(const RString& a, const RString& b) const noexcept
+    {
+        return std::string_view(a.data(), a.size()) < std::string_view(b.data(), b.size());
+    }
+};
+
+using RStringMap = std::map<RString, uint64_t, view_less>;
+using RRadixTree = radix_tree<uint64_t, RString>;
+
+constexpr std::size_t PrefixLength = 3;
+constexpr std::size_t PrefixScans = 10000;
+
+uint64_t scan(const RStringMap& m, std::string_view prefix)
+{
+    uint64_t total = 0;
+    for (auto it = m.lower_bound(RString(prefix.data(), prefix.size())); it != m.end() && std::string_view(it->first.data(), it->first.size()).starts_with(prefix); ++it)
+        total += it->second;
+
+    return total;
+}
+
+uint64_t scan(const RRadixTree& t, std::string_view prefix)
+{
+    uint64_t total = 0;
+    t.for_each_prefix(prefix, [&total](const RString&, uint64_t v) { total += v; });
+    return total;
+}
+
+template <class ContainerT>
+void run(const char* title, const RStringVector& words, unsigned runs, bool silent)
+{
+    uint64_t insert_time = 0;
+    uint64_t lookup_time = 0;
+    uint64_t scan_time = 0;
+    uint64_t found = 0;
+    uint64_t scanned = 0;
+    for (unsigned r = 0; r < runs; r++)
+    {
+        ContainerT c;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (auto& w : words)
+            c.try_emplace(w, w.size());
+
+        insert_time += elapsed_ms(start);
+
+        found = 0;
+        start = std::chrono::high_resolution_clock::now();
+        for (auto& w : words)
+        {
+            if constexpr (std::is_same_v<ContainerT, RStringMap>)
+                found += c.find(w)->second;
+            else
+                found += *c.find(std::string_view(w.data(), w.size()));
+        }
+
+        lookup_time += elapsed_ms(start);
+
+        scanned = 0;
+        start = std::chrono::high_resolution_clock::now();
+        for (std::size_t i = 0; i < PrefixScans; ++i)
+        {
+            auto& w = words[(i * 7919) % words.size()];
+            scanned += scan(c, std::string_view(w.data(), std::min(w.size(), PrefixLength)));
+        }
+
+        scan_time += elapsed_ms(start);
+    }
+
+    if (!silent)
+    {
+        std::cout << title << "\n";
+        std::cout << "Insert (ms):         " << std::setw(12) << insert_time / runs << "\n";
+        std::cout << "Lookup (ms):         " << std::setw(12) << lookup_time / runs << "  Checksum: " << found << "\n";
+        std::cout << "Prefix scans (ms):   " << std::setw(12) << scan_time / runs << "  Checksum: " << scanned << "\n";
+        std::cout << "--------------------------------------------------------------\n";
+    }
+}
+
+} // namespace {}
+
+
+void run_benchmark_radix_tree(const RStringVector& words, unsigned runs, bool silent)
+{
+    run<RStringMap>("Indexing words with std::map<immutable_string>...", words, runs, silent);
+    run<RRadixTree>("Indexing words with ims::radix_tree...", words, runs, silent);
+}
@@ -0,0 +1,249 @@
+#include "common.h"
+
+#include <immutable_string/reader.hxx>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+using namespace ims;
+
+namespace
+{
+
+struct temp_file
+{
+    explicit temp_file(const std::string& contents)
+        : f(std::tmpfile())
+    {
+        if (!f)
+            throw std::runtime_error("Failed to create a temporary file");
+
+        std::fwrite(contents.data(), 1, contents.size(), f);
+        std::fflush(f);
+        std::rewind(f);
+    }
+
+    ~temp_file()
+    {
+        std::fclose(f);
+    }
+
+    int fd() const
+    {
+        return fileno(f);
+    }
+
+    std::FILE* f;
+};
+
+#if !defined(_WIN32)
+
+struct pipe_pair
+{
+    pipe_pair()
+    {
+        if (::pipe(fds) != 0)
+            throw std::runtime_error("Failed to create a pipe");
+    }
+
+    ~pipe_pair()
+    {
+        close_read();
+        close_write();
+    }
+
+    void close_read()
+    {
+        if (fds[0] >= 0)
+            ::close(fds[0]);
+        fds[0] = -1;
+    }
+
+    void close_write()
+    {
+        if (fds[1] >= 0)
+            ::close(fds[1]);
+        fds[1] = -1;
+    }
+
+    int fds[2] = { -1, -1 };
+};
+
+#endif
+
+std::vector<std::string> split_all(const std::string& source, char delimiter)
+{
+    std::vector<std::string> result;
+    std::size_t start = 0;
+    for (;;)
+    {
+        auto delim = source.find(delimiter, start);
+        if (delim == std::string::npos)
+        {
+            if (start < source.size())
+                result.push_back(source.substr(start));
+            break;
+        }
+
+        result.push_back(source.substr(start, delim - start));
+        start = delim + 1;
+    }
+
+    return result;
+}
+
+std::vector<std::string> read_all(int fd, std::size_t chunk_size, bool read_ahead)
+{
+    std::vector<std::string> result;
+    chunked_reader reader(fd, '\n', chunk_size, read_ahead);
+    immutable_string record;
+    while (reader.next(record))
+        result.emplace_back(record.data(), record.size());
+
+    return result;
+}
+
+} // namespace {}
+
+
+TEST(chunked_reader, empty)
+{
+    temp_file f("");
+    chunked_reader reader(f.fd());
+    immutable_string record;
+    EXPECT_FALSE(reader.next(record));
+    EXPECT_FALSE(reader.next(record));
+}
+
+TEST(chunked_reader, records)
+{
+    std::string source;
+    for (int i = 0; i < 1000; ++i)
+    {
+        source.append(std::size_t(i % 37), char('a' + i % 26));
+        source.push_back('\n');
+    }
+
+    // one long record spanning many chunks, and no trailing delimiter
+    source.append(5000, 'z');
+
+    auto expected = split_all(source, '\n');
+
+    for (bool read_ahead : { false, true })
+    {
+        for (std::size_t chunk_size : { std::size_t(1), std::size_t(7), std::size_t(64), std::size_t(4096), std::size_t(1024 * 1024) })
+        {
+            temp_file f(source);
+            auto records = read_all(f.fd(), chunk_size, read_ahead);
+            EXPECT_EQ(records, expected) << "chunk_size=" << chunk_size << " read_ahead=" << read_ahead;
+        }
+    }
+}
+
+TEST(chunked_reader, zero_copy)
+{
+    std::string source("first record that is long enough\nsecond record that is long enough\n");
+    temp_file f(source);
+    chunked_reader reader(f.fd(), '\n', 1024 * 1024, false);
+
+    immutable_string a;
+    immutable_string b;
+    ASSERT_TRUE(reader.next(a));
+    ASSERT_TRUE(reader.next(b));
+
+    // both records are substrings of the same chunk
+    EXPECT_TRUE(a._is_shared());
+    EXPECT_TRUE(b._is_shared());
+    EXPECT_FALSE(a._has_null_terminator());
+    EXPECT_EQ(a.data() + a.size() + 1, b.data());
+    EXPECT_STREQ(b.c_str(), "second record that is long enough");
+
+    immutable_string c;
+    EXPECT_FALSE(reader.next(c));
+}
+
+TEST(chunked_reader, record_at_chunk_boundary)
+{
+    // the delimiter is the first character of the second chunk
+    std::string source("0123456789abcdef0123456789abcdef\nnext\n");
+    temp_file f(source);
+    chunked_reader reader(f.fd(), '\n', 32, false);
+
+    immutable_string a;
+    ASSERT_TRUE(reader.next(a));
+    EXPECT_EQ(std::string(a.data(), a.size()), "0123456789abcdef0123456789abcdef");
+    EXPECT_TRUE(a._is_shared()); // still the first chunk, not a copy
+
+    immutable_string b;
+    ASSERT_TRUE(reader.next(b));
+    EXPECT_EQ(std::string(b.data(), b.size()), "next");
+    EXPECT_FALSE(reader.next(b));
+}
+
+#if !defined(_WIN32)
+
+TEST(chunked_reader, pipe)
+{
+    std::string line("abcdefghijklmnopqrstuvwxy\n");
+
+    for (bool read_ahead : { false, true })
+    {
+        pipe_pair p;
+
+        // short writes, each one is a short read on the other side
+        std::thread writer([&p, &line]()
+        {
+            for (int i = 0; i < 200; ++i)
+            {
+                (void)::write(p.fds[1], line.data(), line.size());
+                if (i % 20 == 0)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            p.close_write();
+        });
+
+        std::vector<immutable_string> records;
+        {
+            chunked_reader reader(p.fds[0], '\n', 1024 * 1024, read_ahead);
+            immutable_string record;
+            while (reader.next(record))
+                records.push_back(record);
+        }
+
+        writer.join();
+
+        ASSERT_EQ(records.size(), 200u);
+        for (std::size_t i = 0; i < records.size(); ++i)
+        {
+            EXPECT_EQ(std::string(records[i].data(), records[i].size()), line.substr(0, line.size() - 1));
+
+            // all of them are substrings of a single chunk
+            if (i)
+            {
+                EXPECT_EQ(records[i].data(), records[i - 1].data() + line.size()) << "read_ahead=" << read_ahead;
+            }
+        }
+    }
+}
+
+TEST(chunked_reader, idle_pipe)
+{
+    pipe_pair p;
+    (void)::write(p.fds[1], "first\nsecond", 12);
+
+    // the destructor interrupts the read-ahead thread waiting for more data
+    chunked_reader reader(p.fds[0], '\n', 4, true);
+    immutable_string record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(std::string(record.data(), record.size()), "first");
+}
+
+#endif
@@ -0,0 +1,172 @@
+#include "common.h"
+
+#include <immutable_string/shm_string_table.hxx>
+
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+
+using namespace ims;
+
+namespace
+{
+
+std::vector<std::string> vocabulary(std::size_t n, const char* prefix)
+{
+    std::vector<std::string> words;
+    words.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        words.push_back(prefix + std::to_string(i * 7919));
+
+    return words;
+}
+
+} // namespace {}
+
+
+TEST(shm_string_table, intern)
+{
+    auto t = shm_string_table::anonymous(64 * 1024, 1000);
+    EXPECT_EQ(t.size(), 0);
+    EXPECT_EQ(t.bytes_used(), 0);
+
+    auto const a = t.intern(std::string("vocabulary"));
+    EXPECT_EQ(a, "vocabulary");
+    EXPECT_EQ(t.size(), 1);
+    EXPECT_FALSE(a._is_short());
+    EXPECT_FALSE(a._is_shared());
+
+    // the same record, whatever the key type
+    EXPECT_EQ(t.intern(std::string_view("vocabulary")).data(), a.data());
+    EXPECT_EQ(t.intern(immutable_string("vocabulary")).data(), a.data());
+    EXPECT_EQ(t.find(std::string_view("vocabulary"))->data(), a.data());
+    EXPECT_EQ(t.size(), 1);
+
+    EXPECT_FALSE(t.find(std::string_view("vocabular")));
+    EXPECT_TRUE(t.intern(std::string_view("")).empty());
+    EXPECT_EQ(t.size(), 1);
+
+    // records are null-terminated, so c_str() doesn't copy
+    EXPECT_EQ(a.data()[a.size()], '\0');
+    EXPECT_TRUE(a._has_null_terminator());
+    EXPECT_EQ(a.c_str(), a.data());
+
+    std::string const binary("a\0b", 3);
+    EXPECT_EQ(t.intern(binary), immutable_string(binary.data(), binary.size()));
+    EXPECT_NE(t.intern(std::string_view("a")).data(), t.intern(binary).data());
+    EXPECT_EQ(t.size(), 3);
+}
+
+TEST(shm_string_table, full)
+{
+    auto t = shm_string_table::anonymous(256, 4);
+    std::size_t added = 0;
+    EXPECT_THROW(
+    {
+        for (auto& w : vocabulary(1000, "word-"))
+        {
+            (void)t.intern(w);
+            ++added;
+        }
+    }, std::length_error);
+
+    EXPECT_GT(added, 0);
+    EXPECT_EQ(t.size(), added);
+    EXPECT_LE(t.bytes_used(), t.capacity());
+
+    // what's there is still found
+    for (auto& w : vocabulary(added, "word-"))
+        EXPECT_TRUE(t.find(w)) << w;
+
+    // a string that doesn't fit leaves the room for smaller ones
+    {
+        auto t = shm_string_table::anonymous(256, 4);
+        auto const used = t.bytes_used();
+        EXPECT_THROW((void)t.intern(std::string(1000, 'x')), std::length_error);
+        EXPECT_EQ(t.bytes_used(), used);
+        EXPECT_EQ(t.intern(std::string_view("small")), "small");
+        EXPECT_EQ(t.size(), 1);
+    }
+}
+
+TEST(shm_string_table, named)
+{
+    auto const name = "/ims_test_" + std::to_string(::getpid());
+    shm_string_table::remove(name.c_str());
+
+    auto writer = shm_string_table::create(name.c_str(), 64 * 1024, 100);
+    EXPECT_THROW((void)shm_string_table::create(name.c_str(), 1024, 10), std::system_error);
+
+    auto reader = shm_string_table::open(name.c_str());
+    EXPECT_TRUE(shm_string_table::remove(name.c_str()));
+    EXPECT_THROW((void)shm_string_table::open(name.c_str()), std::system_error);
+
+    // two mappings of the same object
+    auto const w = writer.intern(std::string_view("shared between mappings"));
+    auto const r = reader.find(std::string_view("shared between mappings"));
+    ASSERT_TRUE(r);
+    EXPECT_EQ(*r, w);
+    EXPECT_NE(r->data(), w.data());
+    EXPECT_EQ(reader.size(), 1);
+    EXPECT_EQ(reader.bytes_used(), writer.bytes_used());
+}
+
+TEST(shm_string_table, fork)
+{
+    constexpr int Workers = 4;
+    constexpr std::size_t Common = 2000;
+    constexpr std::size_t Own = 500;
+
+    auto t = shm_string_table::anonymous(1024 * 1024, Common + Workers * Own);
+    auto const common = vocabulary(Common, "common-");
+
+    std::vector<pid_t> children;
+    for (int w = 0; w < Workers; ++w)
+    {
+        auto const pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0)
+        {
+            // every worker interns the whole common vocabulary, starting at different points, and its own words
+            bool ok = true;
+            for (std::size_t i = 0; i < Common; ++i)
+            {
+                auto const& word = common[(i + w * Common / Workers) % Common];
+                auto const s = t.intern(word);
+                ok = ok && (s == immutable_string(word)) && (t.intern(word).data() == s.data());
+            }
+
+            for (auto& word : vocabulary(Own, ("own-" + std::to_string(w) + "-").c_str()))
+                ok = ok && (t.intern(word) == immutable_string(word));
+
+            ::_exit(ok ? 0 : 1);
+        }
+
+        children.push_back(pid);
+    }
+
+    for (auto pid : children)
+    {
+        int status = 0;
+        ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+        EXPECT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0);
+    }
+
+    // a single copy of everything
+    EXPECT_EQ(t.size(), Common + Workers * Own);
+    for (auto& word : common)
+    {
+        auto const s = t.find(word);
+        ASSERT_TRUE(s) << word;
+        EXPECT_EQ(*s, immutable_string(word));
+    }
+
+    auto const used = t.bytes_used();
+    for (auto& word : common)
+        (void)t.intern(word);
+
+    EXPECT_EQ(t.size(), Common + Workers * Own);
+    EXPECT_EQ(t.bytes_used(), used);
+}
@@ -0,0 +1,120 @@
+#include "common.h"
+
+#include <immutable_string/static_map.hxx>
+
+#include <set>
+#include <string>
+#include <string_view>
+
+using namespace ims;
+
+namespace
+{
+
+enum class verb
+{
+    get,
+    head,
+    post,
+    put,
+    del,
+    connect,
+    options,
+    trace,
+    patch
+};
+
+constexpr auto Verbs = make_static_map<verb>({
+    { "GET", verb::get },
+    { "HEAD", verb::head },
+    { "POST", verb::post },
+    { "PUT", verb::put },
+    { "DELETE", verb::del },
+    { "CONNECT", verb::connect },
+    { "OPTIONS", verb::options },
+    { "TRACE", verb::trace },
+    { "PATCH", verb::patch }
+});
+
+constexpr auto Keys = make_static_set({
+    "",
+    "a",
+    "listen_address",
+    "max_connections",
+    "keepalive_timeout",
+    "tls_certificate_chain_file",
+    "worker_threads",
+    "log_level"
+});
+
+} // namespace {}
+
+
+TEST(static_string_map, compile_time)
+{
+    static_assert(Verbs.size() == 9);
+    static_assert(*Verbs.find(std::string_view("POST")) == verb::post);
+    static_assert(Verbs.at(std::string_view("PATCH")) == verb::patch);
+    static_assert(!Verbs.contains(std::string_view("POS")));
+    static_assert(!Verbs.contains(std::string_view("POSTS")));
+    static_assert(!Verbs.contains(std::string_view("get")));
+
+    static_assert(Keys.contains(std::string_view("")));
+    static_assert(Keys.contains(std::string_view("tls_certificate_chain_file")));
+    static_assert(!Keys.contains(std::string_view("tls_certificate_chain_filE")));
+}
+
+TEST(static_string_map, lookup)
+{
+    // a minimal perfect hash: every key has its own slot
+    std::set<std::size_t> slots;
+    for (auto k : { "GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH" })
+    {
+        auto const i = Verbs.index_of(std::string_view(k));
+        ASSERT_LT(i, Verbs.size());
+        EXPECT_TRUE(slots.insert(i).second);
+        EXPECT_EQ(Verbs.keys().view_at(i), k);
+    }
+
+    EXPECT_EQ(*Verbs.find(std::string("DELETE")), verb::del);
+    EXPECT_EQ(*Verbs.find(immutable_string("OPTIONS")), verb::options);
+    EXPECT_EQ(Verbs.find(std::string_view("OPTION")), nullptr);
+    EXPECT_EQ(Verbs.find(std::string_view("DELETE\0", 7)), nullptr);
+    EXPECT_THROW((void)Verbs.at(std::string_view("FETCH")), std::out_of_range);
+
+    for (auto k : { "a", "listen_address", "max_connections", "keepalive_timeout", "tls_certificate_chain_file", "worker_threads", "log_level" })
+        EXPECT_TRUE(Keys.contains(std::string_view(k))) << k;
+
+    for (auto k : { "b", "A", "listen_addres", "listen_addresss", "max_connection", "log_leve1", "tls_certificate_chain_fil" })
+        EXPECT_FALSE(Keys.contains(std::string_view(k))) << k;
+}
+
+TEST(static_string_map, literal_keys)
+{
+    std::string const input("max_connections");
+    auto const key = Keys.find(input);
+    ASSERT_TRUE(key);
+    EXPECT_EQ(*key, "max_connections");
+    EXPECT_NE(key->data(), input.data());
+    EXPECT_FALSE(key->_is_short());
+    EXPECT_FALSE(key->_is_shared());
+    EXPECT_TRUE(key->_has_null_terminator());
+    EXPECT_EQ(key->data(), Keys.key_at(Keys.index_of(input)).data());
+
+    EXPECT_FALSE(Keys.find(std::string_view("min_connections")));
+
+    auto const verb = Verbs.key_at(Verbs.index_of(std::string_view("TRACE")));
+    EXPECT_EQ(verb, "TRACE");
+    EXPECT_FALSE(verb._is_shared());
+}
+
+TEST(static_string_map, wide)
+{
+    constexpr auto words = make_static_set<immutable_wstring>({ L"alpha", L"beta", L"gamma", L"delta", L"epsilon-zeta-eta" });
+    static_assert(words.contains(std::wstring_view(L"beta")));
+    static_assert(!words.contains(std::wstring_view(L"bet")));
+
+    EXPECT_TRUE(words.contains(std::wstring(L"epsilon-zeta-eta")));
+    EXPECT_FALSE(words.contains(std::wstring(L"epsilon-zeta-et")));
+    EXPECT_EQ(*words.find(std::wstring_view(L"gamma")), L"gamma");
+}
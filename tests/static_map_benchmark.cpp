@@ -0,0 +1,103 @@
+#include "common.h"
+#include "benchmark.h"
+
+#include <immutable_string/static_map.hxx>
+
+#include <chrono>
+#include <unordered_map>
+
+namespace
+{
+
+const char* const Keywords[] =
+{
+    "GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH",
+    "listen", "server_name", "root", "index", "location", "proxy_pass", "return", "rewrite",
+    "worker_processes", "worker_connections", "keepalive_timeout", "client_max_body_size",
+    "ssl_certificate", "ssl_certificate_key", "access_log", "error_log"
+};
+
+constexpr auto StaticKeywords = make_static_map<uint64_t, RString>({
+    { "GET", 1 }, { "HEAD", 2 }, { "POST", 3 }, { "PUT", 4 }, { "DELETE", 5 }, { "CONNECT", 6 }, { "OPTIONS", 7 }, { "TRACE", 8 }, { "PATCH", 9 },
+    { "listen", 10 }, { "server_name", 11 }, { "root", 12 }, { "index", 13 }, { "location", 14 }, { "proxy_pass", 15 }, { "return", 16 }, { "rewrite", 17 },
+    { "worker_processes", 18 }, { "worker_connections", 19 }, { "keepalive_timeout", 20 }, { "client_max_body_size", 21 },
+    { "ssl_certificate", 22 }, { "ssl_certificate_key", 23 }, { "access_log", 24 }, { "error_log", 25 }
+});
+
+struct view_hash
+{
+    std::size_t operator()(const RString& s) const noexcept
+    {
+        return std::hash<std::string_view>()(std::string_view(s.data(), s.size()));
+    }
+};
+
+struct view_equal
+{
+    bool operator()(const RString& a, const RString& b) const noexcept
+    {
+        return std::string_view(a.data(), a.size()) == std::string_view(b.data(), b.size());
+    }
+};
+
+using RStringMap = std::unordered_map<RString, uint64_t, view_hash, view_equal>;
+
+} // namespace {}
+
+
+void run_benchmark_static_map(const std::vector<std::string_view>& words, unsigned runs, bool silent)
+{
+    // every other token is a keyword, the rest are (mostly) misses
+    std::vector<std::string_view> tokens;
+    tokens.reserve(words.size());
+    for (std::size_t i = 0; i < words.size(); ++i)
+        tokens.push_back((i & 1) ? words[i] : std::string_view(Keywords[(i / 2) % std::size(Keywords)]));
+
+    uint64_t startup_time = 0;
+    uint64_t map_time = 0;
+    uint64_t static_time = 0;
+    uint64_t map_found = 0;
+    uint64_t static_found = 0;
+    for (unsigned r = 0; r < runs; r++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        RStringMap m;
+        for (uint64_t i = 0; i < std::size(Keywords); ++i)
+            m.emplace(RString(Keywords[i], RString::FromStringLiteral), i + 1);
+
+        startup_time += elapsed_us(start);
+
+        map_found = 0;
+        start = std::chrono::high_resolution_clock::now();
+        for (auto t : tokens)
+        {
+            // the lookup key has to be a string of the map's type
+            auto it = m.find(RString(t.data(), t.size(), RString::FromStaticStorage));
+            if (it != m.end())
+                map_found += it->second;
+        }
+
+        map_time += elapsed_us(start);
+
+        static_found = 0;
+        start = std::chrono::high_resolution_clock::now();
+        for (auto t : tokens)
+        {
+            auto v = StaticKeywords.find(t);
+            if (v)
+                static_found += *v;
+        }
+
+        static_time += elapsed_us(start);
+    }
+
+    if (!silent)
+    {
+        std::cout << "Dispatching " << tokens.size() << " tokens on " << std::size(Keywords) << " keywords...\n";
+        std::cout << "unordered_map startup (us):      " << std::setw(12) << startup_time / runs << "\n";
+        std::cout << "unordered_map lookup time (us):  " << std::setw(12) << map_time / runs << "\n";
+        std::cout << "static_string_map lookup (us):   " << std::setw(12) << static_time / runs << "\n";
+        std::cout << "Checksums:                       " << std::setw(12) << map_found << " / " << static_found << "\n";
+        std::cout << "--------------------------------------------------------------\n";
+    }
+}
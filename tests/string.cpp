@@ -3,6 +3,8 @@
 #include <immutable_string/string.hxx>
 
 #include <algorithm>
+#include <map>
+#include <memory_resource>
 #include <sstream>
 
 using namespace ims;
@@ -823,6 +825,143 @@ TEST(immutable_string, substr)
     }
 }
 
+TEST(immutable_string, borrowed)
+{
+    static const char table[] = "alpha,beta,gamma-delta-epsilon";
+
+    // a literal's suffix keeps the terminator, a middle slice doesn't
+    immutable_string const lit(LONG_STRING, immutable_string::FromStringLiteral);
+    auto const suffix = lit.substr(LONG_STRING_SHORT_PART_LEN);
+    EXPECT_FALSE(suffix._is_short());
+    EXPECT_FALSE(suffix._is_shared());
+    EXPECT_TRUE(suffix._has_null_terminator());
+    EXPECT_EQ(suffix.data(), LONG_STRING + LONG_STRING_SHORT_PART_LEN);
+    EXPECT_EQ(suffix.c_str(), LONG_STRING + LONG_STRING_SHORT_PART_LEN);
+
+    auto const middle = lit.substr(1, LONG_STRING_PART_LEN);
+    EXPECT_FALSE(middle._is_shared());
+    EXPECT_FALSE(middle._has_null_terminator());
+    EXPECT_EQ(middle.data(), LONG_STRING + 1);
+
+    // static storage isn't assumed to be terminated
+    immutable_string const stat(table, 11, immutable_string::FromStaticStorage);
+    EXPECT_FALSE(stat._is_short());
+    EXPECT_FALSE(stat._has_null_terminator());
+    EXPECT_EQ(stat, "alpha,beta,");
+
+    std::vector<immutable_string> parts;
+    immutable_string(table, sizeof(table) - 1, immutable_string::FromStaticStorage).split(',', std::back_inserter(parts));
+    ASSERT_EQ(parts.size(), 3u);
+    EXPECT_EQ(parts[0].data(), table);
+    EXPECT_EQ(parts[2].data(), table + 11);
+    EXPECT_FALSE(parts[2]._has_null_terminator());
+    EXPECT_EQ(parts[2].substr(6, 5), "delta");
+    EXPECT_EQ(parts[2].substr(6, 5).data(), table + 17);
+
+    immutable_string const empty(nullptr, 0, immutable_string::FromStaticStorage);
+    EXPECT_TRUE(empty.empty());
+    EXPECT_STREQ(empty.c_str(), "");
+
+    // c_str() of a slice makes a terminated copy, the storage is left alone
+    auto const copy = middle;
+    EXPECT_STREQ(copy.c_str(), std::string(LONG_STRING + 1, LONG_STRING_PART_LEN).c_str());
+    EXPECT_TRUE(copy._is_shared());
+    EXPECT_EQ(middle.data(), LONG_STRING + 1);
+
+    // a suffix of a buffer is terminated too
+    immutable_string const heap(LONG_STRING);
+    auto const tail = heap.substr(LONG_STRING_PART_LEN);
+    EXPECT_TRUE(tail._has_null_terminator());
+    EXPECT_EQ(tail.c_str(), heap.data() + LONG_STRING_PART_LEN);
+    EXPECT_FALSE(heap.substr(1, LONG_STRING_PART_LEN)._has_null_terminator());
+
+    // slicing static data never allocates
+    auto const prev = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    pmr::immutable_string const guarded(table, sizeof(table) - 1, pmr::immutable_string::FromStaticStorage);
+    std::vector<pmr::immutable_string> pieces;
+    EXPECT_NO_THROW(guarded.split('-', std::back_inserter(pieces)));
+    EXPECT_NO_THROW(pieces[0].substr(6).substr(5));
+    std::pmr::set_default_resource(prev);
+    EXPECT_EQ(pieces[0].data(), table);
+    EXPECT_FALSE(pieces[2]._has_null_terminator()); // static storage isn't assumed to be terminated
+}
+
+
+TEST(immutable_string, adopted)
+{
+    int deleted = 0;
+    auto free_counted = [&deleted](char* p) noexcept
+    {
+        std::free(p);
+        ++deleted;
+    };
+
+    auto make_buffer = [](const char* text)
+    {
+        auto const len = std::strlen(text);
+        auto p = static_cast<char*>(std::malloc(len));
+        std::memcpy(p, text, len); // not terminated
+        return p;
+    };
+
+    {
+        auto buffer = make_buffer(LONG_STRING);
+        immutable_string const str(buffer, LONG_STRING_LEN, immutable_string::Adopt, free_counted);
+        EXPECT_EQ(str.data(), buffer);
+        EXPECT_TRUE(str._is_shared());
+        EXPECT_FALSE(str._has_null_terminator());
+        EXPECT_EQ(str, LONG_STRING);
+
+        // copies and substrings share the buffer and keep it alive
+        auto const part = str.substr(1, LONG_STRING_PART_LEN);
+        EXPECT_EQ(part.data(), buffer + 1);
+        immutable_string copy = str;
+        EXPECT_STREQ(copy.c_str(), LONG_STRING);
+        EXPECT_NE(copy.data(), buffer);
+
+        // never extended in place
+        auto const longer = immutable_string(str).with_appended(std::string_view("!"));
+        EXPECT_EQ(longer, std::string(LONG_STRING) + "!");
+        EXPECT_EQ(str, LONG_STRING);
+        EXPECT_EQ(deleted, 0);
+
+        // the block reports no room past the foreign buffer, so nothing appends into it
+        auto const sd = detail::buffer_access<immutable_string>::shared(str);
+        EXPECT_EQ(sd->capacity(), sd->size());
+    }
+
+    EXPECT_EQ(deleted, 1);
+
+    // short ones are copied and the buffer goes right away
+    {
+        immutable_string const str(make_buffer(SHORT_STRING), SHORT_STRING_LEN, immutable_string::Adopt, free_counted);
+        EXPECT_EQ(deleted, 2);
+        EXPECT_TRUE(str._is_short());
+        EXPECT_EQ(str, SHORT_STRING);
+    }
+
+    // the buffer is deleted even if the control block can't be allocated
+    {
+        pmr::immutable_string::allocator_type none(std::pmr::null_memory_resource());
+        EXPECT_THROW(pmr::immutable_string(make_buffer(LONG_STRING), LONG_STRING_LEN, pmr::immutable_string::Adopt, free_counted, none), std::bad_alloc);
+        EXPECT_EQ(deleted, 3);
+    }
+
+    // any callable, e.g. a library's release function with its context
+    {
+        std::vector<char> payload(LONG_STRING, LONG_STRING + LONG_STRING_LEN);
+        bool released = false;
+        immutable_string str(payload.data(), payload.size(), immutable_string::Adopt, [&released, &payload](char* p) noexcept
+        {
+            EXPECT_EQ(p, payload.data());
+            released = true;
+        });
+
+        EXPECT_EQ(str.trim().data(), payload.data());
+        str = immutable_string();
+        EXPECT_TRUE(released);
+    }
+}
 TEST(immutable_string, iterators)
 {
     auto collect_chars = [](const immutable_string& src)
@@ -1061,3 +1200,545 @@ TEST(immutable_string, builder)
         EXPECT_STREQ(result.data(), "This is a long test string that does not fit into SSO but still valuable nevertheless and more and more");
     }
 }
+
+TEST(immutable_string, builder_numbers)
+{
+    {
+        immutable_string::builder b;
+
+        b.append("int=").append(-42).append(' ');
+        b.append("uint=").append(18446744073709551615ULL).append(' ');
+        b.append("int8=").append(std::int8_t(-128)).append(' ');
+        b.append("hex=").append(255, 16).append(' ');
+        b.append("double=").append(0.5).append(' ');
+        b.append("fixed=").append(3.14159, std::chars_format::fixed, 2);
+
+        auto result = b.str();
+        ASSERT_TRUE(result._has_null_terminator());
+        EXPECT_STREQ(result.c_str(), "int=-42 uint=18446744073709551615 int8=-128 hex=ff double=0.5 fixed=3.14");
+    }
+
+    // many numbers, buffer has to grow
+    {
+        immutable_string::builder b;
+        std::ostringstream ss;
+        for (int i = 0; i < 10000; ++i)
+        {
+            b.append(i).append(',');
+            ss << i << ',';
+        }
+
+        auto result = b.str();
+        EXPECT_EQ(std::string_view(result.data(), result.size()), ss.str());
+    }
+
+    // wide builder widens std::to_chars() output
+    {
+        immutable_wstring::builder b;
+        b.append(std::wstring_view(L"x=")).append(12345).append(L' ').append(1.25);
+
+        auto result = b.str();
+        EXPECT_EQ(std::wstring_view(result.data(), result.size()), L"x=12345 1.25");
+    }
+
+    // output iterator
+    {
+        immutable_string::builder b;
+        std::string_view src("copied through an output iterator");
+        std::copy(src.begin(), src.end(), b.out());
+
+        auto result = b.str();
+        EXPECT_STREQ(result.c_str(), "copied through an output iterator");
+    }
+
+#if defined(__cpp_lib_format)
+    // std::format_to() and std::formatter
+    {
+        immutable_string name("formatted");
+        immutable_string::builder b;
+        std::format_to(b.out(), "{}: {:>5}|{:.3f}", name, 42, 2.0);
+
+        auto result = b.str();
+        EXPECT_STREQ(result.c_str(), "formatted:    42|2.000");
+    }
+#endif
+}
+
+TEST(immutable_string, create_batch)
+{
+    std::vector<std::string_view> views{ LONG_STRING, SHORT_STRING, "", LONG_STRING_PART, std::string_view(EMBEDDED_NULLS_STRING, EMBEDDED_NULLS_STRING_LEN), LONG_STRING };
+
+    // null-terminated
+    {
+        std::vector<immutable_string> strings;
+        immutable_string::create_batch(views, std::back_inserter(strings));
+        ASSERT_EQ(strings.size(), views.size());
+
+        for (std::size_t i = 0; i < views.size(); ++i)
+        {
+            EXPECT_EQ(std::string_view(strings[i].data(), strings[i].size()), views[i]);
+            EXPECT_TRUE(strings[i]._has_null_terminator());
+        }
+
+        EXPECT_TRUE(strings[1]._is_short());
+        EXPECT_TRUE(strings[2].empty());
+
+        // long strings are laid out in one block, one after another
+        EXPECT_TRUE(strings[0]._is_shared());
+        EXPECT_EQ(strings[0].data() + LONG_STRING_LEN + 1, strings[3].data());
+        EXPECT_EQ(strings[3].data() + LONG_STRING_PART_LEN + 1, strings[5].data());
+
+        // c_str() does not allocate
+        auto p = strings[3].data();
+        EXPECT_EQ(strings[3].c_str(), p);
+        EXPECT_STREQ(strings[3].c_str(), LONG_STRING_PART);
+
+        // the block outlives the strings it was created with
+        auto last = strings[5];
+        strings.clear();
+        EXPECT_STREQ(last.c_str(), LONG_STRING);
+    }
+
+    // packed without terminators
+    {
+        std::vector<immutable_string> strings;
+        immutable_string::create_batch(views, std::back_inserter(strings), false);
+        ASSERT_EQ(strings.size(), views.size());
+
+        EXPECT_EQ(strings[0].data() + LONG_STRING_LEN, strings[3].data());
+        EXPECT_FALSE(strings[3]._has_null_terminator());
+        EXPECT_STREQ(strings[3].c_str(), LONG_STRING_PART);
+        EXPECT_TRUE(strings[3]._has_null_terminator());
+    }
+
+    // nothing to share
+    {
+        std::vector<std::string_view> short_views{ SHORT_STRING, SHORT_STRING_PART };
+        std::vector<immutable_string> strings;
+        immutable_string::create_batch(short_views, std::back_inserter(strings));
+        ASSERT_EQ(strings.size(), 2);
+        EXPECT_TRUE(strings[0]._is_short());
+        EXPECT_TRUE(strings[1]._is_short());
+    }
+}
+
+TEST(immutable_string, builder_right_sizing)
+{
+    // short result is SSO, nothing allocated
+    {
+        immutable_string::builder b;
+        b.append("short").append(' ').append(42);
+        EXPECT_EQ(b.size(), 8);
+
+        auto result = b.str();
+        EXPECT_TRUE(result._is_short());
+        EXPECT_STREQ(result.c_str(), "short 42");
+    }
+
+    // short result of operator+
+    {
+        immutable_string a("a");
+        immutable_string result = a + "+" + immutable_string("b");
+        EXPECT_TRUE(result._is_short());
+        EXPECT_STREQ(result.c_str(), "a+b");
+    }
+
+    // empty builder
+    {
+        immutable_string::builder b;
+        EXPECT_TRUE(b.empty());
+        auto result = b.str();
+        EXPECT_TRUE(result.empty());
+        EXPECT_TRUE(result._has_null_terminator());
+    }
+
+    // spilling the inline buffer keeps its contents
+    {
+        immutable_string::builder b(1);
+        b.append("0123456789");
+        b.append(std::string_view(LONG_STRING));
+        EXPECT_EQ(std::string(b.str().c_str()), std::string("0123456789") + LONG_STRING);
+    }
+
+    // shrink policies
+    {
+        immutable_string::builder b(4096);
+        b.append(std::string_view(LONG_STRING));
+
+        // mostly spare, so it gets copied
+        auto fitted = b.str();
+        EXPECT_TRUE(fitted._is_shared());
+        EXPECT_STREQ(fitted.c_str(), LONG_STRING);
+
+        auto kept = b.str(immutable_string::builder::shrink_policy::keep);
+        EXPECT_NE(kept.data(), fitted.data());
+        EXPECT_STREQ(kept.c_str(), LONG_STRING);
+
+        // same buffer
+        auto kept2 = b.str(immutable_string::builder::shrink_policy::keep);
+        EXPECT_EQ(kept.data(), kept2.data());
+    }
+
+    {
+        immutable_string::builder b(LONG_STRING_LEN);
+        b.append(std::string_view(LONG_STRING));
+
+        // no spare capacity, no copy unless forced
+        auto a = b.str();
+        auto c = b.str(immutable_string::builder::shrink_policy::keep);
+        EXPECT_EQ(a.data(), c.data());
+
+        auto d = b.str(immutable_string::builder::shrink_policy::fit);
+        EXPECT_NE(a.data(), d.data());
+        EXPECT_STREQ(d.c_str(), LONG_STRING);
+    }
+}
+
+TEST(immutable_string, builder_copy_on_write)
+{
+    immutable_string::builder b(4096);
+    b.append(std::string_view(LONG_STRING));
+
+    auto first = b.str(immutable_string::builder::shrink_policy::keep);
+    auto buffer = first.data();
+
+    // 'first' shares the buffer, so appending must not touch it
+    b.append("tail");
+    EXPECT_EQ(first.size(), LONG_STRING_LEN);
+    EXPECT_STREQ(first.c_str(), LONG_STRING);
+    EXPECT_EQ(first.data(), buffer);
+
+    auto second = b.str(immutable_string::builder::shrink_policy::keep);
+    EXPECT_NE(second.data(), buffer);
+    EXPECT_EQ(std::string(second.c_str()), std::string(LONG_STRING) + "tail");
+
+    // uniquely owned again, appends go in place
+    second = immutable_string();
+    auto before = b.str(immutable_string::builder::shrink_policy::keep).data();
+    b.append("!");
+    EXPECT_EQ(b.str(immutable_string::builder::shrink_policy::keep).data(), before);
+}
+
+TEST(immutable_string, with_appended)
+{
+    // lvalue, the source is left untouched
+    {
+        immutable_string a(LONG_STRING);
+        auto b = a.with_appended("!");
+        EXPECT_STREQ(a.c_str(), LONG_STRING);
+        EXPECT_EQ(std::string(b.c_str()), std::string(LONG_STRING) + "!");
+        EXPECT_NE(a.data(), b.data());
+    }
+
+    // short results stay in SSO
+    {
+        immutable_string a("abc");
+        auto b = std::move(a).with_appended(std::string_view("def"));
+        EXPECT_TRUE(b._is_short());
+        EXPECT_STREQ(b.c_str(), "abcdef");
+    }
+
+    // sole owner grows in place after the first reallocation
+    {
+        std::string expected(LONG_STRING);
+        immutable_string s(LONG_STRING);
+        s = std::move(s).with_appended("x");
+        expected += "x";
+
+        auto buffer = s.data();
+        size_t reallocations = 0;
+        for (int i = 0; i < 1000; ++i)
+        {
+            s = std::move(s).with_appended("0123456789");
+            expected += "0123456789";
+            if (s.data() != buffer)
+            {
+                ++reallocations;
+                buffer = s.data();
+            }
+        }
+
+        EXPECT_EQ(std::string(s.c_str()), expected);
+        EXPECT_LT(reallocations, 20u);
+    }
+
+    // shared buffers are never extended in place
+    {
+        immutable_string a(LONG_STRING);
+        a = std::move(a).with_appended("x"); // now has spare capacity
+        immutable_string copy(a);
+
+        auto b = std::move(a).with_appended("y");
+        EXPECT_NE(b.data(), copy.data());
+        EXPECT_EQ(std::string(copy.c_str()), std::string(LONG_STRING) + "x");
+        EXPECT_EQ(std::string(b.c_str()), std::string(LONG_STRING) + "xy");
+    }
+
+    // a substring that does not end where the buffer does
+    {
+        immutable_string a(LONG_STRING);
+        a = std::move(a).with_appended("x");
+        auto sub = a.substr(0, LONG_STRING_LEN - 1);
+        a = immutable_string();
+
+        auto b = std::move(sub).with_appended("!");
+        EXPECT_EQ(std::string(b.c_str()), std::string(LONG_STRING, LONG_STRING_LEN - 1) + "!");
+    }
+}
+
+namespace
+{
+
+// checks that every block goes back to the resource it came from, with the same size
+class counting_resource final
+    : public std::pmr::memory_resource
+{
+public:
+    ~counting_resource()
+    {
+        EXPECT_TRUE(blocks.empty());
+    }
+
+    std::map<void*, std::size_t> blocks;
+    std::size_t allocations = 0;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        auto p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        blocks[p] = bytes;
+        ++allocations;
+        return p;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        auto it = blocks.find(p);
+        EXPECT_NE(it, blocks.end());
+        if (it != blocks.end())
+        {
+            EXPECT_EQ(it->second, bytes);
+            blocks.erase(it);
+        }
+
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+} // namespace {}
+
+TEST(immutable_string, pmr)
+{
+    counting_resource resource;
+    {
+        std::pmr::polymorphic_allocator<char> a(&resource);
+
+        pmr::immutable_string s(LONG_STRING, LONG_STRING_LEN, a);
+        EXPECT_EQ(resource.allocations, 1u);
+        EXPECT_EQ(s.get_allocator().resource(), &resource);
+
+        // SSO allocates nothing
+        pmr::immutable_string small(SHORT_STRING, SHORT_STRING_LEN, a);
+        EXPECT_EQ(resource.allocations, 1u);
+
+        // copies and substrings share the buffer and release it through the same resource
+        pmr::immutable_string copy(s);
+        auto sub = s.substr(1);
+        s = pmr::immutable_string();
+        copy = pmr::immutable_string();
+        EXPECT_EQ(resource.blocks.size(), 1u);
+        EXPECT_EQ(sub.get_allocator().resource(), &resource);
+
+        // c_str() of a substring, operator+, builder and with_appended() keep to the resource too
+        EXPECT_STREQ(sub.c_str(), LONG_STRING + 1);
+        pmr::immutable_string joined = sub + "!";
+        auto grown = std::move(joined).with_appended(std::string_view(LONG_STRING));
+        EXPECT_EQ(grown.get_allocator().resource(), &resource);
+
+        pmr::immutable_string::builder b(16, a);
+        b.append(std::string_view(LONG_STRING)).append(std::string_view(LONG_STRING));
+        auto built = b.str();
+        EXPECT_EQ(built.get_allocator().resource(), &resource);
+
+        std::vector<pmr::immutable_string> batch;
+        std::string_view views[] = { LONG_STRING, SHORT_STRING, LONG_STRING_PART };
+        pmr::immutable_string::create_batch(views, std::back_inserter(batch), true, a);
+        EXPECT_EQ(batch[0].get_allocator().resource(), &resource);
+    }
+
+    EXPECT_TRUE(resource.blocks.empty());
+
+    // resources that pack allocations tightly still get the buffer header aligned
+    {
+        std::pmr::monotonic_buffer_resource mono(1024);
+        (void)mono.allocate(1, 1);
+
+        pmr::immutable_string s(LONG_STRING, LONG_STRING_LEN, std::pmr::polymorphic_allocator<char>(&mono));
+        auto copy = s;
+        EXPECT_TRUE(copy._is_shared());
+        EXPECT_STREQ(copy.c_str(), LONG_STRING);
+    }
+}
+
+TEST(immutable_string, builder_numbers_allocations)
+{
+    counting_resource resource;
+    std::pmr::polymorphic_allocator<char> a(&resource);
+
+    // short numbers do not spill the inline buffer
+    {
+        pmr::immutable_string::builder b(pmr::immutable_string::builder::DefaultReserve, a);
+        b.append(1.5);
+        EXPECT_STREQ(b.str().c_str(), "1.5");
+        EXPECT_EQ(resource.allocations, 0u);
+    }
+
+    {
+        pmr::immutable_string::builder b(pmr::immutable_string::builder::DefaultReserve, a);
+        b.append("took ").append(std::int64_t(42)).append("ms");
+        EXPECT_STREQ(b.str().c_str(), "took 42ms");
+        EXPECT_EQ(resource.allocations, 0u);
+    }
+
+    {
+        pmr::immutable_string::builder b(pmr::immutable_string::builder::DefaultReserve, a);
+        b.append(-1234567, 16).append(' ').append(0.25, std::chars_format::fixed, 3);
+        EXPECT_STREQ(b.str().c_str(), "-12d687 0.250");
+        EXPECT_EQ(resource.allocations, 0u);
+    }
+
+    // the inline buffer spills once the characters really don't fit
+    {
+        pmr::immutable_string::builder b(pmr::immutable_string::builder::DefaultReserve, a);
+        for (int i = 0; i < 10; ++i)
+            b.append(std::uint64_t(1234567890123456789ULL));
+        EXPECT_EQ(b.size(), 190u);
+        EXPECT_EQ(resource.allocations, 1u);
+    }
+}
+
+TEST(immutable_string, split)
+{
+    immutable_string str("first record\n\nsecond record that is long\nthird\n");
+
+    std::vector<immutable_string> parts;
+    str.split('\n', std::back_inserter(parts));
+    ASSERT_EQ(parts.size(), 3);
+    EXPECT_EQ(std::string_view(parts[0].data(), parts[0].size()), "first record");
+    EXPECT_EQ(std::string_view(parts[1].data(), parts[1].size()), "second record that is long");
+    EXPECT_EQ(std::string_view(parts[2].data(), parts[2].size()), "third");
+    EXPECT_EQ(parts[1].data(), str.data() + 14); // shares the buffer
+
+    parts.clear();
+    str.split('\n', std::back_inserter(parts), false);
+    ASSERT_EQ(parts.size(), 4);
+    EXPECT_TRUE(parts[1].empty());
+
+    // a range
+    parts.clear();
+    str.split(' ', std::back_inserter(parts), true, 14, 27);
+    ASSERT_EQ(parts.size(), 2);
+    EXPECT_EQ(std::string_view(parts[1].data(), parts[1].size()), "record");
+
+    // more substrings than a batch of references, all released properly
+    std::string many;
+    for (int i = 0; i < 1000; ++i)
+        many.append("word ");
+
+    parts.clear();
+    immutable_string(many).split(' ', std::back_inserter(parts));
+    EXPECT_EQ(parts.size(), 1000);
+
+    EXPECT_THROW(str.split('\n', std::back_inserter(parts), true, 100, 10), std::out_of_range);
+}
+
+TEST(immutable_string, starts_ends_with)
+{
+    // SSO strings of every length, checked against std::string_view
+    std::string const source = "0123456789abcdefghijklm";
+    for (std::size_t sz = 0; sz <= sizeof(immutable_string) - 2; ++sz)
+    {
+        std::string_view const sv(source.data(), sz);
+        immutable_string const str(sv);
+        for (std::size_t n = 0; n <= sz + 1 && n <= source.size(); ++n)
+        {
+            std::string_view const prefix(source.data(), n);
+            std::string_view const suffix(source.data() + (sz >= n ? sz - n : 0), n);
+            std::string_view const other("0123456789abcdefghijklX", n);
+            EXPECT_EQ(str.starts_with(prefix), sv.starts_with(prefix)) << sz << " " << n;
+            EXPECT_EQ(str.ends_with(suffix), sv.ends_with(suffix)) << sz << " " << n;
+            EXPECT_EQ(str.starts_with(other), sv.starts_with(other)) << sz << " " << n;
+            EXPECT_EQ(str.ends_with(other), sv.ends_with(other)) << sz << " " << n;
+        }
+    }
+
+    immutable_string const str("a string long enough not to fit into SSO");
+    EXPECT_TRUE(str.starts_with("a string"));
+    EXPECT_TRUE(str.starts_with('a'));
+    EXPECT_FALSE(str.starts_with("a strung"));
+    EXPECT_TRUE(str.ends_with(std::string_view("into SSO")));
+    EXPECT_TRUE(str.ends_with('O'));
+    EXPECT_FALSE(str.ends_with("into SS"));
+    EXPECT_TRUE(str.contains("enough"));
+    EXPECT_TRUE(str.contains('g'));
+    EXPECT_FALSE(str.contains("enuf"));
+    EXPECT_FALSE(immutable_string().starts_with('a'));
+    EXPECT_TRUE(immutable_string().ends_with(""));
+
+    immutable_u16string const wide(u"wide");
+    EXPECT_TRUE(wide.starts_with(u"wi"));
+    EXPECT_TRUE(wide.ends_with(u"ide"));
+    EXPECT_FALSE(wide.ends_with(u"wade"));
+}
+
+TEST(immutable_string, trim)
+{
+    immutable_string const clean("a string long enough not to fit into SSO");
+    EXPECT_EQ(clean.trim().data(), clean.data());
+    EXPECT_TRUE(clean.trim()._is_shared());
+
+    immutable_string const padded(" \t a string long enough not to fit into SSO \r\n");
+    auto const trimmed = padded.trim();
+    EXPECT_EQ(trimmed, clean);
+    EXPECT_EQ(trimmed.data(), padded.data() + 3);
+    EXPECT_EQ(padded.trim_left(), "a string long enough not to fit into SSO \r\n");
+    EXPECT_EQ(padded.trim_right(), " \t a string long enough not to fit into SSO");
+    EXPECT_FALSE(padded.trim_right()._has_null_terminator());
+    EXPECT_TRUE(padded.trim_left()._has_null_terminator());
+
+    EXPECT_TRUE(immutable_string(" \t\v\f\r\n ").trim().empty());
+    EXPECT_TRUE(immutable_string().trim().empty());
+    EXPECT_EQ(immutable_string(" x ").trim(), "x");
+    EXPECT_EQ(immutable_wstring(L"\t\x4e16 \x754c\n").trim(), L"\x4e16 \x754c");
+
+    // whitespace runs across 16-byte boundaries on both sides
+    for (std::size_t lead : { 0, 1, 15, 16, 17, 40 })
+    {
+        for (std::size_t trail : { 0, 1, 15, 16, 17, 40 })
+        {
+            std::string const s = std::string(lead, ' ') + "x\xa0y" + std::string(trail, '\n');
+            EXPECT_EQ(immutable_string(s).trim(), "x\xa0y") << lead << " " << trail;
+            EXPECT_EQ(immutable_u32string(std::u32string(lead, U'\t') + U"xy" + std::u32string(trail, U' ')).trim(), U"xy") << lead << " " << trail;
+        }
+    }
+}
+
+TEST(immutable_string, remove_prefix_suffix)
+{
+    immutable_string const str("key=a value long enough not to fit into SSO;");
+    auto const value = str.remove_prefix(4).remove_suffix(1);
+    EXPECT_EQ(value, "a value long enough not to fit into SSO");
+    EXPECT_EQ(value.data(), str.data() + 4);
+    EXPECT_EQ(str.remove_prefix(0).data(), str.data());
+    EXPECT_EQ(str.remove_suffix(0).data(), str.data());
+    EXPECT_TRUE(str.remove_suffix(str.size()).empty());
+    EXPECT_TRUE(str.remove_prefix(str.size()).empty());
+
+    EXPECT_THROW((void)str.remove_prefix(str.size() + 1), std::out_of_range);
+    EXPECT_THROW((void)str.remove_suffix(str.size() + 1), std::out_of_range);
+}
@@ -1,9 +1,13 @@
 #include "common.h"
+#include "benchmark.h"
 
-#include <immutable_string/string.hxx>
+#include <immutable_string/algorithm.hxx>
+#include <immutable_string/reader.hxx>
+#include <immutable_string/transcode.hxx>
 
 #include <atomic>
 #include <chrono>
+#include <cstdio>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -11,85 +15,6 @@
 #include <sstream>
 #include <vector>
 
-using namespace ims;
-
-const char SEPARATOR = '\n';
-const char* const SSEPARATOR = "\n";
-
-class allocator_base
-{
-public:
-    void* allocate(size_t size)
-    {
-        auto p = std::malloc(size);
-        if (!p)
-            throw std::bad_alloc();
-
-        ++_allocations;
-        _allocated_bytes += size;
-
-        if (_verbose)
-            std::cout << "a " << size << "\n";
-
-        return p;
-    }
-
-    void deallocate(void* p, size_t size)
-    {
-        std::free(p);
-
-        if (_verbose)
-            std::cout << "r " << size << "\n";
-    }
-
-    static uint64_t _allocations;
-    static uint64_t _allocated_bytes;
-    static bool _verbose;
-};
-
-uint64_t allocator_base::_allocations = 0;
-uint64_t allocator_base::_allocated_bytes = 0;
-bool allocator_base::_verbose = false;
-
-template <class _Ty>
-class BenchAllocator
-    : public allocator_base
-{
-public:
-    using value_type = _Ty;
-    using size_type = size_t;
-    using difference_type = ptrdiff_t;
-
-    constexpr BenchAllocator() noexcept {}
-
-    constexpr BenchAllocator(const BenchAllocator&) noexcept = default;
-    
-    template <class _Other>
-    constexpr BenchAllocator(const BenchAllocator<_Other>&) noexcept {}
-    
-    constexpr ~BenchAllocator() = default;
-    constexpr BenchAllocator& operator=(const BenchAllocator&) = default;
-
-    constexpr void deallocate(_Ty* const _Ptr, const size_t _Count) 
-    {
-        allocator_base::deallocate(_Ptr, sizeof(_Ty) * _Count);
-    }
-
-    constexpr _Ty* allocate(const size_t _Count) 
-    {
-        return static_cast<_Ty*>(allocator_base::allocate(sizeof(_Ty) * _Count));
-    }
-
-    friend constexpr bool operator==(const BenchAllocator& a, const BenchAllocator& b) noexcept
-    {
-        return true;
-    }
-};
-
-using StdString = std::basic_string<char, std::char_traits<char>, BenchAllocator<char>>;
-using RString = basic_immutable_string<char, std::char_traits<char>, BenchAllocator<char>>;
-using OStringStream = std::basic_ostringstream<char, std::char_traits<char>, BenchAllocator<char>>;
-
 static void generateWord(OStringStream& ss)
 {
     static const char ValidChars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
@@ -125,61 +50,6 @@ static StdString generate_data_set(unsigned long long words)
     return ss.str();
 }
 
-template <class StringT, class ContainerT>
-void split2(const StringT& source, ContainerT& receiver)
-{
-    size_t start = 0;
-
-    while (start < source.size())
-    {
-        const auto delim = source.find(SEPARATOR, start);
-        const auto end = (delim == StringT::npos) ? source.size() : delim;
-
-        if (start != end)
-        {
-            receiver.push_back(source.substr(start, end - start));
-        }
-        
-        if (delim == StringT::npos)
-            break;
-
-        start = delim + 1;
-    }
-}
-
-static std::string format_memsize(uint64_t bytes)
-{
-    std::ostringstream stream;
-    if (bytes < 1024 * 10)
-    {
-        stream << bytes << " bytes";
-    }
-    else
-    {
-        stream << std::fixed << std::setprecision(3);
-        double v = bytes / 1024.0;
-        if (v < 1024 * 10)
-        {
-            stream << v << " Kb";
-        }
-        else
-        {
-            v /= 1024.0;
-            if (v < 1024 * 10)
-            {
-                stream << v << " Mb";
-            }
-            else
-            {
-                v /= 1024.0;
-                stream << v << " Gb";
-            }
-        }
-    }
-
-    return stream.str();
-}
-
 template <typename StringT, typename SplitT, typename MergeT>
 void run_benchmark_split_merge(const StringT& source, uint64_t wc, SplitT splitter, MergeT merger, unsigned runs, bool silent)
 {
@@ -356,6 +226,198 @@ static void immutable_string_merger(const std::vector<RString, BenchAllocator<RS
         std::cout << "ERROR while splitting/merging immutable_string\n";
 }
 
+static void immutable_string_join_merger(const std::vector<RString, BenchAllocator<RString>>& v, const RString& source, bool silent)
+{
+    if (!silent)
+        std::cout << "Merging immutable_string with ims::join()...\n";
+
+    auto result = join(v, SEPARATOR);
+    if (result != source)
+        std::cout << "ERROR while splitting/merging immutable_string\n";
+}
+
+template <typename RunT>
+void run_benchmark_counted(RunT runner, unsigned runs, bool silent)
+{
+    uint64_t time = 0;
+    uint64_t mem = 0;
+    uint64_t allocs = 0;
+    uint64_t count = 0;
+
+    for (unsigned r = 0; r < runs; r++)
+    {
+        auto mem0 = allocator_base::_allocated_bytes;
+        auto allocs0 = allocator_base::_allocations;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        count = runner(silent);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        mem += allocator_base::_allocated_bytes - mem0;
+        allocs += allocator_base::_allocations - allocs0;
+        time += std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    }
+
+    if (!silent)
+    {
+        std::cout << "Records:    " << std::setw(10) << count << "\n";
+        std::cout << "Time (ms):  " << std::setw(10) << time / runs << "\n";
+        std::cout << "Allocations:" << std::setw(10) << allocs / runs << "\n";
+        std::cout << "Memory:     " << format_memsize(mem / runs) << "\n";
+        std::cout << "--------------------------------------------------------------\n";
+    }
+}
+
+static uint64_t immutable_string_file_loader(const std::string& file, bool silent)
+{
+    if (!silent)
+        std::cout << "Loading with std::ifstream and splitting immutable_string...\n";
+
+    std::ifstream f(file, std::ios_base::binary);
+    if (!f.is_open())
+        throw std::runtime_error(std::string("Failed to open ") + file);
+
+    OStringStream ss;
+    ss << f.rdbuf();
+    RString source(ss.str());
+
+    std::vector<RString, BenchAllocator<RString>> words;
+    split2(source, words);
+    return words.size();
+}
+
+template <bool ReadAhead>
+uint64_t immutable_string_stream_loader(const std::string& file, bool silent)
+{
+    if (!silent)
+        std::cout << "Streaming immutable_string with chunked_reader" << (ReadAhead ? " (read-ahead)" : "") << "...\n";
+
+    auto f = std::fopen(file.c_str(), "rb");
+    if (!f)
+        throw std::runtime_error(std::string("Failed to open ") + file);
+
+    std::vector<RString, BenchAllocator<RString>> words;
+    {
+        basic_chunked_reader<RString> reader(fileno(f), SEPARATOR, basic_chunked_reader<RString>::DefaultChunkSize, ReadAhead);
+        RString record;
+        while (reader.next(record))
+        {
+            if (!record.empty())
+                words.push_back(std::move(record));
+        }
+    }
+
+    std::fclose(f);
+    return words.size();
+}
+
+static uint64_t immutable_string_materializer(const std::vector<std::string_view>& views, bool silent)
+{
+    if (!silent)
+        std::cout << "Materializing immutable_string one by one...\n";
+
+    RStringVector strings;
+    strings.reserve(views.size());
+    for (auto& v : views)
+        strings.emplace_back(v);
+
+    return strings.size();
+}
+
+static uint64_t immutable_string_batch_materializer(const std::vector<std::string_view>& views, bool silent)
+{
+    if (!silent)
+        std::cout << "Materializing immutable_string with create_batch()...\n";
+
+    RStringVector strings;
+    strings.reserve(views.size());
+    RString::create_batch(views, std::back_inserter(strings));
+
+    return strings.size();
+}
+
+template <RString::builder::shrink_policy Policy>
+uint64_t immutable_string_builder_phrases(const RStringVector& words, bool silent)
+{
+    if (!silent)
+        std::cout << "Building 8-word phrases with builder::str(" << (Policy == RString::builder::shrink_policy::keep ? "keep" : "fit_if_wasteful") << ")...\n";
+
+    auto live0 = allocator_base::_live_bytes;
+
+    RStringVector phrases;
+    phrases.reserve(words.size() / 8 + 1);
+    for (size_t i = 0; i + 8 <= words.size(); i += 8)
+    {
+        RString::builder b;
+        for (size_t j = i; j < i + 8; ++j)
+            b.append(words[j]).append(' ');
+
+        phrases.push_back(b.str(Policy));
+    }
+
+    if (!silent)
+        std::cout << "Retained:   " << format_memsize(allocator_base::_live_bytes - live0) << "\n";
+
+    return phrases.size();
+}
+
+static uint64_t immutable_string_appender(const RStringVector& words, bool silent)
+{
+    if (!silent)
+        std::cout << "Appending words one by one with with_appended()...\n";
+
+    RString text;
+    for (auto& w : words)
+        text = std::move(text).with_appended(w).with_appended(SSEPARATOR);
+
+    return text.size();
+}
+
+using RU16String = basic_immutable_string<char16_t, std::char_traits<char16_t>, BenchAllocator<char16_t>>;
+using StdU16String = std::basic_string<char16_t, std::char_traits<char16_t>, BenchAllocator<char16_t>>;
+
+static uint64_t std_string_transcoder(const RString& source, bool silent)
+{
+    if (!silent)
+        std::cout << "Widening UTF-8 to UTF-16 with a scalar loop into std::u16string...\n";
+
+    // plain decoder, as good as it gets without lookup tables or SIMD
+    StdU16String result;
+    auto p = reinterpret_cast<const unsigned char*>(source.data());
+    auto end = p + source.size();
+    while (p < end)
+    {
+        char32_t cp = *p++;
+        if (cp >= 0x80)
+        {
+            auto length = (cp >= 0xf0) ? 3 : (cp >= 0xe0) ? 2 : 1;
+            cp &= (0x3f >> length);
+            while (length-- && p < end)
+                cp = (cp << 6) | (*p++ & 0x3f);
+        }
+
+        if (cp >= 0x10000)
+        {
+            result.push_back(char16_t(0xd800 + ((cp - 0x10000) >> 10)));
+            result.push_back(char16_t(0xdc00 + ((cp - 0x10000) & 0x3ff)));
+        }
+        else
+        {
+            result.push_back(char16_t(cp));
+        }
+    }
+
+    return result.size();
+}
+
+static uint64_t immutable_string_transcoder(const RString& source, bool silent)
+{
+    if (!silent)
+        std::cout << "Widening UTF-8 to UTF-16 with ims::transcode()...\n";
+
+    return transcode<RU16String>(source).size();
+}
+
 int generate_benchmark(const std::string& file, unsigned long long words)
 {
     try
@@ -426,6 +488,47 @@ int run_benchmark(const std::string& file, unsigned long long words, unsigned ru
         run_benchmark_split_merge(data_set, words, std_string_splitter, std_string_merger, runs, silent);
         run_benchmark_split_merge(data_set, words, std_string_splitter, std_string_stream_merger, runs, silent);
         run_benchmark_split_merge(source_immutable, words, immutable_string_splitter, immutable_string_merger, runs, silent);
+        run_benchmark_split_merge(source_immutable, words, immutable_string_splitter, immutable_string_join_merger, runs, silent);
+
+        RStringVector word_list;
+        word_list.reserve(words);
+        split2(source_immutable, word_list);
+
+        std::vector<std::string_view> views;
+        views.reserve(words);
+        split2(std::string_view(data_set.data(), data_set.size()), views);
+
+        run_benchmark_counted([&views](bool silent) { return immutable_string_materializer(views, silent); }, runs, silent);
+        run_benchmark_counted([&views](bool silent) { return immutable_string_batch_materializer(views, silent); }, runs, silent);
+
+        run_benchmark_counted([&word_list](bool silent) { return immutable_string_builder_phrases<RString::builder::shrink_policy::keep>(word_list, silent); }, runs, silent);
+        run_benchmark_counted([&word_list](bool silent) { return immutable_string_builder_phrases<RString::builder::shrink_policy::fit_if_wasteful>(word_list, silent); }, runs, silent);
+
+        run_benchmark_counted([&word_list](bool silent) { return immutable_string_appender(word_list, silent); }, runs, silent);
+
+        run_benchmark_counted([&source_immutable](bool silent) { return std_string_transcoder(source_immutable, silent); }, runs, silent);
+        run_benchmark_counted([&source_immutable](bool silent) { return immutable_string_transcoder(source_immutable, silent); }, runs, silent);
+
+        run_benchmark_parallel(source_immutable, runs, silent);
+        run_benchmark_concurrent_map(word_list, runs, silent);
+        run_benchmark_atomic_string(word_list, runs, silent);
+        run_benchmark_radix_tree(word_list, runs, silent);
+        run_benchmark_pmr(views, runs, silent);
+        run_benchmark_string_column(views, runs, silent);
+        run_benchmark_compact_string(views, runs, silent);
+        run_benchmark_static_map(views, runs, silent);
+        run_benchmark_escape(views, runs, silent);
+        run_benchmark_numeric(views.size(), runs, silent);
+        run_benchmark_line_index(source_immutable, runs, silent);
+        run_benchmark_batch(views, runs, silent);
+        run_benchmark_cold_string(source_immutable, runs, silent);
+
+        if (!file.empty())
+        {
+            run_benchmark_counted([&file](bool silent) { return immutable_string_file_loader(file, silent); }, runs, silent);
+            run_benchmark_counted([&file](bool silent) { return immutable_string_stream_loader<false>(file, silent); }, runs, silent);
+            run_benchmark_counted([&file](bool silent) { return immutable_string_stream_loader<true>(file, silent); }, runs, silent);
+        }
 
     }
     catch (std::exception& e)
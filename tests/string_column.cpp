@@ -0,0 +1,136 @@
+#include "common.h"
+
+#include <immutable_string/string_column.hxx>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace ims;
+
+namespace
+{
+
+std::vector<std::string> make_words(std::size_t count)
+{
+    std::vector<std::string> words;
+    for (std::size_t i = 0; i < count; ++i)
+        words.emplace_back(i % 7, char('a' + i % 26));
+
+    return words;
+}
+
+} // namespace {}
+
+
+TEST(string_column, basic)
+{
+    string_column col;
+    EXPECT_TRUE(col.empty());
+    EXPECT_EQ(col.begin(), col.end());
+    EXPECT_THROW(col.at(0), std::out_of_range);
+
+    auto const words = make_words(1000);
+    for (auto& w : words)
+        col.push_back(w);
+
+    col.push_back("tail");
+    ASSERT_EQ(col.size(), words.size() + 1);
+    EXPECT_EQ(col.view(words.size()), "tail");
+
+    for (std::size_t i = 0; i < words.size(); ++i)
+    {
+        EXPECT_EQ(col.view(i), words[i]);
+        EXPECT_EQ(col[i], words[i]);
+    }
+
+    // elements are substrings of one buffer
+    auto const e = col[999];
+    EXPECT_EQ(e.data(), col.view(999).data());
+    EXPECT_EQ(col.end() - col.begin(), std::ptrdiff_t(col.size()));
+    EXPECT_TRUE(std::equal(col.begin(), col.begin() + std::ptrdiff_t(words.size()), words.begin()));
+    EXPECT_EQ(col.begin()[1], words[1]);
+}
+
+TEST(string_column, append_keeps_handed_out_strings)
+{
+    string_column col(std::vector<std::string_view>{ "first string of some length", "second" });
+    auto const first = col[0];
+    auto const data = first.data();
+
+    // the buffer is shared now, so it gets copied rather than overwritten
+    col.append(make_words(100));
+    EXPECT_EQ(first, "first string of some length");
+    EXPECT_EQ(first.data(), data);
+    EXPECT_NE(col.chars().data(), data);
+    EXPECT_EQ(col.size(), 102u);
+    EXPECT_EQ(col.view(1), "second");
+}
+
+TEST(string_column, slice_and_concat)
+{
+    auto const words = make_words(300);
+    string_column const col(words);
+
+    auto const s = col.slice(100, 50);
+    ASSERT_EQ(s.size(), 50u);
+    EXPECT_EQ(s.view(0).data(), col.view(100).data()); // shares the buffer
+    for (std::size_t i = 0; i < s.size(); ++i)
+        EXPECT_EQ(s.view(i), words[100 + i]);
+
+    EXPECT_EQ(col.slice(290).size(), 10u);
+    EXPECT_TRUE(col.slice(300).empty());
+    EXPECT_THROW((void)col.slice(301), std::out_of_range);
+
+    // appending to a slice must not disturb the column it came from
+    auto s2 = s;
+    s2.push_back("extra");
+    EXPECT_EQ(s2.view(50), "extra");
+    EXPECT_EQ(col.view(150), words[150]);
+
+    auto const c = s + col.slice(0, 10);
+    ASSERT_EQ(c.size(), 60u);
+    EXPECT_EQ(c.view(49), words[149]);
+    EXPECT_EQ(c.view(50), words[0]);
+    EXPECT_EQ(c.view(59), words[9]);
+
+    auto d = col.slice(0, 10);
+    d.append(col.slice(10, 10));
+    ASSERT_EQ(d.size(), 20u);
+    for (std::size_t i = 0; i < d.size(); ++i)
+        EXPECT_EQ(d.view(i), words[i]);
+}
+
+TEST(string_column, offset_overflow)
+{
+    basic_string_column<immutable_string, std::uint8_t> col;
+    col.push_back(std::string(200, 'a'));
+    EXPECT_THROW(col.push_back(std::string(100, 'b')), std::length_error);
+    EXPECT_THROW(col.append(std::vector<std::string>{ "x", std::string(60, 'c') }), std::length_error);
+    EXPECT_EQ(col.size(), 1u);
+
+    col.push_back(std::string(55, 'b'));
+    EXPECT_EQ(col.view(1), std::string(55, 'b'));
+}
+
+TEST(string_column, memory_usage)
+{
+    string_column col;
+    auto const words = make_words(5000);
+    std::size_t chars = 0;
+    for (auto& w : words)
+    {
+        col.push_back(w);
+        chars += w.size();
+    }
+
+    // at least the characters plus an offset per element, the buffer's spare capacity included
+    auto const usage = col.memory_usage();
+    EXPECT_GE(usage, sizeof(col) + chars + col.size() * sizeof(std::uint32_t));
+    EXPECT_GT(usage, sizeof(col) + col.chars().size() + (col.size() + 1) * sizeof(std::uint32_t));
+
+    // a slice keeps the whole buffer alive
+    auto const part = col.slice(0, 10);
+    EXPECT_GE(part.memory_usage(), col.chars().size());
+}
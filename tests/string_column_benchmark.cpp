@@ -0,0 +1,72 @@
+#include "common.h"
+#include "benchmark.h"
+
+#include <immutable_string/string_column.hxx>
+
+#include <chrono>
+#include <functional>
+
+namespace
+{
+
+using RStringColumn = basic_string_column<RString>;
+
+// hashes every element, which touches all the characters
+template <class ContainerT>
+uint64_t scan(const ContainerT& strings)
+{
+    uint64_t total = 0;
+    for (auto&& s : strings)
+        total += std::hash<std::string_view>()(std::string_view(s.data(), s.size()));
+
+    return total;
+}
+
+template <class BuildT>
+void run(const char* title, const std::vector<std::string_view>& words, BuildT build, unsigned runs, bool silent)
+{
+    auto const live_before = allocator_base::_live_bytes;
+    auto const strings = build(words);
+    auto const live = allocator_base::_live_bytes - live_before + sizeof(strings);
+
+    uint64_t time = 0;
+    uint64_t result = 0;
+    for (unsigned r = 0; r < runs; r++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        result += scan(strings);
+        auto end = std::chrono::high_resolution_clock::now();
+        time += std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    }
+
+    if (!silent)
+    {
+        std::cout << title << "\n";
+        std::cout << "Memory:              " << std::setw(12) << format_memsize(live) << "\n";
+        std::cout << "Bytes per element:   " << std::setw(12) << std::fixed << std::setprecision(2) << double(live) / double(words.size()) << "\n";
+        std::cout << "Scan time (us):      " << std::setw(12) << time / runs << "\n";
+        std::cout << "Checksum:            " << std::setw(12) << (result & 0xffff) << "\n";
+        std::cout << "--------------------------------------------------------------\n";
+    }
+}
+
+} // namespace {}
+
+
+void run_benchmark_string_column(const std::vector<std::string_view>& words, unsigned runs, bool silent)
+{
+    run("Storing words in std::vector<immutable_string>...", words, [](const std::vector<std::string_view>& words)
+    {
+        RStringVector strings;
+        strings.reserve(words.size());
+        for (auto w : words)
+            strings.emplace_back(w.data(), w.size());
+
+        return strings;
+    }, runs, silent);
+
+    run("Storing words in ims::string_column...", words, [](const std::vector<std::string_view>& words)
+    {
+        return RStringColumn(words);
+    }, runs, silent);
+}
@@ -0,0 +1,84 @@
+#include "common.h"
+
+#include <immutable_string/transcode.hxx>
+
+#include <string>
+#include <string_view>
+
+using namespace ims;
+
+namespace
+{
+
+// every piece is non-ASCII in a different way: 2, 3 and 4-byte UTF-8, a surrogate pair in UTF-16
+const std::u8string_view Utf8 = u8"Grüße aus Köln, 日本語 \U0001F600 and some plain ASCII text to cover whole vectors";
+const std::u16string_view Utf16 = u"Grüße aus Köln, 日本語 \U0001F600 and some plain ASCII text to cover whole vectors";
+const std::u32string_view Utf32 = U"Grüße aus Köln, 日本語 \U0001F600 and some plain ASCII text to cover whole vectors";
+
+template <class StringT, class CharT>
+bool same(const StringT& s, std::basic_string_view<CharT> expected)
+{
+    return std::basic_string_view<CharT>(s.data(), s.size()) == expected;
+}
+
+} // namespace {}
+
+
+TEST(transcode, unicode)
+{
+    EXPECT_TRUE(same(transcode<immutable_u16string>(Utf8), Utf16));
+    EXPECT_TRUE(same(transcode<immutable_u32string>(Utf8), Utf32));
+    EXPECT_TRUE(same(transcode<immutable_u8string>(Utf16), Utf8));
+    EXPECT_TRUE(same(transcode<immutable_u32string>(Utf16), Utf32));
+    EXPECT_TRUE(same(transcode<immutable_u8string>(Utf32), Utf8));
+    EXPECT_TRUE(same(transcode<immutable_u16string>(Utf32), Utf16));
+
+    // char is UTF-8, wchar_t is UTF-16 or UTF-32 depending on its width
+    auto narrow = transcode<immutable_string>(immutable_u16string(Utf16));
+    EXPECT_EQ(narrow.size(), Utf8.size());
+    EXPECT_EQ(std::memcmp(narrow.data(), Utf8.data(), Utf8.size()), 0);
+
+    auto wide = transcode<immutable_wstring>(narrow);
+    EXPECT_TRUE(same(transcode<immutable_u32string>(wide), Utf32));
+    EXPECT_TRUE(wide._has_null_terminator());
+}
+
+TEST(transcode, ascii)
+{
+    // every length around the vector widths, non-ASCII characters at every position
+    std::u8string ascii;
+    for (size_t len = 0; len < 70; ++len)
+    {
+        EXPECT_TRUE(same(transcode<immutable_u16string>(ascii), std::u16string_view(std::u16string(ascii.begin(), ascii.end()))));
+        EXPECT_TRUE(same(transcode<immutable_u8string>(std::u32string(ascii.begin(), ascii.end())), std::u8string_view(ascii)));
+
+        auto mixed = ascii + u8"é" + ascii;
+        auto mixed32 = std::u32string(ascii.begin(), ascii.end()) + U"é" + std::u32string(ascii.begin(), ascii.end());
+        EXPECT_TRUE(same(transcode<immutable_u32string>(mixed), std::u32string_view(mixed32)));
+        EXPECT_TRUE(same(transcode<immutable_u8string>(mixed32), std::u8string_view(mixed)));
+
+        ascii.push_back(char8_t('a' + len % 26));
+    }
+
+    // short results go to SSO
+    auto s = transcode<immutable_u16string>(std::u8string_view(u8"short"));
+    EXPECT_TRUE(s._is_short());
+
+    // no conversion, no copy
+    immutable_u8string long_string(Utf8);
+    auto same_type = transcode<immutable_u8string>(long_string);
+    EXPECT_EQ(same_type.data(), long_string.data());
+}
+
+TEST(transcode, invalid)
+{
+    // truncated, overlong, encoded surrogate, out of range, stray continuation byte
+    for (std::string_view bad : { std::string_view("ab\xe6\x97"), std::string_view("\xc0\xaf"), std::string_view("\xed\xa0\x80"), std::string_view("\xf4\x90\x80\x80"), std::string_view("\x80") })
+        EXPECT_THROW((void)transcode<immutable_u16string>(bad), std::range_error);
+
+    // lone surrogates
+    EXPECT_THROW((void)transcode<immutable_u8string>(std::u16string_view(u"ab\xd800")), std::range_error);
+    EXPECT_THROW((void)transcode<immutable_u8string>(std::u16string(1, char16_t(0xdc00))), std::range_error);
+
+    EXPECT_THROW((void)transcode<immutable_u8string>(std::u32string(1, char32_t(0x110000))), std::range_error);
+}